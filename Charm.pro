@@ -7,6 +7,8 @@ QT += core gui xml sql network widgets qml quick
 INCLUDEPATH += Core/
 INCLUDEPATH += Charm/
 
+LIBS += -lz
+
 TARGET = AndCharm
 TEMPLATE = app
 RESOURCES = Charm/CharmResources.qrc Charm/QtQuick/qml.qrc
@@ -31,11 +33,12 @@ SOURCES += \
     Charm/Commands/CommandRelayCommand.cpp \
     Charm/Commands/CommandModifyEvent.cpp \
     Charm/Commands/CommandDeleteEvent.cpp \
-    Charm/Commands/CommandSetAllTasks.cpp \
+    Charm/Commands/CommandImportTasks.cpp \
     Charm/Commands/CommandAddTask.cpp \
     Charm/Commands/CommandModifyTask.cpp \
     Charm/Commands/CommandDeleteTask.cpp \
     Charm/Commands/CommandMakeEvent.cpp \
+    Charm/Commands/CommandBatchEvents.cpp \
     Charm/Commands/CommandExportToXml.cpp \
     Charm/Commands/CommandImportFromXml.cpp \
     Charm/Commands/CommandMakeAndActivateEvent.cpp \
@@ -135,10 +138,11 @@ HEADERS += \
     Charm/Commands/CommandDeleteTask.h \
     Charm/Commands/CommandModifyEvent.h \
     Charm/Commands/CommandMakeAndActivateEvent.h \
-    Charm/Commands/CommandSetAllTasks.h \
+    Charm/Commands/CommandImportTasks.h \
     Charm/Commands/CommandRelayCommand.h \
     Charm/Commands/CommandDeleteEvent.h \
     Charm/Commands/CommandMakeEvent.h \
+    Charm/Commands/CommandBatchEvents.h \
     Charm/ViewHelpers.h \
     Charm/ModelConnector.h \
     Charm/WeeklySummary.h \
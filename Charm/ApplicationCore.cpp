@@ -254,7 +254,7 @@ ApplicationCore::ApplicationCore(TaskId startupTask, bool hideAtStart, QObject *
             &m_timeTracker, &TimeTrackingWindow::slotCheckForUpdatesManual);
     m_actionEnterVacation.setText(tr("Enter Vacation..."));
     connect(&m_actionEnterVacation, &QAction::triggered,
-            &m_timeTracker, &TimeTrackingWindow::slotEnterVacation);
+            &m_eventView, &EventView::slotEnterVacation);
     m_actionActivityReport.setText(tr("Activity Report..."));
     m_actionActivityReport.setShortcut(Qt::CTRL + Qt::Key_A);
     connect(&m_actionActivityReport, &QAction::triggered,
@@ -247,9 +247,8 @@ void CharmCommandSession::handleCommand(QByteArray payload)
         if (segment.count() == 2) {
             tid = segment[1].toInt(&tid_ok);
         } else {
-            EventMap::const_reverse_iterator i = DATAMODEL->eventMap().rbegin();
-            tid_ok = (i != DATAMODEL->eventMap().rend());
-            tid = i->second.taskId();
+            tid_ok = DATAMODEL->eventCount() > 0;
+            tid = tid_ok ? DATAMODEL->eventForId(DATAMODEL->maximumEventId()).taskId() : 0;
         }
 
         if (tid_ok && DATAMODEL->taskExists(tid)) {
@@ -91,6 +91,10 @@ public: /* CharmDataModelAdapterInterface */
     {
     }
 
+    void eventsChanged(const EventChangeSet &)
+    {
+    }
+
     void eventActivated(EventId id);
     void eventDeactivated(EventId id);
 
@@ -0,0 +1,97 @@
+/*
+  CommandBatchEvents.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "CommandBatchEvents.h"
+#include "Core/Controller.h"
+
+CommandBatchEvents::CommandBatchEvents(const QString &description, QObject *parent)
+    : CharmCommand(description, parent)
+{
+}
+
+CommandBatchEvents::~CommandBatchEvents()
+{
+}
+
+void CommandBatchEvents::addEvents(const EventList &events)
+{
+    m_added += events;
+}
+
+void CommandBatchEvents::modifyEvent(const Event &event, const Event &oldEvent)
+{
+    Q_ASSERT(event.id() == oldEvent.id());
+    m_modified << event;
+    m_oldEvents << oldEvent;
+}
+
+void CommandBatchEvents::deleteEvents(const EventList &events)
+{
+    m_deleted += events;
+}
+
+bool CommandBatchEvents::prepare()
+{
+    return true;
+}
+
+bool CommandBatchEvents::execute(Controller *controller)
+{
+    return apply(controller, m_added, m_modified, m_deleted);
+}
+
+bool CommandBatchEvents::rollback(Controller *controller)
+{
+    return apply(controller, m_deleted, m_oldEvents, m_added);
+}
+
+bool CommandBatchEvents::finalize()
+{
+    return true;
+}
+
+void CommandBatchEvents::eventIdChanged(int oid, int nid)
+{
+    for (EventList *events : { &m_added, &m_modified, &m_oldEvents, &m_deleted }) {
+        for (Event &event : *events) {
+            if (event.id() == oid)
+                event.setId(nid);
+        }
+    }
+}
+
+bool CommandBatchEvents::apply(Controller *controller, EventList &added, const EventList &modified,
+                               const EventList &deleted)
+{
+    EventList events = added;
+    if (!controller->applyEventChanges(events, modified, deleted))
+        return false;
+
+    // the added events get new ids, also when they are recreated on undo and redo:
+    for (int i = 0; i < events.size(); ++i) {
+        const int oid = added.at(i).id();
+        const int nid = events.at(i).id();
+        if (oid != 0 && oid != nid)
+            emit emitSlotEventIdChanged(oid, nid);
+    }
+    added = events;
+    return true;
+}
@@ -0,0 +1,62 @@
+/*
+  CommandBatchEvents.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef COMMANDBATCHEVENTS_H
+#define COMMANDBATCHEVENTS_H
+
+#include <Core/Event.h>
+#include <Core/CharmCommand.h>
+
+class QObject;
+
+/** Adds, modifies and deletes a number of events in one transaction,
+ *  and undoes them as one step. */
+class CommandBatchEvents : public CharmCommand
+{
+    Q_OBJECT
+
+public:
+    explicit CommandBatchEvents(const QString &description, QObject *parent);
+    ~CommandBatchEvents() override;
+
+    void addEvents(const EventList &events);
+    void modifyEvent(const Event &event, const Event &oldEvent);
+    void deleteEvents(const EventList &events);
+
+    bool prepare() override;
+    bool execute(Controller *) override;
+    bool rollback(Controller *) override;
+    bool finalize() override;
+
+public Q_SLOTS:
+    void eventIdChanged(int, int) override;
+
+private:
+    bool apply(Controller *controller, EventList &added, const EventList &modified,
+               const EventList &deleted);
+
+    EventList m_added; // the created events, after execute()
+    EventList m_modified;
+    EventList m_oldEvents; // the modified events, as they were before
+    EventList m_deleted; // the deleted events, recreated after rollback()
+};
+
+#endif
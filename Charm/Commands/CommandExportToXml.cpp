@@ -24,12 +24,10 @@
 
 #include "CommandExportToXml.h"
 
-#include "Core/CharmExceptions.h"
 #include "Core/Controller.h"
 
-#include <QDomDocument>
 #include <QFile>
-#include <QTextStream>
+#include <QFileInfo>
 
 CommandExportToXml::CommandExportToXml(QString filename, QObject *parent)
     : CharmCommand(tr("Export to XML"), parent)
@@ -48,21 +46,19 @@ bool CommandExportToXml::prepare()
 
 bool CommandExportToXml::execute(Controller *controller)
 {
-    try {
-        QDomDocument document = controller->exportDatabasetoXml();
-        QFile file(m_filename);
-        if (file.open(QIODevice::WriteOnly)) {
-            QTextStream stream(&file);
-            stream << document.toString(4);
-        } else {
-            m_error = true;
-            m_errorString = tr("Could not open %1 for writing: %2").arg(m_filename,
-                                                                        file.errorString());
-        }
-    }  catch (const XmlSerializationException &e) {
+    QFile file(m_filename);
+    if (!file.open(QIODevice::WriteOnly)) {
         m_error = true;
-        m_errorString = e.what();
+        m_errorString = tr("Could not open %1 for writing: %2").arg(m_filename,
+                                                                    file.errorString());
+        return true;
     }
+
+    // file names ending in .gz get a compressed export:
+    const bool compressed = QFileInfo(m_filename).suffix().compare(QLatin1String("gz"),
+                                                                    Qt::CaseInsensitive) == 0;
+    m_errorString = controller->exportDatabasetoXml(&file, compressed);
+    m_error = !m_errorString.isEmpty();
     return true;
 }
 
@@ -25,8 +25,14 @@
 #include "CommandImportFromXml.h"
 #include "Core/Controller.h"
 
-#include <QDomDocument>
 #include <QFile>
+#include <QFileInfo>
+#include <QProgressDialog>
+#include <QWidget>
+
+namespace {
+const int ProgressSteps = 1000;
+}
 
 CommandImportFromXml::CommandImportFromXml(QString filename, QObject *parent)
     : CharmCommand(tr("Import from XML"), parent)
@@ -46,30 +52,29 @@ bool CommandImportFromXml::prepare()
 bool CommandImportFromXml::execute(Controller *controller)
 {
     QFile file(m_filename);
-    if (file.open(QIODevice::ReadOnly)) {
-        QDomDocument document;
-        QString errorMessage;
-        int errorLine = 0;
-        int errorColumn = 0;
-        if (document.setContent(&file, &errorMessage, &errorLine, &errorColumn)) {
-            m_error = controller->importDatabaseFromXml(document);
-        } else {
-            m_error = tr("Cannot read the XML syntax of the specified file: [%1:%2] %3").arg(QString::number(
-                                                                                                 errorLine),
-                                                                                             QString::number(
-                                                                                                 errorColumn),
-                                                                                             errorMessage);
-        }
-    } else {
+    if (!file.open(QIODevice::ReadOnly)) {
         m_error = tr("Cannot open the specified file: %1").arg(file.errorString());
+        return true;
     }
+
+    QProgressDialog progress(tr("Importing %1...").arg(QFileInfo(m_filename).fileName()),
+                             tr("Cancel"), 0, ProgressSteps, qobject_cast<QWidget *>(parent()));
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setMinimumDuration(500);
+    m_error = controller->importDatabaseFromXml(&file, [&progress](qint64 bytesRead, qint64 totalBytes) {
+        // a modal progress dialog processes events in setValue:
+        if (totalBytes > 0)
+            progress.setValue(static_cast<int>(bytesRead * ProgressSteps / totalBytes));
+        return !progress.wasCanceled();
+    });
+    m_canceled = progress.wasCanceled();
     return true;
 }
 
 bool CommandImportFromXml::finalize()
 {
     // any errors?
-    if (!m_error.isEmpty())
+    if (!m_error.isEmpty() && !m_canceled)
         showCritical(tr("Error importing the Database"),
                      tr("An error has occurred:\n%1").arg(m_error));
     return true;
@@ -42,6 +42,7 @@ public:
 private:
     QString m_error;
     QString m_filename;
+    bool m_canceled = false;
 };
 
 #endif
@@ -1,5 +1,5 @@
 /*
-  CommandSetAllTasks.cpp
+  CommandImportTasks.cpp
 
   This file is part of Charm, a task-based time tracking application.
 
@@ -22,31 +22,33 @@
   along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
-#include "CommandSetAllTasks.h"
+#include "CommandImportTasks.h"
 #include "Core/Controller.h"
 
-CommandSetAllTasks::CommandSetAllTasks(const TaskList &tasks, QObject *parent)
+CommandImportTasks::CommandImportTasks(const TaskList &added, const TaskList &modified,
+                                       QObject *parent)
     : CharmCommand(tr("Import Tasks"), parent)
-    , m_tasks(tasks)
+    , m_addedTasks(added)
+    , m_modifiedTasks(modified)
 {
 }
 
-CommandSetAllTasks::~CommandSetAllTasks()
+CommandImportTasks::~CommandImportTasks()
 {
 }
 
-bool CommandSetAllTasks::prepare()
+bool CommandImportTasks::prepare()
 {
     return true;
 }
 
-bool CommandSetAllTasks::execute(Controller *controller)
+bool CommandImportTasks::execute(Controller *controller)
 {
-    m_success = controller->setAllTasks(m_tasks);
+    m_success = controller->applyTaskChanges(m_addedTasks, m_modifiedTasks);
     return m_success;
 }
 
-bool CommandSetAllTasks::finalize()
+bool CommandImportTasks::finalize()
 {
     return m_success;
 }
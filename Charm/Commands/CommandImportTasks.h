@@ -1,5 +1,5 @@
 /*
-  CommandSetAllTasks.h
+  CommandImportTasks.h
 
   This file is part of Charm, a task-based time tracking application.
 
@@ -21,26 +21,29 @@
   along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
-#ifndef COMMANDSETALLTASKS_H
-#define COMMANDSETALLTASKS_H
+#ifndef COMMANDIMPORTTASKS_H
+#define COMMANDIMPORTTASKS_H
 
 #include <Core/Task.h>
 #include <Core/CharmCommand.h>
 
-class CommandSetAllTasks : public CharmCommand
+/** Applies the result of a task list merge: adds the new tasks and
+ *  updates the modified ones. */
+class CommandImportTasks : public CharmCommand
 {
     Q_OBJECT
 
 public:
-    explicit CommandSetAllTasks(const TaskList &, QObject *parent);
-    ~CommandSetAllTasks() override;
+    explicit CommandImportTasks(const TaskList &added, const TaskList &modified, QObject *parent);
+    ~CommandImportTasks() override;
 
     bool prepare() override;
     bool execute(Controller *) override;
     bool finalize() override;
 
 private:
-    TaskList m_tasks;
+    TaskList m_addedTasks;
+    TaskList m_modifiedTasks;
     bool m_success = false;
 };
 
@@ -28,6 +28,13 @@
 #include "Core/CharmCommand.h"
 #include "Core/CharmDataModel.h"
 
+#include <algorithm>
+
+namespace {
+// renumber the rows after this many removals:
+const int MaxRemovedRows = 64;
+}
+
 EventModelAdapter::EventModelAdapter(CharmDataModel *parent)
     : QAbstractListModel(parent)
     , m_dataModel(parent)
@@ -48,7 +55,7 @@ int EventModelAdapter::rowCount(const QModelIndex &) const
 
 QVariant EventModelAdapter::data(const QModelIndex &index, int role) const
 {
-    if (!index.isValid() || index.row() < 0 || index.row() > m_events.size())
+    if (!index.isValid() || index.row() < 0 || index.row() >= m_events.size())
         return QVariant(); // beware of stale persistent indexes
 
     switch (role) {
@@ -74,11 +81,8 @@ void EventModelAdapter::resetEvents()
 {
     beginResetModel();
 
-    m_events.clear();
-
-    for (EventMap::const_iterator it = m_dataModel->eventMap().begin();
-         it != m_dataModel->eventMap().end(); ++it)
-        m_events.append(it->first);
+    m_events = m_dataModel->eventIds().toVector();
+    renumberRows();
 
     endResetModel();
 }
@@ -91,6 +95,8 @@ void EventModelAdapter::eventAboutToBeAdded(EventId)
 
 void EventModelAdapter::eventAdded(EventId id)
 {
+    // in the numbering of m_rows, the removed rows are still there:
+    m_rows.insert(id, m_events.size() + m_removedRows.size());
     m_events.append(id);
     endInsertRows();
 }
@@ -98,27 +104,81 @@ void EventModelAdapter::eventAdded(EventId id)
 void EventModelAdapter::eventModified(EventId id, Event)
 {
     // nothing to do, except:
-    int row = m_events.indexOf(id);
+    int row = rowFor(id);
     Q_ASSERT(row != -1);   // inconsistency between model and adapter
     emit(dataChanged(index(row), index(row)));
 }
 
 void EventModelAdapter::eventAboutToBeDeleted(EventId id)
 {
-    int row = m_events.indexOf(id);
+    int row = rowFor(id);
     Q_ASSERT(row != -1);   // inconsistency between model and adapter
     beginRemoveRows(QModelIndex(), row, row);
 }
 
 void EventModelAdapter::eventDeleted(EventId id)
 {
-    int position = m_events.indexOf(id);
-    Q_ASSERT(position != -1);   // inconsistency between model and adapter
-    m_events.removeAt(position);
-    Q_ASSERT(m_events.indexOf(id) == -1);      // cannot be in there
+    const int numberedRow = m_rows.take(id);
+    const auto removed = std::lower_bound(m_removedRows.begin(), m_removedRows.end(), numberedRow);
+    const int position = numberedRow - (removed - m_removedRows.begin());
+    Q_ASSERT(position >= 0 && position < m_events.size()
+             && m_events.at(position) == id);   // inconsistency between model and adapter
+    m_events.remove(position);
+    m_removedRows.insert(removed, numberedRow);
+    if (m_removedRows.size() > MaxRemovedRows)
+        renumberRows();
     endRemoveRows();
 }
 
+void EventModelAdapter::eventsChanged(const EventChangeSet &changes)
+{
+    // one reset is cheaper for the views than many large changes:
+    if (changes.added.size() + changes.removed.size() > m_events.size() / 2) {
+        resetEvents();
+        return;
+    }
+
+    // remove contiguous runs of rows, from the end so that the rows before
+    // stay valid, and renumber once at the end:
+    const QVector<int> removedRows = rowsFor(changes.removed);
+    int last = removedRows.size() - 1;
+    while (last >= 0) {
+        int first = last;
+        while (first > 0 && removedRows.at(first - 1) == removedRows.at(first) - 1)
+            --first;
+        beginRemoveRows(QModelIndex(), removedRows.at(first), removedRows.at(last));
+        m_events.remove(removedRows.at(first), last - first + 1);
+        endRemoveRows();
+        last = first - 1;
+    }
+    if (!removedRows.isEmpty())
+        renumberRows();
+
+    EventIdList added;
+    Q_FOREACH (EventId id, changes.added) {
+        if (rowFor(id) == -1)
+            added.append(id);
+    }
+    if (!added.isEmpty()) {
+        const int position = m_events.size();
+        beginInsertRows(QModelIndex(), position, position + added.size() - 1);
+        Q_FOREACH (EventId id, added) {
+            m_rows.insert(id, m_events.size() + m_removedRows.size());
+            m_events.append(id);
+        }
+        endInsertRows();
+    }
+
+    const QVector<int> modifiedRows = rowsFor(changes.modified);
+    for (int first = 0; first < modifiedRows.size();) {
+        int last = first;
+        while (last + 1 < modifiedRows.size() && modifiedRows.at(last + 1) == modifiedRows.at(last) + 1)
+            ++last;
+        emit dataChanged(index(modifiedRows.at(first)), index(modifiedRows.at(last)));
+        first = last + 1;
+    }
+}
+
 void EventModelAdapter::eventActivated(EventId id)
 {
     emit eventActivationNotice(id);
@@ -134,21 +194,23 @@ void EventModelAdapter::commitCommand(CharmCommand *command)
     command->finalize();
 }
 
-const Event &EventModelAdapter::eventForIndex(const QModelIndex &index) const
+Event EventModelAdapter::eventForIndex(const QModelIndex &index) const
 {
-    if (index.row() >= 0 && index.row() < m_events.size()) {
-        EventId eventId = m_events.at(index.row());
-        const Event &event = m_dataModel->eventForId(eventId);
-        return event;
-    } else {
-        static Event InvalidEvent;
-        return InvalidEvent;
-    }
+    if (index.row() >= 0 && index.row() < m_events.size())
+        return m_dataModel->eventForId(m_events.at(index.row()));
+    return Event();
+}
+
+EventId EventModelAdapter::eventIdForRow(int row) const
+{
+    if (row >= 0 && row < m_events.size())
+        return m_events.at(row);
+    return EventId();
 }
 
 QModelIndex EventModelAdapter::indexForEvent(const Event &event) const
 {
-    int position = m_events.indexOf(event.id());
+    int position = rowFor(event.id());
 
     if (position >= 0 && position < m_events.size()) {
         return index(position);
@@ -156,3 +218,35 @@ QModelIndex EventModelAdapter::indexForEvent(const Event &event) const
         return QModelIndex();
     }
 }
+
+int EventModelAdapter::rowFor(EventId id) const
+{
+    const int numberedRow = m_rows.value(id, -1);
+    if (numberedRow == -1)
+        return -1;
+    // every removed row before it moved the row up by one:
+    const auto removed = std::lower_bound(m_removedRows.begin(), m_removedRows.end(), numberedRow);
+    return numberedRow - (removed - m_removedRows.begin());
+}
+
+QVector<int> EventModelAdapter::rowsFor(const EventIdList &ids) const
+{
+    QVector<int> rows;
+    rows.reserve(ids.size());
+    Q_FOREACH (EventId id, ids) {
+        const int row = rowFor(id);
+        if (row != -1)
+            rows.append(row);
+    }
+    std::sort(rows.begin(), rows.end());
+    return rows;
+}
+
+void EventModelAdapter::renumberRows()
+{
+    m_rows.clear();
+    m_rows.reserve(m_events.size());
+    for (int row = 0; row < m_events.size(); ++row)
+        m_rows.insert(m_events.at(row), row);
+    m_removedRows.clear();
+}
@@ -26,7 +26,9 @@
 #define EVENTMODELADAPTER_H
 
 #include <QAbstractItemModel>
+#include <QHash>
 #include <QPointer>
+#include <QVector>
 
 #include "Core/Event.h"
 #include "Core/EventModelInterface.h"
@@ -83,14 +85,20 @@ public:
     void eventModified(EventId id, Event) override;
     void eventAboutToBeDeleted(EventId id) override;
     void eventDeleted(EventId id) override;
+    void eventsChanged(const EventChangeSet &changes) override;
 
     void eventActivated(EventId id) override;
     void eventDeactivated(EventId id) override;
 
     // reimplement EventModelInterface:
-    const Event &eventForIndex(const QModelIndex &index) const override;
+    Event eventForIndex(const QModelIndex &index) const override;
     QModelIndex indexForEvent(const Event &) const override;
 
+    /** The id of the event in the row. Unlike eventForIndex(), this works
+        for rows that are about to be removed, after the event is already
+        gone from the data model. */
+    EventId eventIdForRow(int row) const;
+
     // reimplement CommandEmitterInterface:
     void commitCommand(CharmCommand *) override;
 
@@ -99,8 +107,19 @@ Q_SIGNALS:
     void eventDeactivationNotice(EventId id);
 
 private:
-    // if this is slow, we may want to store pointers here:
-    EventIdList m_events;
+    /** The row of the event, or -1 if it is not in the model. */
+    int rowFor(EventId id) const;
+    /** The sorted rows of the events that are in the model. */
+    QVector<int> rowsFor(const EventIdList &ids) const;
+    void renumberRows();
+
+    // the event of each row:
+    QVector<EventId> m_events;
+    // the row of each event, as numbered by the last renumberRows():
+    QHash<EventId, int> m_rows;
+    // the rows removed since then, sorted, in the same numbering. Renumbering
+    // after every removal would make deleting many events quadratic:
+    QVector<int> m_removedRows;
     QPointer<CharmDataModel> m_dataModel;
 };
 
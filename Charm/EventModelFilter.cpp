@@ -24,18 +24,38 @@
 
 #include "EventModelFilter.h"
 
+#include "Core/CharmDataModel.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+const qint64 SecondsPerDay = 24 * 60 * 60;
+}
+
 EventModelFilter::EventModelFilter(CharmDataModel *model, QObject *parent)
-    : QSortFilterProxyModel(parent)
+    : QAbstractListModel(parent)
+    , m_dataModel(model)
     , m_model(model)
 {
-    setSourceModel(&m_model);
-    setDynamicSortFilter(true);
-    sort(0, Qt::AscendingOrder);
+    connect(&m_model, &QAbstractItemModel::rowsInserted,
+            this, &EventModelFilter::sourceRowsInserted);
+    connect(&m_model, &QAbstractItemModel::rowsAboutToBeRemoved,
+            this, &EventModelFilter::sourceRowsAboutToBeRemoved);
+    connect(&m_model, &QAbstractItemModel::dataChanged,
+            this, &EventModelFilter::sourceDataChanged);
+    connect(&m_model, &QAbstractItemModel::modelAboutToBeReset,
+            this, &EventModelFilter::beginResetModel);
+    connect(&m_model, &QAbstractItemModel::modelReset,
+            this, &EventModelFilter::sourceModelReset);
 
     connect(&m_model, SIGNAL(eventActivationNotice(EventId)),
             SIGNAL(eventActivationNotice(EventId)));
     connect(&m_model, SIGNAL(eventDeactivationNotice(EventId)),
             SIGNAL(eventDeactivationNotice(EventId)));
+
+    findLongestEvent();
+    fillRows();
 }
 
 EventModelFilter::~EventModelFilter()
@@ -47,38 +67,94 @@ void EventModelFilter::commitCommand(CharmCommand *command)
     m_model.commitCommand(command);
 }
 
-bool EventModelFilter::lessThan(const QModelIndex &left, const QModelIndex &right) const
+int EventModelFilter::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_rows.size();
+}
+
+QVariant EventModelFilter::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() < 0 || index.row() >= m_rows.size())
+        return QVariant();
+    const Event event = m_dataModel->eventForId(m_rows.at(index.row()).second);
+    return m_model.data(m_model.indexForEvent(event), role);
+}
+
+Event EventModelFilter::eventForIndex(const QModelIndex &index) const
 {
-    if (left.column() == 0 && right.column() == 0) {
-        const Event &leftEvent = m_model.eventForIndex(left);
-        const Event &rightEvent = m_model.eventForIndex(right);
-        // date comparison in UTC is much faster and just as correct
-        return leftEvent.startDateTime(Qt::UTC) < rightEvent.startDateTime(Qt::UTC);
+    if (index.isValid() && index.row() >= 0 && index.row() < m_rows.size())
+        return m_dataModel->eventForId(m_rows.at(index.row()).second);
+    return Event();
+}
+
+QModelIndex EventModelFilter::indexForEvent(const Event &event) const
+{
+    const auto it = m_shownEvents.constFind(event.id());
+    if (it == m_shownEvents.constEnd())
+        return QModelIndex();
+    return index(rowFor(it->key));
+}
+
+void EventModelFilter::setFilterStartDate(const QDate &date)
+{
+    if (m_start == date)
+        return;
+    m_start = date;
+    if (m_start.isValid()) {
+        // load as far back as fillRows() looks; the events loaded may be
+        // longer than the ones known so far, then look further back:
+        int days;
+        do {
+            days = lookbackDays();
+            m_dataModel->ensureEventsLoadedSince(m_start.addDays(-days));
+        } while (lookbackDays() > days);
     } else {
-        return QSortFilterProxyModel::lessThan(left, right);
+        m_dataModel->ensureAllEventsLoaded();
     }
+    resetRows();
 }
 
-const Event &EventModelFilter::eventForIndex(const QModelIndex &index) const
+void EventModelFilter::setFilterEndDate(const QDate &date)
 {
-    return m_model.eventForIndex(mapToSource(index));
+    if (m_end == date)
+        return;
+    m_end = date;
+    resetRows();
 }
 
-QModelIndex EventModelFilter::indexForEvent(const Event &event) const
+void EventModelFilter::setFilterTaskId(TaskId id)
 {
-    const QModelIndex &sourceIndex = m_model.indexForEvent(event);
-    const QModelIndex &proxyIndex(mapFromSource(sourceIndex));
-    // bool valid = proxyIndex.isValid();
-    return proxyIndex;
+    if (m_filterId == id)
+        return;
+    m_filterId = id;
+    resetRows();
 }
 
-bool EventModelFilter::filterAcceptsRow(int srow, const QModelIndex &sparent) const
+int EventModelFilter::totalDuration() const
 {
-    if (QSortFilterProxyModel::filterAcceptsRow(srow, sparent) == false)
-        return false;
+    return m_totalDuration;
+}
 
-    const Event &event = m_model.eventForIndex(m_model.index(srow, 0, sparent));
+QList<Event> EventModelFilter::events() const
+{
+    QList<Event> events;
+    events.reserve(m_rows.size());
+    Q_FOREACH (const Key &key, m_rows)
+        events << m_dataModel->eventForId(key.second);
+    return events;
+}
 
+EventModelFilter::Key EventModelFilter::keyFor(const Event &event)
+{
+    Key key;
+    // events without a start time go first:
+    if (!EventStartIndex::keyFor(event, &key))
+        key = Key(std::numeric_limits<qint64>::min(), event.id());
+    return key;
+}
+
+bool EventModelFilter::accepts(const Event &event) const
+{
     if (m_filterId != TaskId() && event.taskId() != m_filterId)
         return false;
 
@@ -86,6 +162,9 @@ bool EventModelFilter::filterAcceptsRow(int srow, const QModelIndex &sparent) co
     /*
     * event.endDateTime().date() < m_start
     * Show also Events that end within the time span.
+    * Only events that start at most lookbackDays() before the time span
+    * are loaded and looked at, see setFilterStartDate(); an event that is
+    * longer than all loaded events, and starts before them, is not shown.
     */
     if (m_start.isValid() && (startDate < m_start) && (event.endDateTime().date() < m_start))
         return false;
@@ -96,48 +175,168 @@ bool EventModelFilter::filterAcceptsRow(int srow, const QModelIndex &sparent) co
     return true;
 }
 
-void EventModelFilter::setFilterStartDate(const QDate &date)
+int EventModelFilter::rowFor(const Key &key) const
 {
-    if (m_start == date)
-        return;
-    m_start = date;
-    invalidateFilter();
+    const auto it = std::lower_bound(m_rows.begin(), m_rows.end(), key);
+    if (it == m_rows.end() || *it != key)
+        return -1;
+    return it - m_rows.begin();
 }
 
-void EventModelFilter::setFilterEndDate(const QDate &date)
+void EventModelFilter::resetRows()
 {
-    if (m_end == date)
-        return;
-    m_end = date;
-    invalidateFilter();
+    beginResetModel();
+    fillRows();
+    endResetModel();
 }
 
-void EventModelFilter::setFilterTaskId(TaskId id)
+void EventModelFilter::fillRows()
 {
-    if (m_filterId == id)
-        return;
-    m_filterId = id;
-    invalidateFilter();
+    m_rows.clear();
+    m_shownEvents.clear();
+    m_totalDuration = 0;
+
+    const auto add = [this](const Event &event) {
+        const Key key = keyFor(event);
+        m_rows.append(key);
+        m_shownEvents.insert(event.id(), { key, event.duration() });
+        m_totalDuration += event.duration();
+    };
+
+    if (m_start.isValid() && m_end.isValid()) {
+        // look at the events that start early enough to end in the time
+        // frame, in the order of the index (one more day for DST changes):
+        const EventIdRange range
+            = m_dataModel->eventIdsThatStartInTimeFrame(m_start.addDays(-lookbackDays()), m_end);
+        for (EventId id : range) {
+            const Event event = m_dataModel->eventForId(id);
+            if (accepts(event))
+                add(event);
+        }
+    } else {
+        EventList events;
+        Q_FOREACH (EventId id, m_dataModel->eventIds()) {
+            const Event event = m_dataModel->eventForId(id);
+            if (accepts(event))
+                events << event;
+        }
+        std::sort(events.begin(), events.end(), [](const Event &left, const Event &right) {
+            return keyFor(left) < keyFor(right);
+        });
+        Q_FOREACH (const Event &event, events)
+            add(event);
+    }
 }
 
-int EventModelFilter::totalDuration() const
+int EventModelFilter::lookbackDays() const
+{
+    return m_longestEvent / SecondsPerDay + 2;
+}
+
+void EventModelFilter::findLongestEvent()
 {
-    int total = 0;
-    for (int i = 0; i < rowCount(); ++i) {
-        QModelIndex current = index(i, 0, QModelIndex());
-        const Event &event = eventForIndex(current);
-        total += event.duration();
+    m_longestEvent = 0;
+    Q_FOREACH (EventId id, m_dataModel->eventIds())
+        updateLongestEvent(m_dataModel->eventForId(id));
+}
+
+void EventModelFilter::updateLongestEvent(const Event &event)
+{
+    m_longestEvent = qMax<qint64>(m_longestEvent, event.duration());
+}
+
+void EventModelFilter::insertEvent(const Event &event)
+{
+    const Key key = keyFor(event);
+    const int row = std::lower_bound(m_rows.begin(), m_rows.end(), key) - m_rows.begin();
+    beginInsertRows(QModelIndex(), row, row);
+    m_rows.insert(row, key);
+    m_shownEvents.insert(event.id(), { key, event.duration() });
+    m_totalDuration += event.duration();
+    endInsertRows();
+}
+
+void EventModelFilter::removeEvent(EventId id)
+{
+    const ShownEvent shown = m_shownEvents.value(id);
+    const int row = rowFor(shown.key);
+    Q_ASSERT(row != -1);   // inconsistency between the rows and the shown events
+    beginRemoveRows(QModelIndex(), row, row);
+    m_rows.remove(row);
+    m_shownEvents.remove(id);
+    m_totalDuration -= shown.duration;
+    endRemoveRows();
+}
+
+void EventModelFilter::updateEvent(const Event &event)
+{
+    ShownEvent &shown = m_shownEvents[event.id()];
+    m_totalDuration += event.duration() - shown.duration;
+    shown.duration = event.duration();
+
+    const Key key = keyFor(event);
+    int row = rowFor(shown.key);
+    Q_ASSERT(row != -1);   // inconsistency between the rows and the shown events
+    if (key != shown.key) {
+        // the start time changed, move the row to its new place:
+        const auto begin = m_rows.begin();
+        const int newRow = key < shown.key
+                           ? std::lower_bound(begin, begin + row, key) - begin
+                           : std::lower_bound(begin + row + 1, m_rows.end(), key) - begin - 1;
+        if (newRow != row) {
+            beginMoveRows(QModelIndex(), row, row, QModelIndex(), newRow > row ? newRow + 1 : newRow);
+            m_rows.remove(row);
+            m_rows.insert(newRow, key);
+            endMoveRows();
+        } else {
+            m_rows[row] = key;
+        }
+        shown.key = key;
+        row = newRow;
     }
-    return total;
+    emit dataChanged(index(row), index(row));
 }
 
-QList<Event> EventModelFilter::events() const
+void EventModelFilter::sourceRowsInserted(const QModelIndex &, int first, int last)
 {
-    QList<Event> events;
-    for (int i = 0; i < rowCount(); ++i) {
-        QModelIndex hit = index(i, 0, QModelIndex());
-        const Event &event = eventForIndex(hit);
-        events << event;
+    for (int row = first; row <= last; ++row) {
+        const Event event = m_model.eventForIndex(m_model.index(row));
+        updateLongestEvent(event);
+        if (accepts(event))
+            insertEvent(event);
     }
-    return events;
+}
+
+void EventModelFilter::sourceRowsAboutToBeRemoved(const QModelIndex &, int first, int last)
+{
+    // after bulk updates, the events are already gone from the data model:
+    for (int row = first; row <= last; ++row) {
+        const EventId id = m_model.eventIdForRow(row);
+        if (m_shownEvents.contains(id))
+            removeEvent(id);
+    }
+}
+
+void EventModelFilter::sourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+    for (int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+        const Event event = m_model.eventForIndex(m_model.index(row));
+        updateLongestEvent(event);
+        const bool shown = m_shownEvents.contains(event.id());
+        const bool accepted = accepts(event);
+        if (shown && accepted) {
+            updateEvent(event);
+        } else if (shown) {
+            removeEvent(event.id());
+        } else if (accepted) {
+            insertEvent(event);
+        }
+    }
+}
+
+void EventModelFilter::sourceModelReset()
+{
+    findLongestEvent();
+    fillRows();
+    endResetModel();
 }
@@ -25,17 +25,28 @@
 #ifndef EVENTMODELFILTER_H
 #define EVENTMODELFILTER_H
 
+#include <QAbstractListModel>
 #include <QDate>
-#include <QSortFilterProxyModel>
+#include <QHash>
+#include <QVector>
 
 #include <Core/EventModelInterface.h>
+#include <Core/EventStartIndex.h>
 #include <Core/CommandEmitterInterface.h>
 
 #include "EventModelAdapter.h"
 
 class CharmDataModel;
 
-class EventModelFilter : public QSortFilterProxyModel, public CommandEmitterInterface,
+/** EventModelFilter shows the events of a time frame, and optionally
+    only those of one task, ordered by their start time.
+    The shown events are kept in a vector sorted by start time. It is
+    filled from the start time index of the data model when the time
+    frame changes, and updated from the changes of the event model
+    adapter afterwards. The total duration of the shown events is
+    updated along with them.
+*/
+class EventModelFilter : public QAbstractListModel, public CommandEmitterInterface,
     public EventModelInterface
 {
     Q_OBJECT
@@ -47,12 +58,13 @@ public:
     /** Returns the total number of seconds of all events in the model. */
     int totalDuration() const;
 
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
     // implement EventModelInterface:
-    const Event &eventForIndex(const QModelIndex &) const override;
+    Event eventForIndex(const QModelIndex &) const override;
     QModelIndex indexForEvent(const Event &) const override;
 
-    bool filterAcceptsRow(int srow, const QModelIndex &sparent) const override;
-
     void setFilterStartDate(const QDate &date);
     void setFilterEndDate(const QDate &date);
     void setFilterTaskId(TaskId id);
@@ -60,9 +72,6 @@ public:
     // implement CommandEmitterInterface:
     void commitCommand(CharmCommand *) override;
 
-    // implement to sort by event start datetime
-    bool lessThan(const QModelIndex &left, const QModelIndex &right) const override;
-
     QList<Event> events() const;
 
 Q_SIGNALS:
@@ -70,10 +79,43 @@ Q_SIGNALS:
     void eventDeactivationNotice(EventId id);
 
 private:
+    typedef EventStartIndex::Key Key;
+    struct ShownEvent {
+        Key key;
+        int duration;
+    };
+
+    static Key keyFor(const Event &event);
+    bool accepts(const Event &event) const;
+    int rowFor(const Key &key) const;
+    void resetRows();
+    void fillRows();
+    /** How many days before the time frame an event may start and still end in it. */
+    int lookbackDays() const;
+    void findLongestEvent();
+    void updateLongestEvent(const Event &event);
+
+    void insertEvent(const Event &event);
+    void removeEvent(EventId id);
+    void updateEvent(const Event &event);
+
+    void sourceRowsInserted(const QModelIndex &parent, int first, int last);
+    void sourceRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last);
+    void sourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+    void sourceModelReset();
+
+    CharmDataModel *m_dataModel;
     EventModelAdapter m_model;
     QDate m_start;
     QDate m_end;
     TaskId m_filterId = {};
+    // the keys of the shown events, ordered by start time:
+    QVector<Key> m_rows;
+    QHash<EventId, ShownEvent> m_shownEvents;
+    int m_totalDuration = 0;
+    // events may start before the time frame and end in it; no event
+    // lasts longer than this, it is only reset with the events:
+    qint64 m_longestEvent = 0;
 };
 
 #endif
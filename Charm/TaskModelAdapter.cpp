@@ -59,19 +59,18 @@ int TaskModelAdapter::rowCount(const QModelIndex &parent) const
 {
     if (parent.column() > 0) return 0;
 
-    const TaskTreeItem *item = itemFor(parent);
+    const TaskTreeItem item = itemFor(parent);
     // every index has an item, the invalid index
     // has the root item
-    Q_ASSERT(item);
-    return item->childCount();
+    return item.childCount();
 }
 
 QVariant TaskModelAdapter::data(const QModelIndex &index, int role) const
 {
     if (!index.isValid()) return QVariant();
 
-    const TaskTreeItem *item = itemFor(index);
-    const TaskId id = item->task().id();
+    const TaskTreeItem item = itemFor(index);
+    const TaskId id = item.task().id();
     const Event &activeEvent = m_dataModel->activeEventFor(id);
     const bool isActive = activeEvent.isValid();
     const QApplication *application = static_cast<QApplication *>(QApplication::instance());
@@ -81,14 +80,14 @@ QVariant TaskModelAdapter::data(const QModelIndex &index, int role) const
     switch (role) {
     // problem: foreground role is never queried for
     case Qt::ForegroundRole:
-        if (item->task().isCurrentlyValid()) {
+        if (item.task().isCurrentlyValid()) {
             return application->palette().color(QPalette::Active, QPalette::Text);
         } else {
             return application->palette().color(QPalette::Disabled, QPalette::Text);
         }
         break;
     case Qt::BackgroundRole:
-        if (item->task().isCurrentlyValid()) {
+        if (item.task().isCurrentlyValid()) {
             return QVariant();
         } else {
             QColor color("crimson");
@@ -97,7 +96,7 @@ QVariant TaskModelAdapter::data(const QModelIndex &index, int role) const
         }
         break;
     case Qt::DisplayRole:
-        return DATAMODEL->taskIdAndNameString(item->task().id());
+        return m_dataModel->taskIdAndNameString(item.task().id());
     case Qt::DecorationRole:
         if (isActive) {
             return Data::activePixmap();
@@ -106,16 +105,16 @@ QVariant TaskModelAdapter::data(const QModelIndex &index, int role) const
         }
         break;
     case Qt::CheckStateRole:
-        if (item->task().subscribed()) {
+        if (item.task().subscribed()) {
             return Qt::Checked;
         } else {
             return Qt::Unchecked;
         }
         break;
     case TasksViewRole_TaskDescription:
-        return item->task().comment();
+        return item.task().comment();
     case TasksViewRole_Name: // now unused
-        return item->task().name();
+        return item.task().name();
     case TasksViewRole_RunningTime:
         return hoursAndMinutes(activeEvent.duration());
     case TasksViewRole_TaskId:
@@ -124,7 +123,7 @@ QVariant TaskModelAdapter::data(const QModelIndex &index, int role) const
     case TasksViewRole_UserComment:
         return activeEvent.comment();
     case TasksViewRole_Filter:
-        return DATAMODEL->taskIdAndFullNameString(item->task().id());
+        return m_dataModel->taskIdAndFullNameString(item.task().id());
     default:
         return QVariant();
     }
@@ -135,14 +134,13 @@ QModelIndex TaskModelAdapter::index(int row, int column, const QModelIndex &pare
     if (row < 0 || column < 0 || column >= Column_TaskColumnCount)
         return QModelIndex();
 
-    const TaskTreeItem *parentItem = itemFor(parent);
-    Q_ASSERT(parentItem != 0);
+    const TaskTreeItem parentItem = itemFor(parent);
 
     // more sanity checks:
-    if (row >= parentItem->childCount())
+    if (row >= parentItem.childCount())
         return QModelIndex();
 
-    const TaskTreeItem &item = parentItem->child(row);
+    const TaskTreeItem item = parentItem.child(row);
 
     if (item.isValid()) {
         return indexForTaskTreeItem(item, column);
@@ -155,8 +153,7 @@ QModelIndex TaskModelAdapter::parent(const QModelIndex &index) const
 {
     if (!index.isValid()) return QModelIndex();
 
-    const TaskTreeItem *item = itemFor(index);
-    const TaskTreeItem &parent = m_dataModel->parentItem(item->task());
+    const TaskTreeItem parent = itemFor(index).parent();
     if (!parent.isValid())
         return QModelIndex(); // top level item
 
@@ -168,11 +165,11 @@ Qt::ItemFlags TaskModelAdapter::flags(const QModelIndex &index) const
     Qt::ItemFlags flags = 0;
 
     if (index.isValid()) {
-        const TaskTreeItem *item = itemFor(index);
+        const TaskTreeItem item = itemFor(index);
         flags = Qt::ItemIsUserCheckable|Qt::ItemIsSelectable|Qt::ItemIsEnabled;
-        const bool isCurrent = item->task().isCurrentlyValid();
+        const bool isCurrent = item.task().isCurrentlyValid();
         if (isCurrent) {
-            const TaskId id = item->task().id();
+            const TaskId id = item.task().id();
             const Event &activeEvent = m_dataModel->activeEventFor(id);
             const bool isActive = activeEvent.isValid();
             if (isActive)
@@ -188,9 +185,8 @@ bool TaskModelAdapter::setData(const QModelIndex &index, const QVariant &value,
     if (!index.isValid())
         return false;
 
-    const TaskTreeItem *item = itemFor(index);
-    Q_ASSERT(item != 0);
-    Task task(item->task());   // make a copy, so that we can modify it
+    const TaskTreeItem item = itemFor(index);
+    Task task(item.task());   // make a copy, so that we can modify it
 
     if (role == Qt::EditRole) {
         Q_ASSERT(m_dataModel->isTaskActive(task.id()));
@@ -257,8 +253,8 @@ void TaskModelAdapter::taskModified(TaskId id)
 
 void TaskModelAdapter::taskAboutToBeDeleted(TaskId id)
 {
-    const TaskTreeItem &item = m_dataModel->taskTreeItem(id);
-    const TaskTreeItem &parent = m_dataModel->parentItem(item.task());
+    const TaskTreeItem item = m_dataModel->taskTreeItem(id);
+    const TaskTreeItem parent = item.parent();
     int row = item.row();
     Q_ASSERT(row != -1);
 
@@ -298,6 +294,12 @@ void TaskModelAdapter::eventDeleted(EventId id)
     eventAdded(id);
 }
 
+void TaskModelAdapter::eventsChanged(const EventChangeSet &changes)
+{
+    Q_FOREACH (TaskId task, changes.tasks)
+        taskModified(task);
+}
+
 void TaskModelAdapter::eventActivated(EventId id)
 {
     // query the model to find out the task:
@@ -318,23 +320,19 @@ void TaskModelAdapter::eventDeactivated(EventId id)
     }
 }
 
-const TaskTreeItem *TaskModelAdapter::itemFor(const QModelIndex &index) const
+TaskTreeItem TaskModelAdapter::itemFor(const QModelIndex &index) const
 {
     if (index.isValid()) {
-        return static_cast<TaskTreeItem *>(index.internalPointer());
+        return m_dataModel->taskTree().itemAt(static_cast<int>(index.internalId()));
     } else {
-        return &m_dataModel->taskTreeItem(0);
+        return m_dataModel->taskTreeItem(0);
     }
 }
 
 QModelIndex TaskModelAdapter::indexForTaskTreeItem(const TaskTreeItem &item, int column) const
 {
     if (item.isValid()) {
-        // argl UUUUGGGLLYYYY
-        // DF: how about reinterpret_cast<void*>(&item) ?
-        const void *constVoidPointer = static_cast<const void *>(&item);
-        void *voidPointer = const_cast<void *>(constVoidPointer);
-        return createIndex(item.row(), column, voidPointer);
+        return createIndex(item.row(), column, static_cast<quintptr>(item.node()));
     } else {
         return QModelIndex();
     }
@@ -347,8 +345,8 @@ QModelIndex TaskModelAdapter::indexForTaskId(TaskId id) const
 
 Task TaskModelAdapter::taskForIndex(const QModelIndex &index) const
 {
-    const TaskTreeItem *item = itemFor(index);
-    return item->task();
+    const TaskTreeItem item = itemFor(index);
+    return item.task();
 }
 
 bool TaskModelAdapter::taskIsActive(const Task &task) const
@@ -52,8 +52,8 @@ typedef ViewColumns ViewColumn;
 /** TaskModelAdapter adapts the CharmDataModel to be used in the task view
     (in main view and "select task" dialog).
 
-    It is a QAbstractItemModel, and stores the TaskTreeItem pointer of
-    the respective address in the model indexes internal pointer.
+    It is a QAbstractItemModel, and stores the node of the respective
+    TaskTreeItem in the internal id of the model indexes.
 */
 class TaskModelAdapter : public QAbstractItemModel, public TaskModelInterface,
     public CommandEmitterInterface, public CharmDataModelAdapterInterface
@@ -99,6 +99,7 @@ public:
     }
 
     void eventDeleted(EventId) override;
+    void eventsChanged(const EventChangeSet &changes) override;
 
     void eventActivated(EventId id) override;
     void eventDeactivated(EventId id) override;
@@ -119,7 +120,7 @@ Q_SIGNALS:
     void eventDeactivationNotice(EventId id) override;
 
 private:
-    const TaskTreeItem *itemFor(const QModelIndex &) const;
+    TaskTreeItem itemFor(const QModelIndex &) const;
     QModelIndex indexForTaskTreeItem(const TaskTreeItem &item, int column = 0) const;
 
     QPointer<CharmDataModel> m_dataModel;
@@ -26,10 +26,47 @@
 #include "Core/CharmDataModel.h"
 #include "ViewHelpers.h"
 
+#include "Core/TimeSpans.h"
+
 ViewFilter::ViewFilter(CharmDataModel *model, QObject *parent)
     : QSortFilterProxyModel(parent)
     , m_model(model)
 {
+    // keep the memoized match flags up to date; this needs to be connected
+    // before setSourceModel(), so that it happens before the proxy refilters:
+    // the filter matches the full task names, which include the names of
+    // the ancestors, so a change also affects the descendants:
+    connect(&m_model, &QAbstractItemModel::dataChanged,
+            this, [this](const QModelIndex &topLeft, const QModelIndex &bottomRight) {
+        for (int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+            const QModelIndex index = topLeft.sibling(row, 0);
+            invalidateSubtreeMatchFlags(index);
+            invalidateMatchFlags(index);
+        }
+    });
+    const auto invalidateRows = [this](const QModelIndex &parent, int first, int last) {
+        for (int row = first; row <= last; ++row)
+            m_matchFlags.remove(m_model.taskForIndex(m_model.index(row, 0, parent)).id());
+        invalidateMatchFlags(parent);
+    };
+    connect(&m_model, &QAbstractItemModel::rowsInserted, this, invalidateRows);
+    connect(&m_model, &QAbstractItemModel::rowsAboutToBeRemoved, this, invalidateRows);
+    connect(&m_model, &QAbstractItemModel::rowsRemoved,
+            this, [this](const QModelIndex &parent) {
+        invalidateMatchFlags(parent);
+    });
+    connect(&m_model, &QAbstractItemModel::modelAboutToBeReset,
+            this, &ViewFilter::clearMatchFlags);
+    connect(&m_model, &QAbstractItemModel::layoutAboutToBeChanged,
+            this, &ViewFilter::clearMatchFlags);
+    // whether a task is currently valid depends on the clock, the flags are
+    // recomputed when the date changes; tasks that become valid or invalid
+    // during the day are only noticed with the next change of the filter:
+    if (ApplicationCore::hasInstance()) {
+        connect(ApplicationCore::instance().dateChangeWatcher(), &DateChangeWatcher::dateChanged,
+                this, &ViewFilter::matchingChanged);
+    }
+
     setSourceModel(&m_model);
 
     // we filter for the task name column
@@ -72,81 +109,119 @@ bool ViewFilter::taskHasChildren(const Task &task) const
 
 void ViewFilter::prefilteringModeChanged()
 {
+    // validity depends on the current time, so always recompute:
+    clearMatchFlags();
     invalidate();
 }
 
 bool ViewFilter::filterAcceptsRow(int source_row, const QModelIndex &parent) const
 {
-    // by default, QSortFilterProxyModel only accepts row where already the parents where accepted
-    bool acceptedByFilter = QSortFilterProxyModel::filterAcceptsRow(source_row, parent);
-    // in our case, this is not what we want, we want parents to be
-    // accepted if any of their children are accepted (this is a
-    // recursive call, and could possibly be slow):
     const QModelIndex index(m_model.index(source_row, 0, parent));
-    if (!index.isValid()) return acceptedByFilter;
+    if (!index.isValid())
+        return QSortFilterProxyModel::filterAcceptsRow(source_row, parent);
 
-    int rowCount = m_model.rowCount(index);
+    validateMatchFlags();
+    return matchFlags(index) & Accepted;
+}
+
+int ViewFilter::matchFlags(const QModelIndex &sourceIndex) const
+{
+    const Task task = m_model.taskForIndex(sourceIndex);
+    const auto it = m_matchFlags.constFind(task.id());
+    if (it != m_matchFlags.constEnd())
+        return *it;
+
+    // by default, QSortFilterProxyModel only accepts rows where the
+    // parents were accepted already. In our case, we want parents to be
+    // accepted if any of their children are accepted:
+    bool acceptedByFilter = taskMatchesFilter(sourceIndex, task);
+    int subtreeFlags = (task.isCurrentlyValid() ? SubtreeIsValid : 0)
+                       | (task.subscribed() ? SubtreeIsSubscribed : 0);
+    const int rowCount = m_model.rowCount(sourceIndex);
     for (int i = 0; i < rowCount; ++i) {
-        if (filterAcceptsRow(i, index)) {
-            acceptedByFilter = true;
-            break;
-        }
+        const int childFlags = matchFlags(m_model.index(i, 0, sourceIndex));
+        acceptedByFilter |= (childFlags & Accepted) != 0;
+        subtreeFlags |= childFlags & (SubtreeIsValid | SubtreeIsSubscribed);
     }
 
+    const bool valid = subtreeFlags & SubtreeIsValid;
+    const bool subscribed = subtreeFlags & SubtreeIsSubscribed;
     bool accepted = acceptedByFilter;
-    const Task task = m_model.taskForIndex(index);
-    switch (Configuration::instance().taskPrefilteringMode) {
+    switch (m_matchedPrefilteringMode) {
     case Configuration::TaskPrefilter_ShowAll:
         break;
     case Configuration::TaskPrefilter_CurrentOnly:
-    {
-        const bool ok = (task.isCurrentlyValid() || checkChildren(task, HaveValidChild));
-        accepted &= ok;
+        accepted &= valid;
         break;
-    }
     case Configuration::TaskPrefilter_SubscribedOnly:
-    {
-        const bool ok = (task.subscribed() || checkChildren(task, HaveSubscribedChild));
-        accepted &= ok;
+        accepted &= subscribed;
         break;
-    }
     case Configuration::TaskPrefilter_SubscribedAndCurrentOnly:
-        accepted
-            &= ((task.subscribed()
-                 || checkChildren(task,
-                                  HaveSubscribedChild))
-                && (task.isCurrentlyValid() || checkChildren(task, HaveValidChild)));
+        accepted &= subscribed && valid;
         break;
     default:
         break;
     }
 
-    return accepted;
+    const int flags = subtreeFlags | (accepted ? Accepted : 0);
+    m_matchFlags.insert(task.id(), flags);
+    return flags;
 }
 
-bool ViewFilter::filterAcceptsColumn(int, const QModelIndex &) const
+bool ViewFilter::taskMatchesFilter(const QModelIndex &sourceIndex, const Task &) const
 {
-    return true;
+    return QSortFilterProxyModel::filterAcceptsRow(sourceIndex.row(), sourceIndex.parent());
 }
 
-bool ViewFilter::taskIdExists(TaskId taskId) const
+void ViewFilter::matchingChanged()
 {
-    return m_model.taskIdExists(taskId);
+    clearMatchFlags();
+    invalidateFilter();
 }
 
-bool ViewFilter::checkChildren(Task task, CheckFor checkFor) const
+void ViewFilter::validateMatchFlags() const
 {
-    if (taskHasChildren(task)) {
-        const TaskList taskList = m_model.children(task);
-        for (const Task &taskChild : taskList) {
-            if (checkFor == HaveSubscribedChild && taskChild.subscribed()) {
-                return true;
-            } else if (checkFor == HaveValidChild && taskChild.isCurrentlyValid()) {
-                return true;
-            }
-        }
+    const Configuration::TaskPrefilteringMode mode = Configuration::instance().taskPrefilteringMode;
+    if (m_matchedRegExp == filterRegExp() && m_matchedRole == filterRole()
+        && m_matchedColumn == filterKeyColumn() && m_matchedPrefilteringMode == mode)
+        return;
+
+    m_matchFlags.clear();
+    m_matchedRegExp = filterRegExp();
+    m_matchedRole = filterRole();
+    m_matchedColumn = filterKeyColumn();
+    m_matchedPrefilteringMode = mode;
+}
+
+void ViewFilter::invalidateMatchFlags(const QModelIndex &sourceIndex)
+{
+    for (QModelIndex index = sourceIndex; index.isValid(); index = index.parent())
+        m_matchFlags.remove(m_model.taskForIndex(index).id());
+}
+
+void ViewFilter::invalidateSubtreeMatchFlags(const QModelIndex &sourceIndex)
+{
+    const int rowCount = m_model.rowCount(sourceIndex);
+    for (int i = 0; i < rowCount; ++i) {
+        const QModelIndex child = m_model.index(i, 0, sourceIndex);
+        m_matchFlags.remove(m_model.taskForIndex(child).id());
+        invalidateSubtreeMatchFlags(child);
     }
-    return false;
+}
+
+void ViewFilter::clearMatchFlags()
+{
+    m_matchFlags.clear();
+}
+
+bool ViewFilter::filterAcceptsColumn(int, const QModelIndex &) const
+{
+    return true;
+}
+
+bool ViewFilter::taskIdExists(TaskId taskId) const
+{
+    return m_model.taskIdExists(taskId);
 }
 
 void ViewFilter::commitCommand(CharmCommand *command)
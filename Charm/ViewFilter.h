@@ -25,6 +25,8 @@
 #ifndef VIEWFILTER_H
 #define VIEWFILTER_H
 
+#include <QHash>
+#include <QRegExp>
 #include <QSortFilterProxyModel>
 
 #include "Core/Configuration.h"
@@ -63,14 +65,40 @@ Q_SIGNALS:
     void eventActivationNotice(EventId id) override;
     void eventDeactivationNotice(EventId id) override;
 
+protected:
+    /** Whether @p task, at @p sourceIndex, matches the filter itself, without
+     *  looking at its children. The default checks the filter regular expression. */
+    virtual bool taskMatchesFilter(const QModelIndex &sourceIndex, const Task &task) const;
+    /** Re-run the filter after the result of taskMatchesFilter() changed. */
+    void matchingChanged();
+
 private:
-    enum CheckFor {
-        HaveValidChild,
-        HaveSubscribedChild
+    enum MatchFlag {
+        Accepted = 0x1,
+        // the task or one of its descendants is currently valid:
+        SubtreeIsValid = 0x2,
+        // the task or one of its descendants is subscribed:
+        SubtreeIsSubscribed = 0x4
     };
 
-    bool checkChildren(Task task, CheckFor checkFor) const;
+    /** The match flags of the task at @p sourceIndex, computed bottom-up and
+     *  memoized until the filter or the task's subtree changes. */
+    int matchFlags(const QModelIndex &sourceIndex) const;
+    /** Drop the memoized flags if the filter settings changed since they were computed. */
+    void validateMatchFlags() const;
+    /** Forget the flags of the task at @p sourceIndex and of all its ancestors. */
+    void invalidateMatchFlags(const QModelIndex &sourceIndex);
+    /** Forget the flags of all descendants of the task at @p sourceIndex. */
+    void invalidateSubtreeMatchFlags(const QModelIndex &sourceIndex);
+    void clearMatchFlags();
+
     TaskModelAdapter m_model;
+    mutable QHash<TaskId, int> m_matchFlags;
+    mutable QRegExp m_matchedRegExp;
+    mutable int m_matchedRole = -1;
+    mutable int m_matchedColumn = -1;
+    mutable Configuration::TaskPrefilteringMode m_matchedPrefilteringMode
+        = Configuration::TaskPrefilter_ShowAll;
 };
 
 #endif
@@ -134,10 +134,12 @@ EventIdList Charm::eventIdsSortedBy(EventIdList ids, SortOrder order)
 EventIdList Charm::filteredBySubtree(EventIdList ids, TaskId parent, bool exclude)
 {
     EventIdList result;
-    bool isParent = false;
+    const TaskTreeItem parentItem = DATAMODEL->taskTreeItem(parent);
+    const bool parentExists = parentItem.isValid();
     Q_FOREACH (EventId id, ids) {
         const Event &event = DATAMODEL->eventForId(id);
-        isParent = (parent == event.taskId() || DATAMODEL->isParentOf(parent, event.taskId()));
+        const bool isParent = parent == event.taskId()
+                              || (parentExists && parentItem.isAncestorOf(DATAMODEL->taskTreeItem(event.taskId())));
         if (isParent != exclude)
             result << id;
     }
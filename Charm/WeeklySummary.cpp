@@ -27,6 +27,8 @@
 #include "Core/Event.h"
 #include "Core/Task.h"
 
+#include <algorithm>
+
 static const int DAYS_IN_WEEK = 7;
 
 WeeklySummary::WeeklySummary()
@@ -37,37 +39,111 @@ WeeklySummary::WeeklySummary()
 QVector<WeeklySummary> WeeklySummary::summariesForTimespan(CharmDataModel *dataModel,
                                                            const TimeSpan &timespan)
 {
-    const EventIdList eventIds = dataModel->eventsThatStartInTimeFrame(timespan);
-    // prepare a list of unique task ids used within the time span:
-    TaskIdList taskIds, uniqueTaskIds; // the list of tasks to show
-    EventList events;
-    Q_FOREACH (EventId id, eventIds) {
-        Event event = dataModel->eventForId(id);
-        events << event;
-        taskIds << event.taskId();
+    WeeklySummaryAggregate aggregate;
+    aggregate.reset(dataModel, timespan);
+    return aggregate.summaries();
+}
+
+void WeeklySummaryAggregate::reset(const CharmDataModel *dataModel, const TimeSpan &timespan)
+{
+    clear();
+    m_dataModel = dataModel;
+    m_timespan = timespan;
+
+    // the seconds per task and day of the week, for the tasks used within the time span:
+    const QMap<TaskId, QVector<int>> seconds = dataModel->durationRollup().secondsPerTask(
+        timespan.first, timespan.second, DAYS_IN_WEEK, [](const QDate &date) {
+        return date.dayOfWeek() - 1;
+    });
+    m_summaries.reserve(seconds.size());
+    for (auto it = seconds.constBegin(); it != seconds.constEnd(); ++it) {
+        WeeklySummary summary;
+        summary.task = it.key();
+        summary.taskname = dataModel->fullTaskName(dataModel->getTask(it.key()));
+        summary.durations = it.value();
+        m_summaries.append(summary);
     }
-    qSort(taskIds);
-    std::unique_copy(taskIds.begin(), taskIds.end(), std::back_inserter(uniqueTaskIds));
-    Q_ASSERT(events.size() == eventIds.size());
-    // retrieve task information
-    QVector<WeeklySummary> summaries(uniqueTaskIds.size());
-    for (int i = 0; i < uniqueTaskIds.size(); ++i) {
-        summaries[i].task = uniqueTaskIds.at(i);
-        const Task &task = dataModel->getTask(uniqueTaskIds[i]);
-        summaries[i].taskname = dataModel->fullTaskName(task);
+}
+
+void WeeklySummaryAggregate::clear()
+{
+    m_dataModel = nullptr;
+    m_timespan = TimeSpan();
+    m_summaries.clear();
+}
+
+TimeSpan WeeklySummaryAggregate::timespan() const
+{
+    return m_timespan;
+}
+
+const QVector<WeeklySummary> &WeeklySummaryAggregate::summaries() const
+{
+    return m_summaries;
+}
+
+WeeklySummaryAggregate::Change WeeklySummaryAggregate::updateTask(TaskId task)
+{
+    Change change;
+    if (!m_dataModel)
+        return change;
+
+    QVector<int> durations(DAYS_IN_WEEK, 0);
+    const bool used = durationsFor(task, &durations);
+    int index = indexOf(task);
+    if (!used) {
+        // the last event of the task in the time span is gone, and so is its row:
+        if (index != -1) {
+            m_summaries.remove(index);
+            change.rowsChanged = true;
+        }
+        return change;
+    }
+
+    if (index == -1) {
+        const auto it = std::lower_bound(m_summaries.begin(), m_summaries.end(), task,
+                                         [](const WeeklySummary &summary, TaskId id) {
+            return summary.task < id;
+        });
+        WeeklySummary summary;
+        summary.task = task;
+        summary.taskname = m_dataModel->fullTaskName(m_dataModel->getTask(task));
+        summary.durations = durations;
+        m_summaries.insert(it, summary);
+        change.rowsChanged = true;
+        return change;
+    }
+
+    for (int day = 0; day < DAYS_IN_WEEK; ++day) {
+        if (m_summaries[index].durations[day] != durations[day]) {
+            m_summaries[index].durations[day] = durations[day];
+            change.cells.append(Cell(index, day));
+        }
     }
-    // now add the times to the tasks:
-    Q_FOREACH (const Event &event, events) {
-        // find the index for this event:
-        auto it = std::find(uniqueTaskIds.begin(), uniqueTaskIds.end(), event.taskId());
-        if (it != uniqueTaskIds.end()) {
-            const int index = std::distance(uniqueTaskIds.begin(), it);
-            Q_ASSERT(index >= 0 && index < summaries.size());
-            const int dayOfWeek = event.startDateTime().date().dayOfWeek() - 1;
-            Q_ASSERT(dayOfWeek >= 0 && dayOfWeek < 7);
-            summaries[index].durations[dayOfWeek] += event.duration();
+    return change;
+}
+
+bool WeeklySummaryAggregate::durationsFor(TaskId task, QVector<int> *durations) const
+{
+    const DurationRollup &rollup = m_dataModel->durationRollup();
+    bool used = false;
+    for (QDate day = m_timespan.first; day < m_timespan.second; day = day.addDays(1)) {
+        const DurationRollup::Cell cell = rollup.cell(task, day);
+        if (cell.events > 0) {
+            used = true;
+            (*durations)[day.dayOfWeek() - 1] += cell.seconds;
         }
     }
+    return used;
+}
 
-    return summaries;
+int WeeklySummaryAggregate::indexOf(TaskId task) const
+{
+    const auto it = std::lower_bound(m_summaries.constBegin(), m_summaries.constEnd(), task,
+                                     [](const WeeklySummary &summary, TaskId id) {
+        return summary.task < id;
+    });
+    if (it == m_summaries.constEnd() || it->task != task)
+        return -1;
+    return std::distance(m_summaries.constBegin(), it);
 }
@@ -24,6 +24,7 @@
 #ifndef WEEKLYSUMMARY_H
 #define WEEKLYSUMMARY_H
 
+#include <QPair>
 #include <QString>
 #include <QVector>
 
@@ -45,4 +46,45 @@ public:
     QVector<int> durations;
 };
 
+/** WeeklySummaryAggregate keeps the weekly summaries of a time span up to date.
+    It is built from the duration rollup of the data model with reset(),
+    and afterwards updated one task at a time, after the events of the
+    task changed. Only the durations that differ are reported as changed.
+    The summaries are ordered by task id, like summariesForTimespan(). */
+class WeeklySummaryAggregate
+{
+public:
+    /** A changed duration: index into summaries(), and the day of the week (0 is Monday). */
+    typedef QPair<int, int> Cell;
+
+    struct Change {
+        /** Tasks were added to or removed from the summaries, the indexes are not stable. */
+        bool rowsChanged = false;
+        QVector<Cell> cells;
+
+        void add(const Change &other)
+        {
+            rowsChanged = rowsChanged || other.rowsChanged;
+            cells += other.cells;
+        }
+    };
+
+    void reset(const CharmDataModel *dataModel, const TimeSpan &timespan);
+    void clear();
+
+    TimeSpan timespan() const;
+    const QVector<WeeklySummary> &summaries() const;
+
+    /** Update the summary of @p task from the duration rollup of the data model. */
+    Change updateTask(TaskId task);
+
+private:
+    bool durationsFor(TaskId task, QVector<int> *durations) const;
+    int indexOf(TaskId task) const;
+
+    const CharmDataModel *m_dataModel = nullptr;
+    TimeSpan m_timespan;
+    QVector<WeeklySummary> m_summaries;
+};
+
 #endif // WEEKLYSUMMARY_H
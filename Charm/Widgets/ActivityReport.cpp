@@ -256,6 +256,7 @@ void ActivityReport::setReportProperties(
 void ActivityReport::slotUpdate()
 {
     // retrieve matching events:
+    DATAMODEL->ensureEventsLoadedSince(m_properties.start);
     EventIdList matchingEvents = DATAMODEL->eventsThatStartInTimeFrame(m_properties.start,
                                                                        m_properties.end);
 
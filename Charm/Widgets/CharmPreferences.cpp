@@ -101,6 +101,21 @@ CharmPreferences::CharmPreferences(const Configuration &config, QWidget *parent_
 
     m_ui.sbNumberOfTaskSelectorEntries->setValue(config.numberOfTaskSelectorEntries);
 
+    switch (config.databaseDurability) {
+    case Configuration::DatabaseDurability_Safe:
+        m_ui.cbDatabaseDurability->setCurrentIndex(0);
+        break;
+    case Configuration::DatabaseDurability_Balanced:
+        m_ui.cbDatabaseDurability->setCurrentIndex(1);
+        break;
+    case Configuration::DatabaseDurability_Fast:
+        m_ui.cbDatabaseDurability->setCurrentIndex(2);
+        break;
+    case Configuration::DatabaseDurability_NumberOfProfiles:
+        Q_ASSERT(false);
+        break;
+    }
+
     // resize( minimumSize() );
 }
 
@@ -146,6 +161,21 @@ Configuration::DurationFormat CharmPreferences::durationFormat() const
     return Configuration::Minutes;
 }
 
+Configuration::DatabaseDurability CharmPreferences::databaseDurability() const
+{
+    switch (m_ui.cbDatabaseDurability->currentIndex()) {
+    case 0:
+        return Configuration::DatabaseDurability_Safe;
+    case 1:
+        return Configuration::DatabaseDurability_Balanced;
+    case 2:
+        return Configuration::DatabaseDurability_Fast;
+    default:
+        Q_ASSERT(!"Unexpected combobox item for DatabaseDurability");
+    }
+    return Configuration::DatabaseDurability_Balanced;
+}
+
 Configuration::TimeTrackerFontSize CharmPreferences::timeTrackerFontSize() const
 {
     switch (m_ui.cbTimeTrackerFontSize->currentIndex()) {
@@ -43,6 +43,7 @@ public:
     bool requestEventComment() const;
     bool enableCommandInterface() const;
     int numberOfTaskSelectorEntries() const;
+    Configuration::DatabaseDurability databaseDurability() const;
 
     Qt::ToolButtonStyle toolButtonStyle() const;
 
@@ -23,10 +23,12 @@
 
 #include "EventView.h"
 #include "ApplicationCore.h"
+#include "CharmWindow.h"
 #include "Data.h"
 #include "EventEditor.h"
 #include "EventEditorDelegate.h"
 #include "EventModelFilter.h"
+#include "EnterVacationDialog.h"
 #include "FindAndReplaceEventsDialog.h"
 #include "MessageBox.h"
 #include "SelectTaskDialog.h"
@@ -35,6 +37,7 @@
 #include "WeeklyTimesheet.h"
 #include "WidgetUtils.h"
 
+#include "Commands/CommandBatchEvents.h"
 #include "Commands/CommandDeleteEvent.h"
 #include "Commands/CommandMakeEvent.h"
 #include "Commands/CommandModifyEvent.h"
@@ -440,9 +443,27 @@ void EventView::slotFindAndReplace()
     if (findAndReplace.exec() != QDialog::Accepted)
         return;
 
-    QList<Event> events = findAndReplace.modifiedEvents();
-    for (int i = 0; i < events.count(); ++i)
-        slotEventChangesCompleted(events[i]);
+    const QList<Event> events = findAndReplace.modifiedEvents();
+    if (events.isEmpty())
+        return;
+
+    auto command = new CommandBatchEvents(tr("Replace Task"), this);
+    Q_FOREACH (const Event &event, events)
+        command->modifyEvent(event, MODEL.charmDataModel()->eventForId(event.id()));
+    stageCommand(command);
+}
+
+void EventView::slotEnterVacation()
+{
+    // the new events can be undone here, so show them:
+    CharmWindow::showView(this);
+    EnterVacationDialog dialog(this);
+    if (dialog.exec() != QDialog::Accepted)
+        return;
+
+    auto command = new CommandBatchEvents(tr("Enter Vacation"), this);
+    command->addEvents(dialog.events());
+    stageCommand(command);
 }
 
 void EventView::slotReset()
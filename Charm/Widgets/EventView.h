@@ -70,6 +70,7 @@ public Q_SLOTS:
     void timeSpansChanged();
     void timeFrameChanged(int);
     void slotConfigureUi();
+    void slotEnterVacation();
 
     void saveGuiState() override;
     void restoreGuiState() override;
@@ -121,11 +121,10 @@ QByteArray MonthlyTimeSheetReport::saveToXml(SaveToXmlMode mode)
         timesheet.setNumberOfWeeks(m_numberOfWeeks);
         timesheet.setRootTask(rootTask());
         timesheet.setIncludeTaskList(mode == IncludeTaskList);
-        const EventIdList matchingEventIds = DATAMODEL->eventsThatStartInTimeFrame(
-            startDate(), endDate());
+        // the effort lists the events, not only their durations:
+        DATAMODEL->ensureEventsLoadedSince(startDate());
         EventList events;
-        events.reserve(matchingEventIds.size());
-        Q_FOREACH (const EventId &eventId, matchingEventIds)
+        for (EventId eventId : DATAMODEL->eventIdsThatStartInTimeFrame(startDate(), endDate()))
             events.append(DATAMODEL->eventForId(eventId));
         timesheet.setEvents(events);
         return timesheet.saveToXml();
@@ -158,26 +157,14 @@ static QDomElement addTblCell(QDomElement &toRow, const QString &text)
 void MonthlyTimeSheetReport::update()
 {
     // this creates the time sheet
-    // retrieve matching events:
-    const EventIdList matchingEvents
-        = DATAMODEL->eventsThatStartInTimeFrame(startDate(), endDate());
-
-    m_secondsMap.clear();
-
-    // for every task, make a vector that includes a number of seconds
-    // for every week of a month ( int seconds[m_numberOfWeeks]), and store those in
-    // a map by their task id
-    Q_FOREACH (EventId id, matchingEvents) {
-        const Event &event = DATAMODEL->eventForId(id);
-        QVector<int> seconds(m_numberOfWeeks);
-        if (m_secondsMap.contains(event.taskId()))
-            seconds = m_secondsMap.value(event.taskId());
+    // for every task, get a vector that includes a number of seconds
+    // for every week of a month ( int seconds[m_numberOfWeeks]), by their task id:
+    const QDate start = startDate();
+    m_secondsMap = DATAMODEL->durationRollup().secondsPerTask(
+        start, endDate(), m_numberOfWeeks, [start](const QDate &date) {
         // what week of the month is the event (normalized to vector indexes):
-        const int weekOfMonth = Charm::weekDifference(startDate(), event.startDateTime().date());
-        seconds[weekOfMonth] += event.duration();
-        // store in minute map:
-        m_secondsMap[event.taskId()] = seconds;
-    }
+        return Charm::weekDifference(start, date);
+    });
     // now the reporting:
     // headline first:
     QTextDocument report;
@@ -29,10 +29,13 @@
 #include <QPushButton>
 #include <QSettings>
 
+#include <algorithm>
+
 #include "ui_SelectTaskDialog.h"
 
 SelectTaskDialogProxy::SelectTaskDialogProxy(CharmDataModel *model, QObject *parent)
     : ViewFilter(model, parent)
+    , m_dataModel(model)
 {
     // we filter for the task name column
     setFilterKeyColumn(Column_TaskId);
@@ -64,6 +67,18 @@ QVariant SelectTaskDialogProxy::data(const QModelIndex &index, int role) const
     }
 }
 
+void SelectTaskDialogProxy::setSearchText(const QString &text)
+{
+    m_searchText = text.simplified();
+    matchingChanged();
+}
+
+bool SelectTaskDialogProxy::taskMatchesFilter(const QModelIndex &, const Task &task) const
+{
+    return m_searchText.isEmpty()
+           || m_dataModel->taskSearchIndex().find(m_searchText).contains(task.id());
+}
+
 SelectTaskDialog::SelectTaskDialog(QWidget *parent)
     : QDialog(parent)
     , m_ui(new Ui::SelectTaskDialog())
@@ -199,11 +214,13 @@ void SelectTaskDialog::slotDoubleClicked(const QModelIndex &index)
 
 void SelectTaskDialog::slotFilterTextChanged(const QString &text)
 {
-    QString filtertext = text.simplified();
-    filtertext.replace(QLatin1Char(' '), QLatin1Char('*'));
+    // wildcards are not needed, every word is searched for separately:
+    QString filtertext = text;
+    filtertext.replace(QLatin1Char('*'), QLatin1Char(' '));
+    filtertext = filtertext.simplified();
 
     Charm::saveExpandStates(m_ui->treeView, &m_expansionStates);
-    m_proxy.setFilterWildcard(filtertext);
+    m_proxy.setSearchText(filtertext);
     if (!filtertext.isEmpty()) {
         m_ui->treeView->expandAll();
     } else {
@@ -274,9 +291,16 @@ void SelectTaskDialog::slotSelectTask(const QString &filter)
 {
     const QString filterText = filter.simplified().toUpper().replace(QLatin1Char('*'), QLatin1Char(' '));
     const int filterTaskId = filterText.toInt();
-    const TaskList tasks = MODEL.charmDataModel()->getAllTasks();
-
-    for (const auto task : tasks) {
+    const CharmDataModel *model = MODEL.charmDataModel();
+    // the name of a task is part of its full name, so only the tasks found
+    // in the search index need to be checked:
+    TaskIdList candidates = model->taskSearchIndex().find(filterText).toList();
+    if (model->taskExists(filterTaskId))
+        candidates << filterTaskId;
+    std::sort(candidates.begin(), candidates.end());
+
+    for (const auto id : candidates) {
+        const Task &task = model->getTask(id);
         if (!task.isValid())
             continue;
         if (task.name().toUpper().contains(filterText) || task.id() == filterTaskId)
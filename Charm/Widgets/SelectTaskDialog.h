@@ -47,8 +47,17 @@ public:
     Qt::ItemFlags flags(const QModelIndex &index) const override;
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
 
+    /** Show only tasks whose id or full name contain all words of @p text,
+     *  and their ancestors. Uses the search index of the data model. */
+    void setSearchText(const QString &text);
+
 protected:
     bool filterAcceptsColumn(int column, const QModelIndex &parent) const override;
+    bool taskMatchesFilter(const QModelIndex &sourceIndex, const Task &task) const override;
+
+private:
+    CharmDataModel *m_dataModel;
+    QString m_searchText;
 };
 
 class SelectTaskDialog : public QDialog
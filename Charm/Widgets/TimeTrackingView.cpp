@@ -134,26 +134,14 @@ void TimeTrackingView::paintEvent(QPaintEvent *e)
 {
     m_activeFieldRects.clear();
     const int FieldHeight = m_cachedTotalsFieldRect.height();
+    const QRegion &dirty = e->region();
     QPainter painter(this);
     // all attributes are determined in data(), we just paint the rects:
     for (int row = 0; row < rowCount() - 1; ++row) {
         for (int column = 0; column < columnCount(); ++column) {
-            // get the rectangle of the field that will be drawn
-            QRect fieldRect;
-            const int y = row * FieldHeight;
-            if (column == columnCount() - 1) {   // totals column
-                fieldRect = QRect(width() - m_cachedTotalsFieldRect.width(), y,
-                                  m_cachedTotalsFieldRect.width(), FieldHeight);
-            } else if (column == 0) {   // task column
-                fieldRect = QRect(0, y, taskColumnWidth(), FieldHeight);
-            } else if (column > 0) {   //  a task
-                fieldRect = QRect(width() - m_cachedTotalsFieldRect.width()
-                                  - 8 * m_cachedDayFieldRect.width()
-                                  + column * m_cachedDayFieldRect.width(), y,
-                                  m_cachedDayFieldRect.width(), FieldHeight);
-            }
+            const QRect fieldRect = this->fieldRect(column, row);
             // paint the field, if it is in the dirty region
-            if (e->rect().contains(fieldRect)) {
+            if (dirty.intersects(fieldRect)) {
                 DataField field = m_defaultField;
                 data(field, column, row);
                 int alignment = Qt::AlignRight | Qt::AlignVCenter;
@@ -184,7 +172,7 @@ void TimeTrackingView::paintEvent(QPaintEvent *e)
     // paint the tracking row
     const int top = (rowCount() - 1) * FieldHeight;
     const QRect fieldRect(0, top, width(), height() - top);
-    if (e->rect().contains(fieldRect)) {
+    if (dirty.intersects(fieldRect)) {
         DataField field = m_defaultField;
         data(field, 0, rowCount() - 1);
         painter.setBrush(field.background);
@@ -193,6 +181,23 @@ void TimeTrackingView::paintEvent(QPaintEvent *e)
     }
 }
 
+QRect TimeTrackingView::fieldRect(int column, int row) const
+{
+    const int FieldHeight = m_cachedTotalsFieldRect.height();
+    const int y = row * FieldHeight;
+    if (column == columnCount() - 1) {   // totals column
+        return QRect(width() - m_cachedTotalsFieldRect.width(), y,
+                     m_cachedTotalsFieldRect.width(), FieldHeight);
+    } else if (column == 0) {   // task column
+        return QRect(0, y, taskColumnWidth(), FieldHeight);
+    } else {   //  a task
+        return QRect(width() - m_cachedTotalsFieldRect.width()
+                     - 8 * m_cachedDayFieldRect.width()
+                     + column * m_cachedDayFieldRect.width(), y,
+                     m_cachedDayFieldRect.width(), FieldHeight);
+    }
+}
+
 void TimeTrackingView::resizeEvent(QResizeEvent *)
 {
     sizeHint(); // make sure cached values are updated
@@ -344,7 +349,30 @@ void TimeTrackingView::setSummaries(const QVector<WeeklySummary> &summaries)
     m_elidedTexts.clear();
     updateGeometry();
     update();
-    // populate menu:
+    populateTaskSelector();
+}
+
+void TimeTrackingView::updateSummaryCells(const QVector<WeeklySummary> &summaries,
+                                          const QVector<WeeklySummaryAggregate::Cell> &cells)
+{
+    Q_ASSERT(summaries.size() == m_summaries.size());
+    m_summaries = summaries;
+    if (cells.isEmpty())
+        return;
+    const int TotalsRow = rowCount() - 2;
+    const int TotalsColumn = columnCount() - 1;
+    update(fieldRect(TotalsColumn, TotalsRow));
+    Q_FOREACH (const WeeklySummaryAggregate::Cell &cell, cells) {
+        const int row = cell.first + 1;
+        const int column = cell.second + 1;
+        update(fieldRect(column, row));
+        update(fieldRect(TotalsColumn, row));
+        update(fieldRect(column, TotalsRow));
+    }
+}
+
+void TimeTrackingView::populateTaskSelector()
+{
     m_taskSelector->populate(m_summaries);
     // FIXME maybe remember last selected task
     handleActiveEvents();
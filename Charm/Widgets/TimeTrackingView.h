@@ -70,6 +70,11 @@ public:
     void mouseDoubleClickEvent(QMouseEvent *event) override;
 
     void setSummaries(const QVector<WeeklySummary> &summaries);
+    /** Replace the summaries, but repaint only the changed cells (and their totals).
+        The rows of the summaries must be the same as before. */
+    void updateSummaryCells(const QVector<WeeklySummary> &summaries,
+                            const QVector<WeeklySummaryAggregate::Cell> &cells);
+    void populateTaskSelector();
     QSize sizeHint() const override;
     QSize minimumSizeHint() const override;
     QMenu *menu() const;
@@ -102,6 +107,7 @@ private:
         return qMax(6, m_summaries.count()) + 3;
     }
 
+    QRect fieldRect(int column, int row) const;
     int getSummaryAt(const QPoint &position);
     bool taskIsValidAndTrackable(int taskId);
 
@@ -30,7 +30,6 @@
 #include "CharmNewReleaseDialog.h"
 #include "CharmPreferences.h"
 #include "CommentEditorPopup.h"
-#include "EnterVacationDialog.h"
 #include "IdleCorrectionDialog.h"
 #include "MakeTemporarilyVisible.h"
 #include "MessageBox.h"
@@ -43,9 +42,8 @@
 
 #include "Commands/CommandExportToXml.h"
 #include "Commands/CommandImportFromXml.h"
-#include "Commands/CommandMakeEvent.h"
 #include "Commands/CommandModifyEvent.h"
-#include "Commands/CommandSetAllTasks.h"
+#include "Commands/CommandImportTasks.h"
 
 #include "Core/TaskListMerger.h"
 #include "Core/TimeSpans.h"
@@ -149,6 +147,7 @@ void TimeTrackingWindow::stateChanged(State previous)
         connect(ApplicationCore::instance().dateChangeWatcher(), &DateChangeWatcher::dateChanged,
                 this, &TimeTrackingWindow::slotSelectTasksToShow);
         DATAMODEL->registerAdapter(this);
+        m_summaries.clear();
         m_summaryWidget->setSummaries(QVector<WeeklySummary>());
         m_summaryWidget->handleActiveEvents();
         break;
@@ -207,23 +206,37 @@ void TimeTrackingWindow::eventAboutToBeAdded(EventId)
 {
 }
 
-void TimeTrackingWindow::eventAdded(EventId)
+void TimeTrackingWindow::eventAdded(EventId id)
 {
-    slotSelectTasksToShow();
+    // the most recently used tasks may have changed:
+    applySummaryChange(m_summaries.updateTask(DATAMODEL->eventForId(id).taskId()), true);
 }
 
-void TimeTrackingWindow::eventModified(EventId, Event)
+void TimeTrackingWindow::eventModified(EventId id, Event discardedEvent)
 {
-    slotSelectTasksToShow();
+    const TaskId task = DATAMODEL->eventForId(id).taskId();
+    WeeklySummaryAggregate::Change change = m_summaries.updateTask(task);
+    if (discardedEvent.taskId() != task)
+        change.add(m_summaries.updateTask(discardedEvent.taskId()));
+    applySummaryChange(change, false);
 }
 
-void TimeTrackingWindow::eventAboutToBeDeleted(EventId)
+void TimeTrackingWindow::eventAboutToBeDeleted(EventId id)
 {
+    m_deletedEventTask = DATAMODEL->eventForId(id).taskId();
 }
 
 void TimeTrackingWindow::eventDeleted(EventId)
 {
-    slotSelectTasksToShow();
+    applySummaryChange(m_summaries.updateTask(m_deletedEventTask), true);
+}
+
+void TimeTrackingWindow::eventsChanged(const EventChangeSet &changes)
+{
+    WeeklySummaryAggregate::Change change;
+    Q_FOREACH (TaskId task, changes.tasks)
+        change.add(m_summaries.updateTask(task));
+    applySummaryChange(change, !changes.added.isEmpty() || !changes.removed.isEmpty());
 }
 
 void TimeTrackingWindow::eventActivated(EventId)
@@ -262,8 +275,25 @@ void TimeTrackingWindow::slotSelectTasksToShow()
     // first, we select tasks that most recently where active
     const NamedTimeSpan thisWeek = TimeSpans().thisWeek();
     // and update the widget:
-    m_summaries = WeeklySummary::summariesForTimespan(DATAMODEL, thisWeek.timespan);
-    m_summaryWidget->setSummaries(m_summaries);
+    m_summaries.reset(DATAMODEL, thisWeek.timespan);
+    m_summaryWidget->setSummaries(m_summaries.summaries());
+}
+
+void TimeTrackingWindow::applySummaryChange(const WeeklySummaryAggregate::Change &change,
+                                            bool populateTaskSelector)
+{
+    const TimeSpan week = m_summaries.timespan();
+    const QDate today = QDate::currentDate();
+    if (!week.first.isValid() || today < week.first || today >= week.second) {
+        // the week changed since the last rebuild:
+        slotSelectTasksToShow();
+    } else if (change.rowsChanged) {
+        m_summaryWidget->setSummaries(m_summaries.summaries());
+    } else {
+        m_summaryWidget->updateSummaryCells(m_summaries.summaries(), change.cells);
+        if (populateTaskSelector)
+            m_summaryWidget->populateTaskSelector();
+    }
 }
 
 void TimeTrackingWindow::insertEditMenu()
@@ -311,6 +341,7 @@ void TimeTrackingWindow::slotEditPreferences(bool)
         CONFIGURATION.requestEventComment = dialog.requestEventComment();
         CONFIGURATION.enableCommandInterface = dialog.enableCommandInterface();
         CONFIGURATION.numberOfTaskSelectorEntries = dialog.numberOfTaskSelectorEntries();
+        CONFIGURATION.databaseDurability = dialog.databaseDurability();
         emit saveConfiguration();
     }
 }
@@ -322,19 +353,6 @@ void TimeTrackingWindow::slotAboutDialog()
     dialog.exec();
 }
 
-void TimeTrackingWindow::slotEnterVacation()
-{
-    MakeTemporarilyVisible m(this);
-    EnterVacationDialog dialog(this);
-    if (dialog.exec() != QDialog::Accepted)
-        return;
-    const EventList events = dialog.events();
-    Q_FOREACH (const Event &event, events) {
-        auto command = new CommandMakeEvent(event, this);
-        sendCommand(command);
-    }
-}
-
 void TimeTrackingWindow::slotActivityReport()
 {
     delete m_activityReportDialog;
@@ -739,7 +757,7 @@ void TimeTrackingWindow::importTasksFromDeviceOrFile(QIODevice *device, const QS
                 emit showNotification(title, message);
             }
         } else {
-            auto cmd = new CommandSetAllTasks(merger.mergedTaskList(), this);
+            auto cmd = new CommandImportTasks(merger.addedTasks(), merger.updatedTasks(), this);
             sendCommand(cmd);
             // At this point the command was finalized and we have a result.
             const bool success = cmd->finalize();
@@ -812,10 +830,8 @@ void TimeTrackingWindow::uploadStagedTimesheet()
         timesheet.setWeekNumber(weekNumber);
         timesheet.setIncludeTaskList(false);
 
-        const auto matchingEventIds = DATAMODEL->eventsThatStartInTimeFrame(weekStart, yesterday);
         EventList events;
-        events.reserve(matchingEventIds.size());
-        Q_FOREACH (const EventId &id, matchingEventIds)
+        for (EventId id : DATAMODEL->eventIdsThatStartInTimeFrame(weekStart, yesterday))
             events.append(DATAMODEL->eventForId(id));
         timesheet.setEvents(events);
 
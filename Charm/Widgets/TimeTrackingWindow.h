@@ -76,6 +76,7 @@ public:
     void eventModified(EventId id, Event discardedEvent) override;
     void eventAboutToBeDeleted(EventId id) override;
     void eventDeleted(EventId id) override;
+    void eventsChanged(const EventChangeSet &changes) override;
     void eventActivated(EventId id) override;
     void eventDeactivated(EventId id) override;
 
@@ -83,7 +84,6 @@ public Q_SLOTS:
     // slots migrated from the old main window:
     void slotEditPreferences(bool);   // show prefs dialog
     void slotAboutDialog();
-    void slotEnterVacation();
     void slotActivityReport();
     void slotWeeklyTimesheetReport();
     void slotMonthlyTimesheetReport();
@@ -134,12 +134,14 @@ private:
     void informUserAboutNewRelease(const QString &releaseVersion, const QUrl &link,
                                    const QString &releaseInfoLink);
     void handleIdleEvents(IdleDetector *detector, bool restart);
+    void applySummaryChange(const WeeklySummaryAggregate::Change &change, bool populateTaskSelector);
 
     WeeklyTimesheetConfigurationDialog *m_weeklyTimesheetDialog = nullptr;
     MonthlyTimesheetConfigurationDialog *m_monthlyTimesheetDialog = nullptr;
     ActivityReportConfigurationDialog *m_activityReportDialog = nullptr;
     TimeTrackingView *m_summaryWidget;
-    QVector<WeeklySummary> m_summaries;
+    WeeklySummaryAggregate m_summaries;
+    TaskId m_deletedEventTask = {};
     QTimer m_checkUploadedSheetsTimer;
     QTimer m_checkCharmReleaseVersionTimer;
     QTimer m_updateUserInfoAndTasksDefinitionsTimer;
@@ -47,6 +47,9 @@ void TimeSheetReport::setReportProperties(
     m_end = end;
     m_rootTask = rootTask;
     m_activeTasksOnly = activeTasksOnly;
+    // the report only needs the events if the durations do not cover them:
+    if (!DATAMODEL->durationRollupIsComplete())
+        DATAMODEL->ensureEventsLoadedSince(m_start);
     update();
 }
 
@@ -326,27 +326,13 @@ QString WeeklyTimeSheetReport::suggestedFileName() const
 
 void WeeklyTimeSheetReport::update()
 {   // this creates the time sheet
-    // retrieve matching events:
-    const EventIdList matchingEvents
-        = DATAMODEL->eventsThatStartInTimeFrame(startDate(), endDate());
-
-    m_secondsMap.clear();
-
-    // for every task, make a vector that includes a number of seconds
-    // for every day of the week ( int seconds[7]), and store those in
-    // a map by their task id
-    Q_FOREACH (EventId id, matchingEvents) {
-        const Event &event = DATAMODEL->eventForId(id);
-        QVector<int> seconds(DaysInWeek);
-        if (m_secondsMap.contains(event.taskId()))
-            seconds = m_secondsMap.value(event.taskId());
+    // for every task, get a vector that includes a number of seconds
+    // for every day of the week ( int seconds[7]), by their task id:
+    m_secondsMap = DATAMODEL->durationRollup().secondsPerTask(
+        startDate(), endDate(), DaysInWeek, [](const QDate &date) {
         // what day in the week is the event (normalized to vector indexes):
-        int dayOfWeek = event.startDateTime().date().dayOfWeek() - 1;
-        Q_ASSERT(dayOfWeek >= 0 && dayOfWeek < DaysInWeek);
-        seconds[dayOfWeek] += event.duration();
-        // store in minute map:
-        m_secondsMap[event.taskId()] = seconds;
-    }
+        return date.dayOfWeek() - 1;
+    });
     // now the reporting:
     // headline first:
     QTextDocument report;
@@ -523,11 +509,10 @@ QByteArray WeeklyTimeSheetReport::saveToXml(SaveToXmlMode mode)
         timesheet.setWeekNumber(m_weekNumber);
         timesheet.setRootTask(rootTask());
         timesheet.setIncludeTaskList(mode == IncludeTaskList);
-        const EventIdList matchingEventIds = DATAMODEL->eventsThatStartInTimeFrame(
-            startDate(), endDate());
+        // the effort lists the events, not only their durations:
+        DATAMODEL->ensureEventsLoadedSince(startDate());
         EventList events;
-        events.reserve(matchingEventIds.size());
-        Q_FOREACH (const EventId &id, matchingEventIds)
+        for (EventId id : DATAMODEL->eventIdsThatStartInTimeFrame(startDate(), endDate()))
             events.append(DATAMODEL->eventForId(id));
         timesheet.setEvents(events);
 
@@ -68,6 +68,15 @@ const QString MetaKey_Key_ToolButtonStyle = QStringLiteral("ToolButtonStyle");
 const QString MetaKey_Key_ShowStatusBar = QStringLiteral("ShowStatusBar");
 const QString MetaKey_Key_EnableCommandInterface = QStringLiteral("EnableCommandInterface");
 const QString MetaKey_Key_NumberOfTaskSelectorEntries = QStringLiteral("NumberOfTaskSelectorEntries");
+const QString MetaKey_Key_HeartbeatCheckpointInterval = QStringLiteral("HeartbeatCheckpointInterval");
+const QString MetaKey_Key_DatabaseDurability = QStringLiteral("DatabaseDurability");
+const QString MetaKey_Key_EventHistoryWeeks = QStringLiteral("EventHistoryWeeks");
+
+const QString DatabaseExportRootElement(QStringLiteral("charmdatabase"));
+const QString DatabaseExportVersionAttribute(QStringLiteral("version"));
+const QString DatabaseExportMetaDataElement(QStringLiteral("metadata"));
+const QString DatabaseExportTasksElement(QStringLiteral("tasks"));
+const QString DatabaseExportEventsElement(QStringLiteral("events"));
 
 const QString TrueString(QStringLiteral("true"));
 const QString FalseString(QStringLiteral("false"));
@@ -85,8 +94,20 @@ void connectControllerAndModel(Controller *controller, CharmDataModel *model)
                      model, SLOT(modifyEvent(Event)));
     QObject::connect(controller, SIGNAL(eventDeleted(Event)),
                      model, SLOT(deleteEvent(Event)));
+    QObject::connect(controller, SIGNAL(bulkUpdateStarted()),
+                     model, SLOT(beginBulkUpdate()));
+    QObject::connect(controller, SIGNAL(bulkUpdateFinished()),
+                     model, SLOT(endBulkUpdate()));
     QObject::connect(controller, SIGNAL(allEvents(EventList)),
                      model, SLOT(setAllEvents(EventList)));
+    QObject::connect(controller, SIGNAL(recentEvents(EventList,QDateTime)),
+                     model, SLOT(setRecentEvents(EventList,QDateTime)));
+    QObject::connect(model, SIGNAL(eventsRequested(QDateTime,QDateTime)),
+                     controller, SLOT(loadEvents(QDateTime,QDateTime)));
+    QObject::connect(controller, SIGNAL(eventsLoaded(EventList)),
+                     model, SLOT(addLoadedEvents(EventList)));
+    QObject::connect(controller, SIGNAL(durationRollupLoaded(DurationRollup)),
+                     model, SLOT(setDurationRollup(DurationRollup)));
     QObject::connect(controller, SIGNAL(definedTasks(TaskList)),
                      model, SLOT(setAllTasks(TaskList)));
     QObject::connect(controller, SIGNAL(taskAdded(Task)),
@@ -95,6 +116,8 @@ void connectControllerAndModel(Controller *controller, CharmDataModel *model)
                      model, SLOT(modifyTask(Task)));
     QObject::connect(controller, SIGNAL(taskDeleted(Task)),
                      model, SLOT(deleteTask(Task)));
+    QObject::connect(model, SIGNAL(eventHeartbeat(Event)),
+                     controller, SLOT(recordHeartbeat(Event)));
 }
 
 static QString formatDecimal(double d)
@@ -33,10 +33,14 @@
 
 // increment when SQL DB format changes:
 #define CHARM_DATABASE_VERSION_DESCRIPTOR QStringLiteral("CharmDatabaseSchemaVersion")
+#define CHARM_DATABASE_CHANGE_COUNTER_DESCRIPTOR QStringLiteral("ChangeCounter")
 #define CHARM_DATABASE_VERSION_BEFORE_TASK_EXPIRY 2
 #define CHARM_DATABASE_VERSION_BEFORE_TRACKABLE 3
 #define CHARM_DATABASE_VERSION_BEFORE_COMMENT 4
-#define CHARM_DATABASE_VERSION 5
+#define CHARM_DATABASE_VERSION_BEFORE_INDEXES 5
+#define CHARM_DATABASE_VERSION_BEFORE_CHANGE_COUNTER 6
+#define CHARM_DATABASE_VERSION_BEFORE_DURATION_ROLLUP 7
+#define CHARM_DATABASE_VERSION 8
 #define REQUIRED_CHARM_DATABASE_VERSION CHARM_DATABASE_VERSION
 // FIXME this may have to go into some plugin configuration later:
 // FIXME also, we may need some verbose descriptors for configuration
@@ -75,6 +79,16 @@ extern const QString MetaKey_Key_ToolButtonStyle;
 extern const QString MetaKey_Key_ShowStatusBar;
 extern const QString MetaKey_Key_EnableCommandInterface;
 extern const QString MetaKey_Key_NumberOfTaskSelectorEntries;
+extern const QString MetaKey_Key_HeartbeatCheckpointInterval;
+extern const QString MetaKey_Key_DatabaseDurability;
+extern const QString MetaKey_Key_EventHistoryWeeks;
+
+// Database export XML element and attribute names:
+extern const QString DatabaseExportRootElement;
+extern const QString DatabaseExportVersionAttribute;
+extern const QString DatabaseExportMetaDataElement;
+extern const QString DatabaseExportTasksElement;
+extern const QString DatabaseExportEventsElement;
 
 extern const QString TrueString;
 extern const QString FalseString;
@@ -103,6 +117,7 @@ template<> inline bool strToT(const QString &str)
 INT_CONFIG_TYPE(Configuration::TimeTrackerFontSize)
 INT_CONFIG_TYPE(Configuration::DurationFormat)
 INT_CONFIG_TYPE(Configuration::TaskPrefilteringMode)
+INT_CONFIG_TYPE(Configuration::DatabaseDurability)
 INT_CONFIG_TYPE(Qt::ToolButtonStyle)
 
 const QString &stringForBool(bool val);
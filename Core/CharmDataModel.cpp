@@ -29,6 +29,7 @@
 #include "CharmDataModel.h"
 #include "CharmConstants.h"
 #include "Configuration.h"
+#include "TaskListValidator.h"
 
 #include <QList>
 #include <QtDebug>
@@ -58,7 +59,7 @@ void CharmDataModel::stateChanged(State previous, State next)
 {
     if (previous == Connected && next == Disconnecting) {
         Q_FOREACH (EventId id, m_activeEventIds) {
-            const Event &event = findEvent(id);
+            const Event event = m_events.event(id);
             const Task &task = findTask(event.taskId());
             Q_ASSERT(task.isValid());
             endEventRequested(task);
@@ -83,27 +84,15 @@ void CharmDataModel::setAllTasks(const TaskList &tasks)
 {
     clearTasks();
 
-    Q_ASSERT(Task::checkForTreeness(tasks));
-    Q_ASSERT(Task::checkForUniqueTaskIds(tasks));
+    Q_ASSERT(TaskListValidator(tasks).isValid());
 
-    // fill the tasks into the map to TaskTreeItems
-    for (int i = 0; i < tasks.size(); ++i) {
-        const TaskTreeItem item(tasks[i], &m_rootItem);
-        Q_ASSERT(!taskExists(tasks[i].id()));      // the tasks form a tree and have unique task ids
-        m_tasks[ tasks[i].id() ] = item;
-    }
-
-    // create parent-child-relationships:
-    for (TaskTreeItem::Map::iterator it = m_tasks.begin(); it != m_tasks.end(); ++it) {
-        const Task &task = it->second.task();
-        TaskTreeItem &parent = parentItem(task);
-        it->second.makeChildOf(parent);
-    }
+    m_tasks.setAllTasks(tasks);
 
     // store task id length:
     determineTaskPaddingLength();
 
     m_nameCache.setAllTasks(tasks);
+    m_searchIndex.setAllTasks(tasks);
 
     // notify adapters of changes
     for_each(m_adapters.begin(), m_adapters.end(),
@@ -124,14 +113,9 @@ void CharmDataModel::addTask(const Task &task)
             adapter->taskAboutToBeAdded(parent.task().id(),
                                         parent.childCount());
 
-        const TaskTreeItem item(task);
-        m_tasks[ task.id() ] = item;
+        m_tasks.addTask(task);
         m_nameCache.addTask(task);
-
-        // the item in the map has a different address, let's find it:
-        Q_ASSERT(taskExists(task.id()));     // we just put it in
-        const auto it = m_tasks.find(task.id());
-        it->second.makeChildOf(parentItem(task));
+        m_searchIndex.addTask(task);
 
         determineTaskPaddingLength();
 //        regenerateSmartNames();
@@ -146,23 +130,22 @@ void CharmDataModel::addTask(const Task &task)
 
 void CharmDataModel::modifyTask(const Task &task)
 {
-    const auto it = m_tasks.find(task.id());
-    Q_ASSERT_X(it != m_tasks.end(), Q_FUNC_INFO,
+    Q_ASSERT_X(taskExists(task.id()), Q_FUNC_INFO,
                "Task to modify has to exist");
 
-    if (it == m_tasks.end())
+    if (!taskExists(task.id()))
         return;
-    const TaskId oldParentId = it->second.task().parent();
+    const TaskId oldParentId = m_tasks.item(task.id()).task().parent();
     const bool parentChanged = task.parent() != oldParentId;
 
     if (parentChanged) {
         Q_FOREACH (auto adapter, m_adapters)
             adapter->taskParentChanged(task.id(), oldParentId, task.parent());
-        m_tasks[ task.id() ].makeChildOf(parentItem(task));
     }
 
-    m_tasks[ task.id() ].task() = task;
+    m_tasks.modifyTask(task);
     m_nameCache.modifyTask(task);
+    m_searchIndex.modifyTask(task);
 
     if (parentChanged) {
         Q_FOREACH (auto adapter, m_adapters)
@@ -184,14 +167,10 @@ void CharmDataModel::deleteTask(const Task &task)
     Q_FOREACH (auto adapter, m_adapters)
         adapter->taskAboutToBeDeleted(task.id());
 
-    const auto it = m_tasks.find(task.id());
-    if (it != m_tasks.end()) {
-        TaskTreeItem tmpParent;
-        it->second.makeChildOf(tmpParent);
-        m_tasks.erase(it);
-    }
+    m_tasks.removeTask(task.id());
 
     m_nameCache.deleteTask(task);
+    m_searchIndex.deleteTask(task);
 
     Q_FOREACH (auto adapter, m_adapters)
         adapter->taskDeleted(task.id());
@@ -199,13 +178,9 @@ void CharmDataModel::deleteTask(const Task &task)
 
 void CharmDataModel::clearTasks()
 {
-    // to clear the task list, all tasks have first to be changed to be children of the root item:
-    for (TaskTreeItem::Map::iterator it = m_tasks.begin(); it != m_tasks.end(); ++it)
-        it->second.makeChildOf(m_rootItem);
-
     m_tasks.clear();
     m_nameCache.clearTasks();
-    m_rootItem = TaskTreeItem();
+    m_searchIndex.clearTasks();
 
     Q_FOREACH (auto adapter, m_adapters)
         adapter->resetTasks();
@@ -213,19 +188,92 @@ void CharmDataModel::clearTasks()
 
 void CharmDataModel::setAllEvents(const EventList &events)
 {
+    setRecentEvents(events, QDateTime());
+}
+
+void CharmDataModel::setRecentEvents(const EventList &events, const QDateTime &since)
+{
+    m_eventsLoadedSince = since;
     m_events.clear();
+    m_eventStartIndex.clear();
+    m_durationRollup.clear();
+    m_durationRollupIsComplete = false;
+    m_events.reserve(events.size());
 
     for (int i = 0; i < events.size(); ++i) {
         if (!eventExists(events[i].id())) {
-            m_events[ events[i].id() ] = events[i];
+            m_events.insert(events[i]);
+            m_eventStartIndex.insert(events[i]);
+            m_durationRollup.addEvent(events[i]);
         } else {
-            qCritical() << "CharmDataModel::addTask: duplicate task id"
-                        << m_tasks[i].task().id() << "ignored. THIS IS A BUG";
+            qCritical() << "CharmDataModel::setRecentEvents: duplicate event id"
+                        << events[i].id() << "ignored. THIS IS A BUG";
         }
     }
 
-    Q_FOREACH (auto adapter, m_adapters)
-        adapter->resetEvents();
+    notifyEventsReset();
+}
+
+void CharmDataModel::addLoadedEvents(const EventList &events)
+{
+    int added = 0;
+    m_events.reserve(m_events.size() + events.size());
+    Q_FOREACH (const Event &event, events) {
+        // the ranges may overlap with what is loaded already:
+        if (eventExists(event.id()))
+            continue;
+        m_events.insert(event);
+        m_eventStartIndex.insert(event);
+        // a complete rollup already counts them:
+        if (!m_durationRollupIsComplete)
+            m_durationRollup.addEvent(event);
+        ++added;
+    }
+
+    if (added > 0)
+        notifyEventsReset();
+}
+
+void CharmDataModel::setDurationRollup(const DurationRollup &rollup)
+{
+    m_durationRollup = rollup;
+    m_durationRollupIsComplete = true;
+
+    notifyEventsReset();
+}
+
+const DurationRollup &CharmDataModel::durationRollup() const
+{
+    return m_durationRollup;
+}
+
+bool CharmDataModel::durationRollupIsComplete() const
+{
+    return m_durationRollupIsComplete || !m_eventsLoadedSince.isValid();
+}
+
+QDateTime CharmDataModel::eventsLoadedSince() const
+{
+    return m_eventsLoadedSince;
+}
+
+void CharmDataModel::ensureEventsLoadedSince(const QDate &date)
+{
+    const QDateTime start(date, QTime(0, 0));
+    if (!m_eventsLoadedSince.isValid() || !start.isValid() || start >= m_eventsLoadedSince)
+        return;
+    const QDateTime end = m_eventsLoadedSince;
+    m_eventsLoadedSince = start;
+    emit eventsRequested(start, end);
+}
+
+void CharmDataModel::ensureAllEventsLoaded()
+{
+    if (!m_eventsLoadedSince.isValid())
+        return;
+    const QDateTime end = m_eventsLoadedSince;
+    m_eventsLoadedSince = QDateTime();
+    emit eventsRequested(QDateTime(), end);
 }
 
 void CharmDataModel::addEvent(const Event &event)
@@ -233,13 +281,21 @@ void CharmDataModel::addEvent(const Event &event)
     Q_ASSERT_X(!eventExists(event.id()), Q_FUNC_INFO,
                "New event must have a unique id");
 
-    Q_FOREACH (auto adapter, m_adapters)
-        adapter->eventAboutToBeAdded(event.id());
+    if (m_bulkUpdateDepth > 0) {
+        queueEventChange(event.id(), EventAdded, event.taskId());
+    } else {
+        Q_FOREACH (auto adapter, m_adapters)
+            adapter->eventAboutToBeAdded(event.id());
+    }
 
-    m_events[ event.id() ] = event;
+    m_events.insert(event);
+    m_eventStartIndex.insert(event);
+    m_durationRollup.addEvent(event);
 
-    Q_FOREACH (auto adapter, m_adapters)
-        adapter->eventAdded(event.id());
+    if (m_bulkUpdateDepth == 0) {
+        Q_FOREACH (auto adapter, m_adapters)
+            adapter->eventAdded(event.id());
+    }
 }
 
 void CharmDataModel::modifyEvent(const Event &newEvent)
@@ -249,7 +305,17 @@ void CharmDataModel::modifyEvent(const Event &newEvent)
 
     const Event oldEvent = eventForId(newEvent.id());
 
-    m_events[ newEvent.id() ] = newEvent;
+    m_events.insert(newEvent);
+    m_eventStartIndex.remove(oldEvent);
+    m_eventStartIndex.insert(newEvent);
+    m_durationRollup.removeEvent(oldEvent);
+    m_durationRollup.addEvent(newEvent);
+
+    if (m_bulkUpdateDepth > 0) {
+        queueEventChange(newEvent.id(), EventModified, oldEvent.taskId());
+        m_pendingTasks.insert(newEvent.taskId());
+        return;
+    }
 
     Q_FOREACH (auto adapter, m_adapters)
         adapter->eventModified(newEvent.id(), oldEvent);
@@ -262,72 +328,134 @@ void CharmDataModel::deleteEvent(const Event &event)
     Q_ASSERT_X(!m_activeEventIds.contains(event.id()), Q_FUNC_INFO,
                "Cannot delete an active event");
 
-    Q_FOREACH (auto adapter, m_adapters)
-        adapter->eventAboutToBeDeleted(event.id());
+    if (m_bulkUpdateDepth > 0) {
+        queueEventChange(event.id(), EventRemoved, event.taskId());
+    } else {
+        Q_FOREACH (auto adapter, m_adapters)
+            adapter->eventAboutToBeDeleted(event.id());
+    }
 
-    const auto it = m_events.find(event.id());
-    if (it != m_events.end())
-        m_events.erase(it);
+    if (eventExists(event.id())) {
+        const Event oldEvent = m_events.event(event.id());
+        m_eventStartIndex.remove(oldEvent);
+        m_durationRollup.removeEvent(oldEvent);
+        m_events.remove(event.id());
+    }
 
-    Q_FOREACH (auto adapter, m_adapters)
-        adapter->eventDeleted(event.id());
+    if (m_bulkUpdateDepth == 0) {
+        Q_FOREACH (auto adapter, m_adapters)
+            adapter->eventDeleted(event.id());
+    }
 }
 
 void CharmDataModel::clearEvents()
 {
     m_events.clear();
+    m_eventStartIndex.clear();
+    m_durationRollup.clear();
+    m_durationRollupIsComplete = false;
+
+    notifyEventsReset();
+}
+
+void CharmDataModel::beginBulkUpdate()
+{
+    ++m_bulkUpdateDepth;
+}
 
+void CharmDataModel::endBulkUpdate()
+{
+    Q_ASSERT(m_bulkUpdateDepth > 0);
+    if (m_bulkUpdateDepth == 0 || --m_bulkUpdateDepth > 0)
+        return;
+
+    EventChangeSet changes;
+    for (auto it = m_pendingEventChanges.constBegin(); it != m_pendingEventChanges.constEnd(); ++it) {
+        switch (it.value()) {
+        case EventAdded:
+            changes.added << it.key();
+            break;
+        case EventModified:
+            changes.modified << it.key();
+            break;
+        case EventRemoved:
+            changes.removed << it.key();
+            break;
+        }
+    }
+    changes.tasks = m_pendingTasks.toList();
+    m_pendingEventChanges.clear();
+    m_pendingTasks.clear();
+
+    if (changes.isEmpty())
+        return;
+    std::sort(changes.added.begin(), changes.added.end());
     Q_FOREACH (auto adapter, m_adapters)
-        adapter->resetEvents();
+        adapter->eventsChanged(changes);
 }
 
-const TaskTreeItem &CharmDataModel::taskTreeItem(TaskId id) const
+void CharmDataModel::queueEventChange(EventId id, PendingEventChange change, TaskId task)
 {
-    if (id <= 0) return m_rootItem;
+    m_pendingTasks.insert(task);
+    const auto it = m_pendingEventChanges.find(id);
+    if (it == m_pendingEventChanges.end()) {
+        m_pendingEventChanges.insert(id, change);
+        return;
+    }
 
-    const auto it = m_tasks.find(id);
-    if (it == m_tasks.end()) {
-        return m_rootItem;
-    } else {
-        return it->second;
+    // combine the change with the earlier one:
+    if (change == EventRemoved && it.value() == EventAdded) {
+        m_pendingEventChanges.erase(it);
+    } else if (change == EventAdded && it.value() == EventRemoved) {
+        it.value() = EventModified;
+    } else if (change != EventModified) {
+        it.value() = change;
     }
 }
 
-const Task &CharmDataModel::getTask(TaskId id) const
+void CharmDataModel::notifyEventsReset()
 {
-    const TaskTreeItem &item = taskTreeItem(id);
-    return item.task();
+    // the adapters start over, the changes so far are included:
+    m_pendingEventChanges.clear();
+    m_pendingTasks.clear();
+    Q_FOREACH (auto adapter, m_adapters)
+        adapter->resetEvents();
 }
 
-TaskList CharmDataModel::getAllTasks() const
+TaskTreeItem CharmDataModel::taskTreeItem(TaskId id) const
 {
-    return m_rootItem.children();
+    return m_tasks.item(id);
 }
 
-Task &CharmDataModel::findTask(TaskId id)
-{   // in this (private) method, the task has to exist
-    const TaskTreeItem::Map::iterator it = m_tasks.find(id);
-    Q_ASSERT(it != m_tasks.end());
-    return it->second.task();
+const TaskTree &CharmDataModel::taskTree() const
+{
+    return m_tasks;
 }
 
-const Event &CharmDataModel::eventForId(EventId id) const
+const TaskSearchIndex &CharmDataModel::taskSearchIndex() const
 {
-    static const Event InvalidEvent;
-    EventMap::const_iterator it = m_events.find(id);
-    if (it != m_events.end()) {
-        return it->second;
-    } else {
-        return InvalidEvent;
-    }
+    return m_searchIndex;
 }
 
-Event &CharmDataModel::findEvent(int id)
+const Task &CharmDataModel::getTask(TaskId id) const
 {
-    // in this method, the event has to exist
-    const auto it = m_events.find(id);
-    Q_ASSERT(it != m_events.end());
-    return it->second;
+    return taskTreeItem(id).task();
+}
+
+TaskList CharmDataModel::getAllTasks() const
+{
+    return m_tasks.root().children();
+}
+
+const Task &CharmDataModel::findTask(TaskId id) const
+{   // in this (private) method, the task has to exist
+    Q_ASSERT(taskExists(id));
+    return m_tasks.item(id).task();
+}
+
+Event CharmDataModel::eventForId(EventId id) const
+{
+    return m_events.event(id);
 }
 
 bool CharmDataModel::activateEvent(const Event &activeEvent)
@@ -343,7 +471,7 @@ bool CharmDataModel::activateEvent(const Event &activeEvent)
                 return false;
             }
 
-            const Event &e = eventForId(m_activeEventIds[i]);
+            const Event e = eventForId(m_activeEventIds[i]);
             if (e.taskId() == taskId) {
                 Q_ASSERT(!"inconsistency (event already active for task)!");
                 return false;
@@ -354,46 +482,40 @@ bool CharmDataModel::activateEvent(const Event &activeEvent)
     m_activeEventIds << activeEvent.id();
     Q_FOREACH (auto adapter, m_adapters)
         adapter->eventActivated(activeEvent.id());
+    m_lastCheckpoints.insert(activeEvent.id(), QDateTime::currentDateTime());
     m_timer.start(10000);
     return true;
 }
 
 void CharmDataModel::determineTaskPaddingLength()
 {
-    int maxTaskId = 0;
-
-    for (TaskTreeItem::Map::iterator it = m_tasks.begin(); it != m_tasks.end(); ++it)
-        maxTaskId = qMax(maxTaskId, it->second.task().id());
+    const TaskId maxTaskId = m_tasks.maximumTaskId();
 
     QString temp;
     temp.setNum(maxTaskId);
     CONFIGURATION.taskPaddingLength = temp.length();
+    m_searchIndex.setIdPaddingLength(CONFIGURATION.taskPaddingLength);
 }
 
-TaskTreeItem &CharmDataModel::parentItem(const Task &task)
+TaskTreeItem CharmDataModel::parentItem(const Task &task) const
 {
-    TaskTreeItem &parent = m_tasks[ task.parent() ];
-    if (parent.isValid()) {
-        return parent;
-    } else {
-        return m_rootItem;
-    }
+    return m_tasks.item(task.parent());
 }
 
-bool CharmDataModel::taskExists(TaskId id)
+bool CharmDataModel::taskExists(TaskId id) const
 {
-    return m_tasks.find(id) != m_tasks.end();
+    return m_tasks.contains(id);
 }
 
 bool CharmDataModel::eventExists(EventId id)
 {
-    return m_events.find(id) != m_events.end();
+    return m_events.contains(id);
 }
 
 bool CharmDataModel::isTaskActive(TaskId id) const
 {
     for (int i = 0; i < m_activeEventIds.size(); ++i) {
-        const Event &e = eventForId(m_activeEventIds[i]);
+        const Event e = eventForId(m_activeEventIds[i]);
         Q_ASSERT(e.isValid());
         if (e.taskId() == id)
             return true;
@@ -402,17 +524,15 @@ bool CharmDataModel::isTaskActive(TaskId id) const
     return false;
 }
 
-const Event &CharmDataModel::activeEventFor(TaskId id) const
+Event CharmDataModel::activeEventFor(TaskId id) const
 {
-    static Event InvalidEvent;
-
     for (int i = 0; i < m_activeEventIds.size(); ++i) {
-        const Event &e = eventForId(m_activeEventIds[i]);
+        const Event e = eventForId(m_activeEventIds[i]);
         if (e.taskId() == id)
             return e;
     }
 
-    return InvalidEvent;
+    return Event();
 }
 
 void CharmDataModel::startEventRequested(const Task &task)
@@ -439,6 +559,7 @@ void CharmDataModel::endEventRequested(const Task &task)
         if (eventForId(m_activeEventIds[i]).taskId() == task.id()) {
             eventId = m_activeEventIds[i];
             m_activeEventIds.removeAt(i);
+            m_lastCheckpoints.remove(eventId);
             Q_FOREACH (auto adapter, m_adapters)
                 adapter->eventDeactivated(eventId);
             break;
@@ -446,9 +567,10 @@ void CharmDataModel::endEventRequested(const Task &task)
     }
 
     Q_ASSERT(eventId != 0);
-    Event &event = findEvent(eventId);
+    Event event = m_events.event(eventId);
     Event old = event;
     event.setEndDateTime(QDateTime::currentDateTime());
+    m_events.setEndDateTime(eventId, event.endDateTime());
 
     emit requestEventModification(event, old);
 
@@ -462,13 +584,15 @@ void CharmDataModel::endAllEventsRequested()
     while (!m_activeEventIds.isEmpty()) {
         EventId eventId = m_activeEventIds.first();
         m_activeEventIds.pop_front();
+        m_lastCheckpoints.remove(eventId);
         Q_FOREACH (auto adapter, m_adapters)
             adapter->eventDeactivated(eventId);
 
         Q_ASSERT(eventId != 0);
-        Event &event = findEvent(eventId);
+        Event event = m_events.event(eventId);
         Event old = event;
         event.setEndDateTime(currentDateTime);
+        m_events.setEndDateTime(eventId, event.endDateTime());
 
         emit requestEventModification(event, old);
     }
@@ -479,14 +603,31 @@ void CharmDataModel::endAllEventsRequested()
 
 void CharmDataModel::eventUpdateTimerEvent()
 {
+    const QDateTime now = QDateTime::currentDateTime();
+    // between checkpoints, only the model and the heartbeat journal are updated:
+    const int interval = CONFIGURATION.heartbeatCheckpointInterval;
+
     Q_FOREACH (EventId id, m_activeEventIds) {
-        // Not a ref (Event &), since we want to diff "old event"
+        // each active event is checkpointed on its own schedule, so that
+        // starting another event does not delay the ones already running:
+        const QDateTime lastCheckpoint = m_lastCheckpoints.value(id);
+        const bool checkpoint = interval <= 0 || !lastCheckpoint.isValid()
+                                || lastCheckpoint.secsTo(now) >= interval;
+        if (checkpoint)
+            m_lastCheckpoints[id] = now;
+
+        // a copy, since we want to diff "old event"
         // and "new event" in *Adapter::eventModified
-        Event event = findEvent(id);
+        Event event = m_events.event(id);
         Event old = event;
-        event.setEndDateTime(QDateTime::currentDateTime());
+        event.setEndDateTime(now);
 
-        emit requestEventModification(event, old);
+        if (checkpoint) {
+            emit requestEventModification(event, old);
+        } else {
+            modifyEvent(event);
+            emit eventHeartbeat(event);
+        }
     }
     updateToolTip();
 }
@@ -494,6 +635,11 @@ void CharmDataModel::eventUpdateTimerEvent()
 QString CharmDataModel::fullTaskName(const Task &task) const
 {
     if (task.isValid()) {
+        // the search index keeps the full names of the tasks in the model:
+        const Task &stored = getTask(task.id());
+        if (stored.isValid() && stored.parent() == task.parent() && stored.name() == task.name())
+            return m_searchIndex.fullName(task.id());
+
         QString name = task.name().simplified();
 
         if (task.parent() != 0) {
@@ -589,9 +735,19 @@ void CharmDataModel::updateToolTip()
     emit sysTrayUpdate(toolTip, numEvents != 0);
 }
 
-const EventMap &CharmDataModel::eventMap() const
+EventIdList CharmDataModel::eventIds() const
+{
+    return m_events.ids();
+}
+
+EventId CharmDataModel::maximumEventId() const
+{
+    return m_events.maximumId();
+}
+
+int CharmDataModel::eventCount() const
 {
-    return m_events;
+    return m_events.size();
 }
 
 bool CharmDataModel::isEventActive(EventId id) const
@@ -606,20 +762,7 @@ int CharmDataModel::activeEventCount() const
 
 EventIdList CharmDataModel::eventsThatStartInTimeFrame(const QDate &start, const QDate &end) const
 {
-    // do the comparisons in UTC, which is much faster as we only need to convert
-    // start and end date then
-    const QDateTime startUTC = QDateTime(start, QTime(0, 0, 0)).toUTC();
-    const QDateTime endUTC = QDateTime(end, QTime(0, 0, 0)).toUTC();
-    EventIdList events;
-    EventMap::const_iterator it;
-    for (it = m_events.begin();
-         it != m_events.end(); ++it) {
-        const Event &event(it->second);
-        if (event.startDateTime(Qt::UTC) >= startUTC && event.startDateTime(Qt::UTC) < endUTC)
-            events << event.id();
-    }
-
-    return events;
+    return eventIdsThatStartInTimeFrame(start, end).toList();
 }
 
 EventIdList CharmDataModel::eventsThatStartInTimeFrame(const TimeSpan &timeSpan) const
@@ -627,21 +770,32 @@ EventIdList CharmDataModel::eventsThatStartInTimeFrame(const TimeSpan &timeSpan)
     return eventsThatStartInTimeFrame(timeSpan.first, timeSpan.second);
 }
 
+EventIdRange CharmDataModel::eventIdsThatStartInTimeFrame(const QDate &start,
+                                                          const QDate &end) const
+{
+    // the index is kept in UTC, so only start and end date need to be converted:
+    const QDateTime startUTC = QDateTime(start, QTime(0, 0, 0)).toUTC();
+    const QDateTime endUTC = QDateTime(end, QTime(0, 0, 0)).toUTC();
+    return m_eventStartIndex.eventsThatStartInTimeFrame(startUTC, endUTC);
+}
+
+EventIdRange CharmDataModel::eventIdsThatStartInTimeFrame(const TimeSpan &timeSpan) const
+{
+    return eventIdsThatStartInTimeFrame(timeSpan.first, timeSpan.second);
+}
+
 bool CharmDataModel::isParentOf(TaskId parent, TaskId id) const
 {
     Q_ASSERT_X(parent != 0, Q_FUNC_INFO, "parent is invalid (0)");
 
     if (id == parent) return false;   // a task is not it's own child
     // get the item, make sure it is valid
-    const TaskTreeItem &item(taskTreeItem(id));
+    const TaskTreeItem item(taskTreeItem(id));
     Q_ASSERT_X(item.isValid(), Q_FUNC_INFO, "No such task");
     if (!item.isValid()) return false;
 
-    TaskId parentId = item.task().parent();
-
-    if (parentId == parent) return true;   // found it on the path
-    if (parentId == 0) return false;   // the task has no parent
-    return isParentOf(parent, parentId);
+    const TaskTreeItem parentItem(taskTreeItem(parent));
+    return parentItem.isValid() && parentItem.isAncestorOf(item);
 }
 
 EventIdList CharmDataModel::activeEvents() const
@@ -652,9 +806,8 @@ EventIdList CharmDataModel::activeEvents() const
 TaskIdList CharmDataModel::mostFrequentlyUsedTasks() const
 {
     std::unordered_map<TaskId, quint32 > mfuMap;
-    const EventMap& events = eventMap();
-    for( auto it : events) {
-        mfuMap[it.second.taskId()]++;
+    for( int slot = 0; slot < m_events.size(); ++slot ) {
+        mfuMap[m_events.taskIdAt( slot )]++;
     }
 
     const auto comp = []( quint32 a, quint32 b ){
@@ -676,15 +829,14 @@ TaskIdList CharmDataModel::mostFrequentlyUsedTasks() const
 
 TaskIdList CharmDataModel::mostRecentlyUsedTasks() const
 {
-    std::unordered_map<TaskId, QDateTime> mruMap;
-    const EventMap& events = eventMap();
-    for( const auto &it : events ) {
-        const TaskId id = it.second.taskId();
+    std::unordered_map<TaskId, qint64> mruMap;
+    for( int slot = 0; slot < m_events.size(); ++slot ) {
+        const TaskId id = m_events.taskIdAt( slot );
         if ( id == 0 )
             continue;
         // process use date
-        // Note: for a relative order, the UTC time is sufficient and much faster
-        const QDateTime date = it.second.startDateTime( Qt::UTC );
+        // Note: for a relative order, the seconds since the epoch are sufficient and much faster
+        const qint64 date = m_events.startSecsAt( slot );
         const auto old = mruMap.find( id );
         if ( old != mruMap.cend() ) {
             mruMap[id]= qMax( old->second, date );
@@ -692,17 +844,17 @@ TaskIdList CharmDataModel::mostRecentlyUsedTasks() const
             mruMap[id]= date;
         }
     }
-    const auto comp = [] ( const QDateTime &a, const QDateTime &b )
+    const auto comp = [] ( qint64 a, qint64 b )
     {
         return a > b;
     };
-    std::map<QDateTime, TaskId, decltype( comp )> mru( comp );
+    std::map<qint64, TaskId, decltype( comp )> mru( comp );
     for ( const auto kv : mruMap ) {
         mru[kv.second] = kv.first;
     }
     TaskIdList out;
     out.reserve( static_cast<int>( mru.size() ) );
-    std::transform( mru.cbegin(), mru.cend(), std::inserter( out, out.begin() ),  []( const std::pair<const QDateTime, TaskId> &in ) {
+    std::transform( mru.cbegin(), mru.cend(), std::inserter( out, out.begin() ),  []( const std::pair<const qint64, TaskId> &in ) {
         return in.second;
     });
     return out;
@@ -723,6 +875,10 @@ CharmDataModel *CharmDataModel::clone() const
     auto c = new CharmDataModel();
     c->setAllTasks(getAllTasks());
     c->m_events = m_events;
+    c->m_eventStartIndex = m_eventStartIndex;
+    c->m_durationRollup = m_durationRollup;
+    c->m_durationRollupIsComplete = m_durationRollupIsComplete;
     c->m_activeEventIds = m_activeEventIds;
+    c->m_eventsLoadedSince = m_eventsLoadedSince;
     return c;
 }
@@ -28,15 +28,21 @@
 #define CHARMDATAMODEL_H
 
 #include <QObject>
+#include <QHash>
+#include <QSet>
 #include <QTimer>
 
 #include "Task.h"
 #include "State.h"
 #include "Event.h"
+#include "DurationRollup.h"
+#include "EventStartIndex.h"
+#include "EventStore.h"
 #include "TimeSpans.h"
-#include "TaskTreeItem.h"
+#include "TaskTree.h"
 #include "CharmDataModelAdapterInterface.h"
 #include "SmartNameCache.h"
+#include "TaskSearchIndex.h"
 
 class QAbstractItemModel;
 
@@ -67,16 +73,25 @@ public:
         If called with Zero as the task id, it will return the
         imaginary root that has all top-levels as it's children.
     */
-    const TaskTreeItem &taskTreeItem(TaskId id) const;
+    TaskTreeItem taskTreeItem(TaskId id) const;
+    /** The task tree, to look up items by node (see TaskTreeItem::node()). */
+    const TaskTree &taskTree() const;
+    /** The index to search tasks by id and full name. */
+    const TaskSearchIndex &taskSearchIndex() const;
     /** Convenience method: retrieve the task directly. */
     const Task &getTask(TaskId id) const;
     /** Get all tasks as a TaskList.
         Warning: this might be slow. */
     TaskList getAllTasks() const;
-    /** Retrieve an event for the given event id. */
-    const Event &eventForId(EventId id) const;
-    /** Constant access to the map of events. */
-    const EventMap &eventMap() const;
+    /** Retrieve an event for the given event id.
+        The event is materialized from the event store, keep a copy instead of calling this repeatedly. */
+    Event eventForId(EventId id) const;
+    /** The ids of all events, in ascending order. */
+    EventIdList eventIds() const;
+    /** The highest event id, or 0 if there are no events. Unlike eventIds(), this does not copy anything. */
+    EventId maximumEventId() const;
+    /** The number of events in the model. */
+    int eventCount() const;
     /**
      * Get all events that start in a given time frame (e.g. a given day, a given week etc.)
      * More precisely, all events that start at or after @p start, and start before @p end (@p end excluded!)
@@ -84,11 +99,39 @@ public:
     EventIdList eventsThatStartInTimeFrame(const QDate &start, const QDate &end) const;
     // convenience overload
     EventIdList eventsThatStartInTimeFrame(const TimeSpan &timeSpan) const;
-    const Event &activeEventFor(TaskId id) const;
+    /**
+     * Same as eventsThatStartInTimeFrame, but returns a range over the start time index
+     * instead of copying the ids. The events are ordered by start time.
+     * The range is invalidated by any change to the events of the model.
+     */
+    EventIdRange eventIdsThatStartInTimeFrame(const QDate &start, const QDate &end) const;
+    // convenience overload
+    EventIdRange eventIdsThatStartInTimeFrame(const TimeSpan &timeSpan) const;
+
+    /** The model may hold only the recent events (see Configuration::eventHistoryWeeks).
+        All events that start at or after this time are loaded, and the
+        events without a start time. An invalid time means all events are loaded. */
+    QDateTime eventsLoadedSince() const;
+    /** Make sure the events that start at or after @p date are loaded.
+        Call this before looking at events in a time frame that may be older
+        than the loaded window. Adapters see a reset of the events if any
+        events have to be loaded. */
+    void ensureEventsLoadedSince(const QDate &date);
+    /** Make sure all events are loaded, see ensureEventsLoadedSince(). */
+    void ensureAllEventsLoaded();
+
+    /** The seconds per task and day, kept in sync with the events.
+        It covers all events of the storage if durationRollupIsComplete(),
+        otherwise only the loaded events. */
+    const DurationRollup &durationRollup() const;
+    bool durationRollupIsComplete() const;
+
+    Event activeEventFor(TaskId id) const;
     EventIdList activeEvents() const;
     int activeEventCount() const;
-    TaskTreeItem &parentItem(const Task &task);   // FIXME const???
-    bool taskExists(TaskId id);
+    /** The item of the parent of @p task, or the root item for top level tasks. */
+    TaskTreeItem parentItem(const Task &task) const;
+    bool taskExists(TaskId id) const;
     /** True if task is in the subtree below parent.
      * parent is not element of the subtree, and thus not it's own child. */
     bool isParentOf(TaskId parent, TaskId task) const;
@@ -114,7 +157,8 @@ public:
       * Only tasks that have been used so far will be taken into account, so the list might be empty. */
     TaskIdList mostRecentlyUsedTasks() const;
 
-    /** Create a full task name from the specified TaskId. */
+    /** The full task name: the names of the task and all its ancestors.
+        The names of the tasks in the model are cached, the returned string is shared. */
     QString fullTaskName(const Task &) const;
 
     /** Create a "smart" task name (name and shortest path that makes the name unique) from the specified TaskId. */
@@ -136,8 +180,15 @@ Q_SIGNALS:
     // be able to track time:
     void makeAndActivateEvent(const Task &);
     void requestEventModification(const Event &, const Event &);
+    // the end time of an active event has been updated in the model,
+    // but not yet in the database (see Configuration::heartbeatCheckpointInterval):
+    void eventHeartbeat(const Event &);
     void sysTrayUpdate(const QString &, bool);
     void resetGUIState();
+    /** The model needs the events that start at or after @p start and before @p end.
+        An invalid start means all events before @p end.
+        The storage answers with addLoadedEvents(). */
+    void eventsRequested(const QDateTime &start, const QDateTime &end);
 
 public Q_SLOTS:
     void setAllTasks(const TaskList &tasks);
@@ -147,34 +198,69 @@ public Q_SLOTS:
     void clearTasks();
 
     void setAllEvents(const EventList &events);
+    /** Set the events that start at or after @p since (plus those without a start time). */
+    void setRecentEvents(const EventList &events, const QDateTime &since);
+    /** Add events that have been loaded later, see eventsRequested().
+        Events that are already in the model are skipped. */
+    void addLoadedEvents(const EventList &events);
+    /** Set the rollup of all events in the storage, see durationRollup(). */
+    void setDurationRollup(const DurationRollup &rollup);
     void addEvent(const Event &);
     void modifyEvent(const Event &);
     void deleteEvent(const Event &);
     void clearEvents();
 
+    /** Queue the event notifications to the adapters until the matching
+        endBulkUpdate(), then send them as one EventChangeSet.
+        The model itself is updated right away. Calls may be nested. */
+    void beginBulkUpdate();
+    void endBulkUpdate();
+
 private:
+    enum PendingEventChange {
+        EventAdded,
+        EventModified,
+        EventRemoved
+    };
+
+    void queueEventChange(EventId id, PendingEventChange change, TaskId task);
+    void notifyEventsReset();
+
     void determineTaskPaddingLength();
     bool eventExists(EventId id);
 
-    Task &findTask(TaskId id);
-    Event &findEvent(EventId id);
+    const Task &findTask(TaskId id) const;
 
     int totalDuration() const;
     QString eventsString() const;
     QString totalDurationString() const;
     void updateToolTip();
 
-    TaskTreeItem::Map m_tasks;
-    TaskTreeItem m_rootItem;
+    TaskTree m_tasks;
 
-    EventMap m_events;
+    EventStore m_events;
+    // the events ordered by start time, kept in sync with m_events:
+    EventStartIndex m_eventStartIndex;
+    // seconds per task and day, kept in sync with m_events:
+    DurationRollup m_durationRollup;
+    // set if the rollup came from the storage and also covers the events that are not loaded:
+    bool m_durationRollupIsComplete = false;
     EventIdList m_activeEventIds;
+    // events starting before this time are not loaded yet, invalid if all are:
+    QDateTime m_eventsLoadedSince;
     // adapters are notified when the model changes
     CharmDataModelAdapterList m_adapters;
 
     // event update timer:
     QTimer m_timer;
+    // last time each active event was written to the database:
+    QHash<EventId, QDateTime> m_lastCheckpoints;
     SmartNameCache m_nameCache;
+    TaskSearchIndex m_searchIndex;
+    int m_bulkUpdateDepth = 0;
+    // the event changes of the running bulk update:
+    QHash<EventId, PendingEventChange> m_pendingEventChanges;
+    QSet<TaskId> m_pendingTasks;
 
 private Q_SLOTS:
     void eventUpdateTimerEvent();
@@ -28,6 +28,24 @@
 #include "Event.h"
 #include <QList>
 
+/** The events changed during a bulk update of the model, see
+    CharmDataModel::beginBulkUpdate(). Every event is listed once:
+    an event added and modified is only added, an event added and
+    deleted again is not listed. */
+struct EventChangeSet
+{
+    EventIdList added;
+    EventIdList modified;
+    EventIdList removed;
+    // the tasks of the changed events, before and after the changes:
+    TaskIdList tasks;
+
+    bool isEmpty() const
+    {
+        return added.isEmpty() && modified.isEmpty() && removed.isEmpty();
+    }
+};
+
 class CharmDataModelAdapterInterface
 {
 public:
@@ -51,6 +69,8 @@ public:
     virtual void eventModified(EventId id, Event discardedEvent) = 0;
     virtual void eventAboutToBeDeleted(EventId id) = 0;
     virtual void eventDeleted(EventId id) = 0;
+    // all changes of a bulk update at once, the removed events are already gone:
+    virtual void eventsChanged(const EventChangeSet &changes) = 0;
 
     virtual void eventActivated(EventId id) = 0;
     virtual void eventDeactivated(EventId id) = 0;
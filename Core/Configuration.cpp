@@ -81,7 +81,10 @@ bool Configuration::operator==(const Configuration &other) const
            && installationId == other.installationId
            && localStorageType == other.localStorageType
            && localStorageDatabase == other.localStorageDatabase
-           && numberOfTaskSelectorEntries == other.numberOfTaskSelectorEntries;
+           && numberOfTaskSelectorEntries == other.numberOfTaskSelectorEntries
+           && heartbeatCheckpointInterval == other.heartbeatCheckpointInterval
+           && databaseDurability == other.databaseDurability
+           && eventHistoryWeeks == other.eventHistoryWeeks;
 }
 
 void Configuration::writeTo(QSettings &settings)
@@ -151,7 +154,10 @@ void Configuration::dump(const QString &why)
              << "--> warnUnuploadedTimesheets: " << warnUnuploadedTimesheets << endl
              << "--> requestEventComment:      " << requestEventComment << endl
              << "--> enableCommandInterface:   " << enableCommandInterface
-             << "--> numberOfTaskSelectorEntries: " << numberOfTaskSelectorEntries;
+             << "--> numberOfTaskSelectorEntries: " << numberOfTaskSelectorEntries
+             << "--> heartbeatCheckpointInterval: " << heartbeatCheckpointInterval
+             << "--> databaseDurability:       " << databaseDurability
+             << "--> eventHistoryWeeks:        " << eventHistoryWeeks;
 }
 
 quint32 Configuration::createInstallationId() const
@@ -54,6 +54,14 @@ public:
         Decimal
     };
 
+    // trade-off between durability and write speed of the local database:
+    enum DatabaseDurability {
+        DatabaseDurability_Safe = 0,
+        DatabaseDurability_Balanced,
+        DatabaseDurability_Fast,
+        DatabaseDurability_NumberOfProfiles
+    };
+
     bool operator==(const Configuration &other) const;
 
     static Configuration &instance();
@@ -81,6 +89,11 @@ public:
     bool requestEventComment = false;
     bool enableCommandInterface = false;
     int numberOfTaskSelectorEntries = 5;
+    // seconds between database writes of active events, 0 writes every update:
+    int heartbeatCheckpointInterval = 300;
+    DatabaseDurability databaseDurability = DatabaseDurability_Balanced;
+    // weeks of events loaded at startup, before the current week (0 loads all events):
+    int eventHistoryWeeks = 8;
 
     // these are stored in QSettings, since we need this information to locate and open the database:
     QString configurationName;
@@ -29,12 +29,18 @@
 #include "CharmConstants.h"
 #include "CharmExceptions.h"
 #include "Configuration.h"
+#include "DatabaseXmlExporter.h"
+#include "Dates.h"
 #include "Event.h"
+#include "GzipDevice.h"
+#include "ModelSnapshot.h"
 #include "SqLiteStorage.h"
 #include "SqlRaiiTransactor.h"
 #include "SqlStorage.h"
 #include "Task.h"
+#include "TaskListValidator.h"
 
+#include <QBuffer>
 #include <QtDebug>
 
 Controller::Controller(QObject *parent_)
@@ -76,9 +82,27 @@ Event Controller::cloneEvent(const Event &e)
     return event;
 }
 
+EventList Controller::cloneEvents(const EventList &events)
+{
+    SqlRaiiTransactor transactor(m_storage->database());
+    const EventIdList ids = m_storage->addEvents(events, transactor);
+    if (ids.size() != events.size() || !transactor.commit())
+        return EventList();
+
+    EventList added = events;
+    emit bulkUpdateStarted();
+    for (int i = 0; i < added.size(); ++i) {
+        added[i].setId(ids.at(i));
+        emit eventAdded(added.at(i));
+    }
+    emit bulkUpdateFinished();
+    return added;
+}
+
 bool Controller::modifyEvent(const Event &e)
 {
     if (m_storage->modifyEvent(e)) {
+        m_heartbeatJournal.checkpointed(e.id());
         emit eventModified(e);
         return true;
     } else {
@@ -96,6 +120,28 @@ bool Controller::deleteEvent(const Event &e)
     }
 }
 
+bool Controller::applyEventChanges(EventList &added, const EventList &modified,
+                                   const EventList &deleted)
+{
+    EventIdList ids;
+    if (!m_storage->applyEventChanges(added, modified, deleted, ids))
+        return false;
+
+    emit bulkUpdateStarted();
+    for (int i = 0; i < added.size(); ++i) {
+        added[i].setId(ids.at(i));
+        emit eventAdded(added.at(i));
+    }
+    Q_FOREACH (const Event &event, modified) {
+        m_heartbeatJournal.checkpointed(event.id());
+        emit eventModified(event);
+    }
+    Q_FOREACH (const Event &event, deleted)
+        emit eventDeleted(event);
+    emit bulkUpdateFinished();
+    return true;
+}
+
 bool Controller::addTask(const Task &task)
 {
     if (m_storage->addTask(task)) {
@@ -149,6 +195,19 @@ bool Controller::setAllTasks(const TaskList &tasks)
     }
 }
 
+bool Controller::applyTaskChanges(const TaskList &added, const TaskList &modified)
+{
+    if (!m_storage->applyTaskChanges(added, modified))
+        return false;
+
+    Q_FOREACH (const Task &task, added)
+        emit taskAdded(task);
+    // the stored tasks carry the user's subscriptions:
+    Q_FOREACH (const Task &task, modified)
+        emit taskUpdated(m_storage->getTask(task.id()));
+    return true;
+}
+
 void Controller::updateSubscriptionForTask(const Task &task)
 {
     if (task.subscribed()) {
@@ -169,27 +228,39 @@ void Controller::stateChanged(State previous, State next)
     switch (next) {
     case Connected:
     {   // yes, it is that simple:
-        TaskList tasks = m_storage->getAllTasks();
+        replayHeartbeatJournal();
+        const QDateTime since = eventHistoryStart();
+        TaskList tasks;
+        EventList events;
+        if (!loadSnapshot(&tasks, &events, since)) {
+            tasks = m_storage->getAllTasks();
+            events = since.isValid() ? m_storage->getEventsStartingSince(since)
+                                     : m_storage->getAllEvents();
+        }
         // tell the view about the existing tasks;
-        if (!Task::checkForUniqueTaskIds(tasks)) {
+        const TaskListValidator validator(tasks);
+        if (!validator.hasUniqueTaskIds()) {
             throw CharmException(tr(
                                      "The Charm database is corrupted, it contains duplicate task ids. "
-                                     "Please have it looked after by a professional."));
+                                     "Please have it looked after by a professional.")
+                                 + QLatin1Char('\n') + validator.problemsDescription());
         }
-        if (!Task::checkForTreeness(tasks)) {
+        if (!validator.isValid()) {
             throw CharmException(tr(
                                      "The Charm database is corrupted, the tasks do not form a tree. "
-                                     "Please have it looked after by a professional."));
+                                     "Please have it looked after by a professional.")
+                                 + QLatin1Char('\n') + validator.problemsDescription());
         }
         emit definedTasks(tasks);
-        EventList events = m_storage->getAllEvents();
-        emit allEvents(events);
+        emitEvents(events, since);
         break;
     }
     case Disconnecting:
     {
         emit readyToQuit();
+        m_heartbeatJournal.close();
         if (m_storage) {
+            writeSnapshot();
 // this will still leave Qt complaining about a repeated connection
             m_storage->disconnect();
             delete m_storage;
@@ -237,7 +308,13 @@ void Controller::persistMetaData(Configuration &configuration)
         { MetaKey_Key_EnableCommandInterface,
           stringForBool(configuration.enableCommandInterface) },
         { MetaKey_Key_NumberOfTaskSelectorEntries,
-          QString::number(configuration.numberOfTaskSelectorEntries) }
+          QString::number(configuration.numberOfTaskSelectorEntries) },
+        { MetaKey_Key_HeartbeatCheckpointInterval,
+          QString::number(configuration.heartbeatCheckpointInterval) },
+        { MetaKey_Key_DatabaseDurability,
+          QString::number(configuration.databaseDurability) },
+        { MetaKey_Key_EventHistoryWeeks,
+          QString::number(configuration.eventHistoryWeeks) }
     };
     int NumberOfSettings = sizeof settings / sizeof settings[0];
 
@@ -246,6 +323,7 @@ void Controller::persistMetaData(Configuration &configuration)
         good = good && m_storage->setMetaData(settings[i].key, settings[i].value);
     Q_ASSERT_X(good, Q_FUNC_INFO, "Controller assumes write "
                                   "permissions in meta data table if persistMetaData is called");
+    m_storage->setDurability(configuration.databaseDurability);
     CONFIGURATION.dump();
 }
 
@@ -274,6 +352,14 @@ void Controller::provideMetaData(Configuration &configuration)
     loadConfigValue(MetaKey_Key_EnableCommandInterface, configuration.enableCommandInterface);
     loadConfigValue(MetaKey_Key_NumberOfTaskSelectorEntries, configuration.numberOfTaskSelectorEntries);
     configuration.numberOfTaskSelectorEntries = qMax(0, configuration.numberOfTaskSelectorEntries);
+    loadConfigValue(MetaKey_Key_HeartbeatCheckpointInterval, configuration.heartbeatCheckpointInterval);
+    configuration.heartbeatCheckpointInterval = qMax(0, configuration.heartbeatCheckpointInterval);
+    loadConfigValue(MetaKey_Key_EventHistoryWeeks, configuration.eventHistoryWeeks);
+    configuration.eventHistoryWeeks = qMax(0, configuration.eventHistoryWeeks);
+    loadConfigValue(MetaKey_Key_DatabaseDurability, configuration.databaseDurability);
+    if (configuration.databaseDurability < 0
+        || configuration.databaseDurability >= Configuration::DatabaseDurability_NumberOfProfiles)
+        configuration.databaseDurability = Configuration::DatabaseDurability_Balanced;
 
     CONFIGURATION.dump();
 }
@@ -297,6 +383,9 @@ bool Controller::connectToBackend()
 {
     bool result = m_storage->connect(CONFIGURATION);
 
+    if (result && !CONFIGURATION.localStorageDatabase.isEmpty())
+        m_heartbeatJournal.open(HeartbeatJournal::journalFileName(CONFIGURATION.localStorageDatabase));
+
     // the user id in the database, and the installation id, do not
     // have to be 1 and 1, as we have guessed --> persist configuration
     if (result && !CONFIGURATION.newDatabase)
@@ -324,30 +413,86 @@ void Controller::rollbackCommand(CharmCommand *command)
     emit commandCompleted(command);
 }
 
+void Controller::recordHeartbeat(const Event &event)
+{
+    if (!m_heartbeatJournal.record(event)) {
+        // no journal, write through:
+        modifyEvent(event);
+    }
+}
+
+void Controller::replayHeartbeatJournal()
+{
+    const QHash<EventId, QDateTime> entries = m_heartbeatJournal.entries();
+    if (entries.isEmpty())
+        return;
+
+    SqlRaiiTransactor transactor(m_storage->database());
+    for (auto it = entries.constBegin(); it != entries.constEnd(); ++it) {
+        Event event = m_storage->getEvent(it.key());
+        if (!event.isValid())
+            continue;
+        const QDateTime end = event.endDateTime(Qt::UTC);
+        if (end.isValid() && end >= it.value())
+            continue;
+        qDebug() << "Controller::replayHeartbeatJournal: recovering end time of event"
+                 << event.id();
+        event.setEndDateTime(it.value());
+        if (!m_storage->modifyEvent(event, transactor))
+            return;
+    }
+    if (transactor.commit())
+        m_heartbeatJournal.clear();
+}
+
+bool Controller::loadSnapshot(TaskList *tasks, EventList *events, const QDateTime &since)
+{
+    const QString fileName = m_storage->snapshotFileName();
+    const qint64 counter = m_storage->changeCounter();
+    if (fileName.isEmpty() || counter < 0)
+        return false;
+    return ModelSnapshot::read(fileName, counter, tasks, events, since);
+}
+
+void Controller::writeSnapshot()
+{
+    const QString fileName = m_storage->snapshotFileName();
+    if (fileName.isEmpty())
+        return;
+
+    try {
+        // read the counter and the contents in one transaction, so that they match:
+        SqlRaiiTransactor transactor(m_storage->database());
+        const qint64 counter = m_storage->changeCounter();
+        if (counter < 0)
+            return;
+        const TaskList tasks = m_storage->getAllTasks();
+        const EventList events = m_storage->getAllEvents();
+        transactor.commit();
+        ModelSnapshot::write(fileName, counter, tasks, events);
+    } catch (const TransactionException &e) {
+        qWarning() << "Controller::writeSnapshot: cannot read the database:" << e.what();
+    }
+}
+
 SqlStorage *Controller::storage()
 {
     return m_storage;
 }
 
-const QString MetaDataElement(QStringLiteral("metadata"));
-const QString ExportRootElement(QStringLiteral("charmdatabase"));
-const QString VersionElement(QStringLiteral("version"));
-const QString TasksElement(QStringLiteral("tasks"));
-const QString EventsElement(QStringLiteral("events"));
-
 QDomDocument Controller::exportDatabasetoXml() const
 {
     QDomDocument document(QStringLiteral("charmdatabase"));
     // root element:
-    QDomElement root = document.createElement(ExportRootElement);
-    root.setAttribute(VersionElement, CHARM_DATABASE_VERSION);
+    QDomElement root = document.createElement(DatabaseExportRootElement);
+    root.setAttribute(DatabaseExportVersionAttribute, CHARM_DATABASE_VERSION);
     document.appendChild(root);
     // metadata:
-    QDomElement metadata = document.createElement(MetaDataElement);
+    QDomElement metadata = document.createElement(DatabaseExportMetaDataElement);
     // I am not so sure what kind of metadata needs to be stored
     root.appendChild(metadata);
     // tasks element:
-    QDomElement tasksElement = document.createElement(TasksElement);
+    QDomElement tasksElement = document.createElement(DatabaseExportTasksElement);
     // FIXME there are generic methods for that now, in Task.h
     TaskList tasks = m_storage->getAllTasks();
     Q_FOREACH (const Task &task, tasks) {
@@ -356,7 +501,7 @@ QDomDocument Controller::exportDatabasetoXml() const
     }
     root.appendChild(tasksElement);
     // events element:
-    QDomElement eventsElement = document.createElement(EventsElement);
+    QDomElement eventsElement = document.createElement(DatabaseExportEventsElement);
     EventList events = m_storage->getAllEvents();
     Q_FOREACH (const Event &event, events) {
         QDomElement element = event.toXml(document);
@@ -366,6 +511,15 @@ QDomDocument Controller::exportDatabasetoXml() const
     return document;
 }
 
+QString Controller::exportDatabasetoXml(QIODevice *device, bool compressed) const
+{
+    DatabaseXmlExporter exporter(m_storage);
+    exporter.setCompressed(compressed);
+    if (!exporter.exportTo(device))
+        return exporter.errorString();
+    return QString();
+}
+
 class MakeSureTheModelIsUpdated
 {
 public:
@@ -386,57 +540,37 @@ private:
 
 QString Controller::importDatabaseFromXml(const QDomDocument &document)
 {
-    MakeSureTheModelIsUpdated m(this);
+    QByteArray data = document.toByteArray();
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::ReadOnly);
+    return importDatabaseFromXml(&buffer);
+}
 
-    // first, parse the XML document, and break if there is an error
-    // (not touching the DB contents):
-    TaskList importedTasks;
-    EventList importedEvents;
-    int databaseSchemaVersion;
+QString Controller::importDatabaseFromXml(QIODevice *device,
+                                          const DatabaseXmlImporter::ProgressCallback &progress)
+{
+    MakeSureTheModelIsUpdated m(this);
 
-    // FIXME test for the file to be a database export, not (for example) a task definitions export
-    try {
-        QDomElement rootElement = document.documentElement();
-        bool ok;
-        databaseSchemaVersion = rootElement.attribute(QStringLiteral("version")).toInt(&ok);
-        if (!ok) throw XmlSerializationException(QObject::tr(
-                                                     "Syntax error, no version attribute found."));
-
-        QDomElement tasksElement = rootElement.firstChildElement(TasksElement);
-        for (QDomElement element = tasksElement.firstChildElement(Task::tagName());
-             !element.isNull(); element = element.nextSiblingElement(Task::tagName())) {
-            Task task = Task::fromXml(element, databaseSchemaVersion);
-            if (!task.isValid()) {
-                qDebug() << "The following task is invalid and will not be added:";
-                task.dump();
-                // return tr( "The Export file contains at least one invalid task." );
-            } else {
-                importedTasks.append(task);
-            }
-        }
-        QDomElement eventsElement = rootElement.firstChildElement(EventsElement);
-        for (QDomElement element = eventsElement.firstChildElement(Event::tagName());
-             !element.isNull(); element = element.nextSiblingElement(Event::tagName())) {
-            Event event = Event::fromXml(element, databaseSchemaVersion);
-            if (!event.isValid()) {
-                qDebug() << "The following event is invalid and will not be added:";
-                event.dump();
-                // return tr( "The Export file contains at least one invalid event." );
-            } else {
-                importedEvents.append(event);
-            }
+    DatabaseXmlImporter importer(m_storage, CONFIGURATION.user);
+    importer.setProgressCallback(progress);
+
+    GzipDevice decompressor(device);
+    QIODevice *input = device;
+    if (GzipDevice::isGzipped(device)) {
+        if (!decompressor.open(QIODevice::ReadOnly))
+            return decompressor.errorString();
+        input = &decompressor;
+        // the decompressed stream has no position, report the one in the compressed data:
+        if (progress) {
+            importer.setProgressCallback([device, &progress](qint64, qint64) {
+                return progress(device->pos(), device->size());
+            });
         }
-    } catch (const XmlSerializationException &e) {
-        qDebug() << "Controller::importDatabaseFromXml: things fucked up:" << e.what();
-        return tr("The export file is invalid: %1").arg(e.what());
     }
 
-    const QString error = m_storage->setAllTasksAndEvents(CONFIGURATION.user, importedTasks,
-                                                          importedEvents);
-    if (!error.isEmpty()) {
+    if (!importer.import(input)) {
         // the database should be unchanged, and the model will update on return
-        return tr("Error importing tasks and events from the file:<br />%1")
-               .arg(error);
+        return importer.errorString();
     }
 
     // FIXME needed?
@@ -453,6 +587,39 @@ void Controller::updateModelEventsAndTasks()
     TaskList tasks = m_storage->getAllTasks();
     // tell the view about the existing tasks;
     emit definedTasks(tasks);
-    EventList events = m_storage->getAllEvents();
-    emit allEvents(events);
+    const QDateTime since = eventHistoryStart();
+    if (since.isValid())
+        emitEvents(m_storage->getEventsStartingSince(since), since);
+    else
+        emitEvents(m_storage->getAllEvents(), since);
+}
+
+QDateTime Controller::eventHistoryStart() const
+{
+    if (CONFIGURATION.eventHistoryWeeks <= 0)
+        return QDateTime();
+    const QDate weekStart = Charm::weekDayInWeekOf(Qt::Monday, QDate::currentDate());
+    return QDateTime(weekStart.addDays(-7 * CONFIGURATION.eventHistoryWeeks), QTime(0, 0));
+}
+
+void Controller::emitEvents(const EventList &events, const QDateTime &since)
+{
+    if (since.isValid()) {
+        emit recentEvents(events, since);
+        // the reports can show older time frames without loading their events:
+        DurationRollup rollup;
+        if (m_storage->getDurationRollup(&rollup))
+            emit durationRollupLoaded(rollup);
+    } else {
+        emit allEvents(events);
+    }
+}
+
+void Controller::loadEvents(const QDateTime &start, const QDateTime &end)
+{
+    if (!m_storage)
+        return;
+    const EventList events = m_storage->getEventsThatStartInTimeFrame(start, end);
+    if (!events.isEmpty())
+        emit eventsLoaded(events);
 }
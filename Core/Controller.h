@@ -28,12 +28,16 @@
 
 #include <QObject>
 
+#include "DatabaseXmlImporter.h"
+#include "DurationRollup.h"
 #include "Event.h"
+#include "HeartbeatJournal.h"
 #include "Task.h"
 #include "State.h"
 
 class CharmCommand;
 class Configuration;
+class QIODevice;
 class SqlStorage;
 
 class Controller : public QObject
@@ -75,12 +79,20 @@ public:
     /** Add an event, copying data from another event. */
     Event cloneEvent(const Event &);
 
+    /** Add copies of all the events in a single transaction.
+        Return the added events (with their new ids), or an empty list if it fails. */
+    EventList cloneEvents(const EventList &);
+
     /** Modify an event. */
     bool modifyEvent(const Event &);
 
     /** Delete an event. */
     bool deleteEvent(const Event &);
 
+    /** Add, modify and delete events in a single transaction. The added
+        events get their new ids. The view is notified in one bulk update. */
+    bool applyEventChanges(EventList &added, const EventList &modified, const EventList &deleted);
+
     /** Add a task, and send the result to the view as a signal. */
     bool addTask(const Task &parent);
 
@@ -93,15 +105,34 @@ public:
     /** Set all tasks. Updates the view, after. */
     bool setAllTasks(const TaskList &);
 
+    /** Add and modify tasks in one go, as the result of a task list
+     *  merge. The view is notified per task, so it keeps its state. */
+    bool applyTaskChanges(const TaskList &added, const TaskList &modified);
+
     /** Export the database contents into a XML document. */
     QDomDocument exportDatabasetoXml() const;
 
+    /** Write the database contents to @p device, see DatabaseXmlExporter.
+     *  @param compressed compress the export with gzip
+     *  @return An empty string on no error, an human-readable error message otherwise.
+     */
+    QString exportDatabasetoXml(QIODevice *device, bool compressed = false) const;
+
     /** Import the content of the Xml document into the currently open database.
      *  This will modify the database.
      *  @return An empty string on no error, an human-readable error message otherwise.
      */
     QString importDatabaseFromXml(const QDomDocument &);
 
+    /** Import a database export read from @p device, see DatabaseXmlImporter.
+     *  Compressed exports are decompressed on the fly.
+     *  The progress callback may cancel the import, the database is unchanged then.
+     *  @return An empty string on no error, an human-readable error message otherwise.
+     */
+    QString importDatabaseFromXml(QIODevice *device,
+                                  const DatabaseXmlImporter::ProgressCallback &progress
+                                      = DatabaseXmlImporter::ProgressCallback());
+
     void updateModelEventsAndTasks();
 
 public Q_SLOTS:
@@ -111,6 +142,13 @@ public Q_SLOTS:
     /** Receive an undo command from the view. */
     void rollbackCommand(CharmCommand *);
 
+    /** Record the running end time of an active event in the heartbeat journal.
+        The event itself is written to the database at the next checkpoint. */
+    void recordHeartbeat(const Event &);
+
+    /** Load events outside of the window loaded at startup, see CharmDataModel::eventsRequested(). */
+    void loadEvents(const QDateTime &start, const QDateTime &end);
+
 Q_SIGNALS:
     /** Added an event. */
     void eventAdded(const Event &event);
@@ -121,8 +159,23 @@ Q_SIGNALS:
     /** Deleted an event. */
     void eventDeleted(const Event &event);
 
+    /** The event signals until bulkUpdateFinished() belong to one change,
+        see CharmDataModel::beginBulkUpdate(). */
+    void bulkUpdateStarted();
+    void bulkUpdateFinished();
+
     void allEvents(const EventList &);
 
+    /** The events that start at or after @p since, see Configuration::eventHistoryWeeks. */
+    void recentEvents(const EventList &, const QDateTime &since);
+
+    /** Events loaded on request, in addition to the recent events. */
+    void eventsLoaded(const EventList &);
+
+    /** The seconds per task and day of all events in the storage,
+        sent after the recent events if the storage keeps them. */
+    void durationRollupLoaded(const DurationRollup &);
+
     /** This sends out the current task list. */
     void definedTasks(const TaskList &);
 
@@ -151,9 +204,21 @@ Q_SIGNALS:
 
 private:
     void updateSubscriptionForTask(const Task &);
+    /** Apply the end times left in the heartbeat journal by a crashed session. */
+    void replayHeartbeatJournal();
+    /** Load tasks and events from the model snapshot, if it is up to date.
+        If @p since is valid, only the events from then on are loaded. */
+    bool loadSnapshot(TaskList *tasks, EventList *events, const QDateTime &since);
+    /** The start of the event window loaded at startup, invalid if all events are loaded. */
+    QDateTime eventHistoryStart() const;
+    /** Send @p events (all events since @p since) to the model. */
+    void emitEvents(const EventList &events, const QDateTime &since);
+    /** Save the database contents in a snapshot for the next start. */
+    void writeSnapshot();
 
     template<class T> void loadConfigValue(const QString &key, T &configValue) const;
     SqlStorage *m_storage = nullptr;
+    HeartbeatJournal m_heartbeatJournal;
 };
 
 #endif
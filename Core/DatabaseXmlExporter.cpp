@@ -0,0 +1,128 @@
+/*
+  DatabaseXmlExporter.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "DatabaseXmlExporter.h"
+#include "CharmConstants.h"
+#include "GzipDevice.h"
+#include "SqlStorage.h"
+
+#include <QIODevice>
+#include <QXmlStreamWriter>
+
+DatabaseXmlExporter::DatabaseXmlExporter(SqlStorage *storage)
+    : m_storage(storage)
+{
+    Q_ASSERT(m_storage);
+}
+
+void DatabaseXmlExporter::setCompressed(bool compressed)
+{
+    m_compressed = compressed;
+}
+
+bool DatabaseXmlExporter::isCompressed() const
+{
+    return m_compressed;
+}
+
+QString DatabaseXmlExporter::errorString() const
+{
+    return m_error;
+}
+
+int DatabaseXmlExporter::exportedTaskCount() const
+{
+    return m_taskCount;
+}
+
+int DatabaseXmlExporter::exportedEventCount() const
+{
+    return m_eventCount;
+}
+
+bool DatabaseXmlExporter::exportTo(QIODevice *device)
+{
+    m_taskCount = 0;
+    m_eventCount = 0;
+    m_error.clear();
+
+    if (!m_compressed) {
+        QXmlStreamWriter writer(device);
+        return writeExport(writer);
+    }
+
+    GzipDevice compressor(device);
+    if (!compressor.open(QIODevice::WriteOnly)) {
+        m_error = QObject::tr("Cannot compress the export: %1").arg(compressor.errorString());
+        return false;
+    }
+    QXmlStreamWriter writer(&compressor);
+    if (!writeExport(writer))
+        return false;
+    if (!compressor.finish()) {
+        m_error = QObject::tr("Cannot write the export: %1").arg(compressor.errorString());
+        return false;
+    }
+    return true;
+}
+
+bool DatabaseXmlExporter::writeExport(QXmlStreamWriter &writer)
+{
+    writer.setAutoFormatting(true);
+    writer.setAutoFormattingIndent(4);
+    writer.writeStartDocument();
+    writer.writeDTD(QStringLiteral("<!DOCTYPE %1>").arg(DatabaseExportRootElement));
+    writer.writeStartElement(DatabaseExportRootElement);
+    writer.writeAttribute(DatabaseExportVersionAttribute, QString::number(CHARM_DATABASE_VERSION));
+    writer.writeEmptyElement(DatabaseExportMetaDataElement);
+
+    writer.writeStartElement(DatabaseExportTasksElement);
+    const bool tasksRead = m_storage->visitAllTasks([&](const Task &task) {
+        task.toXml(writer);
+        ++m_taskCount;
+        return !writer.hasError();
+    });
+    writer.writeEndElement();
+
+    bool eventsRead = false;
+    if (tasksRead) {
+        writer.writeStartElement(DatabaseExportEventsElement);
+        eventsRead = m_storage->visitAllEvents([&](const Event &event) {
+            event.toXml(writer);
+            ++m_eventCount;
+            return !writer.hasError();
+        });
+        writer.writeEndElement();
+    }
+
+    writer.writeEndElement();
+    writer.writeEndDocument();
+
+    if (writer.hasError()) {
+        m_error = QObject::tr("Cannot write the export: %1").arg(writer.device()->errorString());
+        return false;
+    }
+    if (!tasksRead || !eventsRead) {
+        m_error = QObject::tr("Cannot read the tasks and events from the database.");
+        return false;
+    }
+    return true;
+}
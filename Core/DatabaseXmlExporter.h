@@ -0,0 +1,67 @@
+/*
+  DatabaseXmlExporter.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef DATABASEXMLEXPORTER_H
+#define DATABASEXMLEXPORTER_H
+
+#include <QString>
+
+class QIODevice;
+class QXmlStreamWriter;
+class SqlStorage;
+
+/** DatabaseXmlExporter writes all tasks and events of the storage as
+    a database export.
+    Tasks and events are read with forward-only queries and written to
+    the device with a QXmlStreamWriter as they come in, so the memory
+    used does not depend on the size of the database. The output is
+    the same format that Controller::exportDatabasetoXml() produces
+    and that DatabaseXmlImporter reads. Optionally, it is compressed
+    with gzip.
+*/
+class DatabaseXmlExporter
+{
+public:
+    explicit DatabaseXmlExporter(SqlStorage *storage);
+
+    /** Compress the output with gzip. The default is false. */
+    void setCompressed(bool compressed);
+    bool isCompressed() const;
+
+    /** Write the export to @p device, which has to be open for writing.
+        @return true if successful, otherwise errorString() describes the problem. */
+    bool exportTo(QIODevice *device);
+
+    QString errorString() const;
+    int exportedTaskCount() const;
+    int exportedEventCount() const;
+
+private:
+    bool writeExport(QXmlStreamWriter &writer);
+
+    SqlStorage *m_storage;
+    bool m_compressed = false;
+    int m_taskCount = 0;
+    int m_eventCount = 0;
+    QString m_error;
+};
+
+#endif
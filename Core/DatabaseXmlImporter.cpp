@@ -0,0 +1,277 @@
+/*
+  DatabaseXmlImporter.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "DatabaseXmlImporter.h"
+#include "CharmConstants.h"
+#include "CharmExceptions.h"
+#include "SqlRaiiTransactor.h"
+#include "SqlStorage.h"
+
+#include <QDomDocument>
+#include <QIODevice>
+#include <QXmlStreamReader>
+#include <QtDebug>
+
+namespace {
+// how often (in elements) the progress callback is called:
+const int ProgressInterval = 100;
+}
+
+DatabaseXmlImporter::DatabaseXmlImporter(SqlStorage *storage, const User &user)
+    : m_storage(storage)
+    , m_user(user)
+{
+    Q_ASSERT(m_storage);
+}
+
+void DatabaseXmlImporter::setProgressCallback(const ProgressCallback &callback)
+{
+    m_progress = callback;
+}
+
+void DatabaseXmlImporter::setBatchSize(int size)
+{
+    m_batchSize = qMax(1, size);
+}
+
+QString DatabaseXmlImporter::errorString() const
+{
+    return m_error;
+}
+
+bool DatabaseXmlImporter::wasCanceled() const
+{
+    return m_canceled;
+}
+
+int DatabaseXmlImporter::importedTaskCount() const
+{
+    return m_taskCount;
+}
+
+int DatabaseXmlImporter::importedEventCount() const
+{
+    return m_eventCount;
+}
+
+bool DatabaseXmlImporter::import(QIODevice *device)
+{
+    m_device = device;
+    m_taskIds.clear();
+    m_tasksRead = false;
+    m_pendingEvents.clear();
+    m_elementCount = 0;
+    m_taskCount = 0;
+    m_eventCount = 0;
+    m_canceled = false;
+    m_error.clear();
+
+    SqlRaiiTransactor transactor(m_storage->database());
+    if (!m_storage->deleteAllEvents(transactor))
+        return storageError(QObject::tr("Error deleting the existing events."));
+    if (!m_storage->deleteAllTasks(transactor))
+        return storageError(QObject::tr("Error deleting the existing tasks."));
+
+    QXmlStreamReader reader(device);
+    try {
+        if (!readExport(reader, transactor))
+            return false;
+    } catch (const XmlSerializationException &e) {
+        qDebug() << "DatabaseXmlImporter::import: invalid export:" << e.what();
+        m_error = QObject::tr("The export file is invalid: %1").arg(e.what());
+        return false;
+    }
+
+    // events that refer to tasks that are not part of the export are dropped:
+    m_tasksRead = true;
+    if (!flushEvents(transactor))
+        return false;
+    if (!transactor.commit())
+        return storageError(QObject::tr("Cannot commit the imported tasks and events."));
+    return true;
+}
+
+bool DatabaseXmlImporter::readExport(QXmlStreamReader &reader, const SqlRaiiTransactor &transactor)
+{
+    if (reader.readNextStartElement()) {
+        bool ok;
+        const int databaseSchemaVersion = reader.attributes().value(DatabaseExportVersionAttribute)
+                                          .toString().toInt(&ok);
+        if (!ok) {
+            throw XmlSerializationException(QObject::tr(
+                                                "Syntax error, no version attribute found."));
+        }
+
+        // like the DOM readers, only look at the first tasks and events elements:
+        bool tasksFound = false;
+        bool eventsFound = false;
+        while (reader.readNextStartElement()) {
+            if (!tasksFound && reader.name() == DatabaseExportTasksElement) {
+                tasksFound = true;
+                if (!readTasks(reader, databaseSchemaVersion, transactor))
+                    return false;
+                m_tasksRead = true;
+                if (!flushEvents(transactor))
+                    return false;
+            } else if (!eventsFound && reader.name() == DatabaseExportEventsElement) {
+                eventsFound = true;
+                if (!readEvents(reader, databaseSchemaVersion, transactor))
+                    return false;
+            } else {
+                reader.skipCurrentElement();
+            }
+        }
+    }
+
+    // the rest of the document still has to be well-formed:
+    while (!reader.atEnd())
+        reader.readNext();
+    if (reader.hasError()) {
+        m_error = QObject::tr("Cannot read the XML syntax of the specified file: [%1:%2] %3")
+                  .arg(QString::number(reader.lineNumber()),
+                       QString::number(reader.columnNumber()),
+                       reader.errorString());
+        return false;
+    }
+    return true;
+}
+
+bool DatabaseXmlImporter::readTasks(QXmlStreamReader &reader, int databaseSchemaVersion,
+                                    const SqlRaiiTransactor &transactor)
+{
+    while (reader.readNextStartElement()) {
+        if (reader.name() != Task::tagName()) {
+            reader.skipCurrentElement();
+            continue;
+        }
+
+        QDomDocument document;
+        const Task task = Task::fromXml(readElement(reader, document), databaseSchemaVersion);
+        if (!task.isValid()) {
+            qDebug() << "The following task is invalid and will not be added:";
+            task.dump();
+            continue;
+        }
+
+        if (!m_storage->addTask(task, transactor))
+            return storageError(QObject::tr("Cannot add imported tasks."));
+        const bool result = task.subscribed() ? m_storage->addSubscription(m_user, task)
+                                              : m_storage->deleteSubscription(m_user, task);
+        if (!result)
+            return storageError(QObject::tr("Cannot add imported tasks."));
+        m_taskIds.insert(task.id());
+        ++m_taskCount;
+
+        if (!reportProgress())
+            return false;
+    }
+    return true;
+}
+
+bool DatabaseXmlImporter::readEvents(QXmlStreamReader &reader, int databaseSchemaVersion,
+                                     const SqlRaiiTransactor &transactor)
+{
+    while (reader.readNextStartElement()) {
+        if (reader.name() != Event::tagName()) {
+            reader.skipCurrentElement();
+            continue;
+        }
+
+        QDomDocument document;
+        const Event event = Event::fromXml(readElement(reader, document), databaseSchemaVersion);
+        if (!event.isValid()) {
+            qDebug() << "The following event is invalid and will not be added:";
+            event.dump();
+            continue;
+        }
+
+        if (!addEvent(event, transactor))
+            return false;
+        if (!reportProgress())
+            return false;
+    }
+    return true;
+}
+
+bool DatabaseXmlImporter::addEvent(const Event &event, const SqlRaiiTransactor &transactor)
+{
+    m_pendingEvents.append(event);
+    if (m_tasksRead && m_pendingEvents.size() >= m_batchSize)
+        return flushEvents(transactor);
+    return true;
+}
+
+bool DatabaseXmlImporter::flushEvents(const SqlRaiiTransactor &transactor)
+{
+    EventList events;
+    events.reserve(m_pendingEvents.size());
+    Q_FOREACH (const Event &event, m_pendingEvents) {
+        if (m_taskIds.contains(event.taskId()))
+            events.append(event);
+    }
+    m_pendingEvents.clear();
+
+    if (m_storage->addEvents(events, transactor).size() != events.size())
+        return storageError(QObject::tr("Error adding imported event."));
+    m_eventCount += events.size();
+    return true;
+}
+
+bool DatabaseXmlImporter::reportProgress()
+{
+    if (!m_progress || ++m_elementCount % ProgressInterval != 0)
+        return true;
+    const qint64 total = m_device->isSequential() ? 0 : m_device->size();
+    if (!m_progress(m_device->pos(), total)) {
+        m_canceled = true;
+        m_error = QObject::tr("The import has been canceled.");
+        return false;
+    }
+    return true;
+}
+
+bool DatabaseXmlImporter::storageError(const QString &message)
+{
+    m_error = QObject::tr("Error importing tasks and events from the file:<br />%1").arg(message);
+    return false;
+}
+
+QDomElement DatabaseXmlImporter::readElement(QXmlStreamReader &reader, QDomDocument &document)
+{
+    Q_ASSERT(reader.isStartElement());
+    QDomElement element = document.createElement(reader.qualifiedName().toString());
+    Q_FOREACH (const QXmlStreamAttribute &attribute, reader.attributes())
+        element.setAttribute(attribute.qualifiedName().toString(), attribute.value().toString());
+
+    while (!reader.atEnd()) {
+        reader.readNext();
+        if (reader.isStartElement()) {
+            element.appendChild(readElement(reader, document));
+        } else if (reader.isCharacters()) {
+            // QDomDocument drops text nodes that only contain whitespace, too:
+            if (!reader.isWhitespace())
+                element.appendChild(document.createTextNode(reader.text().toString()));
+        } else if (reader.isEndElement()) {
+            break;
+        }
+    }
+    return element;
+}
@@ -0,0 +1,101 @@
+/*
+  DatabaseXmlImporter.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef DATABASEXMLIMPORTER_H
+#define DATABASEXMLIMPORTER_H
+
+#include <QSet>
+#include <QString>
+
+#include <functional>
+
+#include "Event.h"
+#include "Task.h"
+#include "User.h"
+
+class QDomDocument;
+class QDomElement;
+class QIODevice;
+class QXmlStreamReader;
+class SqlRaiiTransactor;
+class SqlStorage;
+
+/** DatabaseXmlImporter replaces all tasks and events in the storage
+    with the contents of a database export.
+    The export is read with a QXmlStreamReader. Every task and event
+    element is converted on its own and handed to Task::fromXml() or
+    Event::fromXml(), so the accepted format is the same as for the
+    DOM based readers, but the file is never held in memory as a whole.
+    Events are written in batches. Everything happens in one
+    transaction: if the import fails or is canceled, the database is
+    left unchanged.
+*/
+class DatabaseXmlImporter
+{
+public:
+    /** Called regularly with the number of bytes read so far and the
+        size of the input (0 if it is not known).
+        Return false to cancel the import. */
+    typedef std::function<bool (qint64 bytesRead, qint64 totalBytes)> ProgressCallback;
+
+    DatabaseXmlImporter(SqlStorage *storage, const User &user);
+
+    void setProgressCallback(const ProgressCallback &callback);
+    /** The number of events written to the database at a time. */
+    void setBatchSize(int size);
+
+    /** Import the export read from @p device.
+        @return true if successful, otherwise errorString() describes the problem. */
+    bool import(QIODevice *device);
+
+    QString errorString() const;
+    bool wasCanceled() const;
+    int importedTaskCount() const;
+    int importedEventCount() const;
+
+private:
+    bool readExport(QXmlStreamReader &reader, const SqlRaiiTransactor &transactor);
+    bool readTasks(QXmlStreamReader &reader, int databaseSchemaVersion, const SqlRaiiTransactor &transactor);
+    bool readEvents(QXmlStreamReader &reader, int databaseSchemaVersion, const SqlRaiiTransactor &transactor);
+    bool addEvent(const Event &event, const SqlRaiiTransactor &transactor);
+    bool flushEvents(const SqlRaiiTransactor &transactor);
+    bool reportProgress();
+    bool storageError(const QString &message);
+
+    static QDomElement readElement(QXmlStreamReader &reader, QDomDocument &document);
+
+    SqlStorage *m_storage;
+    User m_user;
+    ProgressCallback m_progress;
+    int m_batchSize = 1000;
+    QIODevice *m_device = nullptr;
+    QSet<TaskId> m_taskIds;
+    // events are only written after the tasks have been read:
+    bool m_tasksRead = false;
+    EventList m_pendingEvents;
+    int m_elementCount = 0;
+    int m_taskCount = 0;
+    int m_eventCount = 0;
+    bool m_canceled = false;
+    QString m_error;
+};
+
+#endif
@@ -0,0 +1,113 @@
+/*
+  DurationRollup.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "DurationRollup.h"
+
+void DurationRollup::clear()
+{
+    m_days.clear();
+}
+
+bool DurationRollup::isEmpty() const
+{
+    return m_days.isEmpty();
+}
+
+void DurationRollup::addEvent(const Event &event)
+{
+    const QDateTime start = event.startDateTime();
+    if (start.isValid())
+        add(event.taskId(), start.date(), event.duration(), 1);
+}
+
+void DurationRollup::removeEvent(const Event &event)
+{
+    const QDateTime start = event.startDateTime();
+    if (start.isValid())
+        add(event.taskId(), start.date(), -event.duration(), -1);
+}
+
+void DurationRollup::add(TaskId task, const QDate &day, int seconds, int events)
+{
+    const auto dayIt = m_days.find(day.toJulianDay());
+    if (dayIt == m_days.end()) {
+        Q_ASSERT(events > 0);
+        if (events <= 0)
+            return;
+        Cell cell;
+        cell.seconds = seconds;
+        cell.events = events;
+        m_days[day.toJulianDay()].insert(task, cell);
+        return;
+    }
+
+    Cell &cell = (*dayIt)[task];
+    cell.seconds += seconds;
+    cell.events += events;
+    Q_ASSERT(cell.events >= 0);
+    if (cell.events <= 0) {
+        // keep the table sparse:
+        dayIt->remove(task);
+        if (dayIt->isEmpty())
+            m_days.erase(dayIt);
+    }
+}
+
+DurationRollup::Cell DurationRollup::cell(TaskId task, const QDate &day) const
+{
+    return m_days.value(day.toJulianDay()).value(task);
+}
+
+QMap<TaskId, QVector<int>> DurationRollup::secondsPerTask(const QDate &start, const QDate &end,
+                                                          int buckets,
+                                                          const BucketFunction &bucketOf) const
+{
+    QMap<TaskId, QVector<int>> result;
+    const auto last = m_days.lowerBound(end.toJulianDay());
+    for (auto dayIt = m_days.lowerBound(start.toJulianDay()); dayIt != last; ++dayIt) {
+        const int bucket = bucketOf(QDate::fromJulianDay(dayIt.key()));
+        Q_ASSERT(bucket >= 0 && bucket < buckets);
+        for (auto it = dayIt->constBegin(); it != dayIt->constEnd(); ++it) {
+            QVector<int> &seconds = result[it.key()];
+            if (seconds.isEmpty())
+                seconds.resize(buckets);
+            seconds[bucket] += it->seconds;
+        }
+    }
+    return result;
+}
+
+bool DurationRollup::operator==(const DurationRollup &other) const
+{
+    if (m_days.size() != other.m_days.size())
+        return false;
+    for (auto dayIt = m_days.constBegin(); dayIt != m_days.constEnd(); ++dayIt) {
+        const auto otherIt = other.m_days.constFind(dayIt.key());
+        if (otherIt == other.m_days.constEnd() || otherIt->size() != dayIt->size())
+            return false;
+        for (auto it = dayIt->constBegin(); it != dayIt->constEnd(); ++it) {
+            const Cell otherCell = otherIt->value(it.key());
+            if (otherCell.seconds != it->seconds || otherCell.events != it->events)
+                return false;
+        }
+    }
+    return true;
+}
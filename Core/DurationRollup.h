@@ -0,0 +1,78 @@
+/*
+  DurationRollup.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef DURATIONROLLUP_H
+#define DURATIONROLLUP_H
+
+#include <QDate>
+#include <QHash>
+#include <QMap>
+#include <QVector>
+
+#include <functional>
+
+#include "Event.h"
+
+/** DurationRollup keeps the seconds spent per task and per day.
+    Every event counts with its full duration for the local date it starts
+    on, the same way the time sheets have always counted it. The table is
+    sparse, only (task, day) cells that have events are stored. Every cell
+    also counts its events, so that a task with only a just started event
+    (which has no duration yet) still shows up.
+*/
+class DurationRollup
+{
+public:
+    struct Cell {
+        int seconds = 0;
+        int events = 0;
+    };
+
+    /** Maps a day to a column of the result of secondsPerTask(). */
+    typedef std::function<int (const QDate &)> BucketFunction;
+
+    void clear();
+    bool isEmpty() const;
+
+    void addEvent(const Event &event);
+    void removeEvent(const Event &event);
+    /** Add to a cell directly, used when loading a rollup kept by the storage. */
+    void add(TaskId task, const QDate &day, int seconds, int events);
+
+    Cell cell(TaskId task, const QDate &day) const;
+
+    /** The seconds of every task with events from @p start to before @p end.
+        Every day is added to the column bucketOf(day) of a vector of size @p buckets. */
+    QMap<TaskId, QVector<int>> secondsPerTask(const QDate &start, const QDate &end, int buckets,
+                                              const BucketFunction &bucketOf) const;
+
+    bool operator==(const DurationRollup &other) const;
+    bool operator!=(const DurationRollup &other) const
+    {
+        return !operator==(other);
+    }
+
+private:
+    // Julian day -> task -> cell:
+    QMap<qint64, QHash<TaskId, Cell>> m_days;
+};
+
+#endif
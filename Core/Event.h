@@ -87,6 +87,8 @@ public:
     void dump() const;
 
     QDomElement toXml(QDomDocument) const;
+    /** Write the same element as toXml(QDomDocument) to a stream writer. */
+    void toXml(QXmlStreamWriter &) const;
 
     static Event fromXml(const QDomElement &, int databaseSchemaVersion = 1);
     static QString tagName();
@@ -34,7 +34,7 @@ public:
     {
     }
 
-    virtual const Event &eventForIndex(const QModelIndex &) const = 0;
+    virtual Event eventForIndex(const QModelIndex &) const = 0;
     virtual QModelIndex indexForEvent(const Event &) const = 0;
 };
 
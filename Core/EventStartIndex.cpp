@@ -0,0 +1,86 @@
+/*
+  EventStartIndex.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "EventStartIndex.h"
+
+#include <limits>
+
+int EventStartIndex::Range::size() const
+{
+    return static_cast<int>(std::distance(m_begin, m_end));
+}
+
+EventIdList EventStartIndex::Range::toList() const
+{
+    EventIdList ids;
+    for (const_iterator it = m_begin; it != m_end; ++it)
+        ids.append(*it);
+    return ids;
+}
+
+bool EventStartIndex::keyFor(const Event &event, Key *key)
+{
+    const QDateTime start = event.startDateTime(Qt::UTC);
+    if (!start.isValid())
+        return false;
+    // events are stored without milliseconds, so this is exact:
+    *key = Key(start.toMSecsSinceEpoch() / 1000, event.id());
+    return true;
+}
+
+void EventStartIndex::insert(const Event &event)
+{
+    Key key;
+    if (keyFor(event, &key))
+        m_index.insert(key);
+}
+
+void EventStartIndex::remove(const Event &event)
+{
+    Key key;
+    if (keyFor(event, &key))
+        m_index.erase(key);
+}
+
+void EventStartIndex::clear()
+{
+    m_index.clear();
+}
+
+int EventStartIndex::size() const
+{
+    return static_cast<int>(m_index.size());
+}
+
+EventStartIndex::Range EventStartIndex::eventsThatStartInTimeFrame(const QDateTime &start,
+                                                                   const QDateTime &end) const
+{
+    const qint64 startSecs = start.toMSecsSinceEpoch() / 1000;
+    const qint64 endSecs = end.toMSecsSinceEpoch() / 1000;
+    if (endSecs <= startSecs)
+        return Range(const_iterator(m_index.end()), const_iterator(m_index.end()));
+
+    const Set::const_iterator first
+        = m_index.lower_bound(Key(startSecs, std::numeric_limits<EventId>::min()));
+    const Set::const_iterator last
+        = m_index.lower_bound(Key(endSecs, std::numeric_limits<EventId>::min()));
+    return Range(const_iterator(first), const_iterator(last));
+}
@@ -0,0 +1,124 @@
+/*
+  EventStartIndex.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef EVENTSTARTINDEX_H
+#define EVENTSTARTINDEX_H
+
+#include <iterator>
+#include <set>
+#include <utility>
+
+#include "Event.h"
+
+/** EventStartIndex keeps the ids of events ordered by their start time.
+    The index stores (start time in seconds since the epoch, event id)
+    pairs, so that all events starting in a given time frame can be
+    found with a binary search instead of a scan over all events.
+    Events without a valid start time are not indexed.
+*/
+class EventStartIndex
+{
+public:
+    typedef std::pair<qint64, EventId> Key;
+    typedef std::set<Key> Set;
+
+    /** Forward iterator over the event ids of a Range. */
+    class const_iterator
+    {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef EventId value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const EventId *pointer;
+        typedef const EventId &reference;
+
+        const_iterator() {}
+        explicit const_iterator(Set::const_iterator it)
+            : m_it(it)
+        {
+        }
+
+        reference operator*() const { return m_it->second; }
+        pointer operator->() const { return &m_it->second; }
+        /** The start time of the current event, in seconds since the epoch. */
+        qint64 startSecsSinceEpoch() const { return m_it->first; }
+
+        const_iterator &operator++()
+        {
+            ++m_it;
+            return *this;
+        }
+
+        const_iterator operator++(int)
+        {
+            const_iterator tmp(*this);
+            ++m_it;
+            return tmp;
+        }
+
+        bool operator==(const const_iterator &other) const { return m_it == other.m_it; }
+        bool operator!=(const const_iterator &other) const { return m_it != other.m_it; }
+
+    private:
+        Set::const_iterator m_it;
+    };
+
+    /** A range of event ids, ordered by start time.
+        The range refers to the index, it is invalidated when the index changes. */
+    class Range
+    {
+    public:
+        Range(const_iterator begin, const_iterator end)
+            : m_begin(begin)
+            , m_end(end)
+        {
+        }
+
+        const_iterator begin() const { return m_begin; }
+        const_iterator end() const { return m_end; }
+        bool isEmpty() const { return m_begin == m_end; }
+        /** Number of events in the range. Note: linear in the size of the range. */
+        int size() const;
+        EventIdList toList() const;
+
+    private:
+        const_iterator m_begin;
+        const_iterator m_end;
+    };
+
+    void insert(const Event &event);
+    void remove(const Event &event);
+    void clear();
+    int size() const;
+
+    /** All events that start at or after @p start and before @p end. */
+    Range eventsThatStartInTimeFrame(const QDateTime &start, const QDateTime &end) const;
+
+    /** The key of @p event in the index. Returns false if the event has no valid start time. */
+    static bool keyFor(const Event &event, Key *key);
+
+private:
+    Set m_index;
+};
+
+typedef EventStartIndex::Range EventIdRange;
+
+#endif
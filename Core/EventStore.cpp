@@ -0,0 +1,361 @@
+/*
+  EventStore.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "EventStore.h"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+
+namespace {
+const qint64 InvalidTime = std::numeric_limits<qint64>::min();
+// ids up to this value (or four times the number of events, if that is more)
+// go into the dense lookup table, everything else into the hash:
+const int MinimumDenseIdLimit = 1 << 16;
+}
+
+EventStore::EventStore()
+{
+    clear();
+}
+
+int EventStore::size() const
+{
+    return m_ids.size();
+}
+
+bool EventStore::isEmpty() const
+{
+    return m_ids.isEmpty();
+}
+
+void EventStore::reserve(int size)
+{
+    m_ids.reserve(size);
+    m_taskIds.reserve(size);
+    m_userIds.reserve(size);
+    m_reportIds.reserve(size);
+    m_starts.reserve(size);
+    m_ends.reserve(size);
+    m_commentHandles.reserve(size);
+}
+
+bool EventStore::contains(EventId id) const
+{
+    return slotOf(id) != -1;
+}
+
+Event EventStore::event(EventId id) const
+{
+    const int slot = slotOf(id);
+    if (slot == -1)
+        return Event();
+    return eventAt(slot);
+}
+
+Event EventStore::eventAt(int slot) const
+{
+    Q_ASSERT(slot >= 0 && slot < m_ids.size());
+    Event event;
+    event.setId(m_ids[slot]);
+    event.setTaskId(m_taskIds[slot]);
+    event.setUserId(m_userIds[slot]);
+    event.setReportId(m_reportIds[slot]);
+    event.setComment(m_comments[m_commentHandles[slot]]);
+    if (m_starts[slot] != InvalidTime)
+        event.setStartDateTime(fromSecs(m_starts[slot]));
+    if (m_ends[slot] != InvalidTime)
+        event.setEndDateTime(fromSecs(m_ends[slot]));
+    return event;
+}
+
+EventId EventStore::idAt(int slot) const
+{
+    return m_ids.at(slot);
+}
+
+TaskId EventStore::taskIdAt(int slot) const
+{
+    return m_taskIds.at(slot);
+}
+
+qint64 EventStore::startSecsAt(int slot) const
+{
+    return m_starts.at(slot);
+}
+
+void EventStore::insert(const Event &event)
+{
+    int slot = slotOf(event.id());
+    if (slot == -1) {
+        slot = m_ids.size();
+        m_ids.append(event.id());
+        m_taskIds.append(0);
+        m_userIds.append(0);
+        m_reportIds.append(0);
+        m_starts.append(InvalidTime);
+        m_ends.append(InvalidTime);
+        m_commentHandles.append(0);
+        setSlot(event.id(), slot);
+        if (slot == 0 || event.id() > m_maximumId)
+            m_maximumId = event.id();
+    } else {
+        releaseComment(m_commentHandles[slot]);
+    }
+
+    m_taskIds[slot] = event.taskId();
+    m_userIds[slot] = event.userId();
+    m_reportIds[slot] = event.reportId();
+    m_starts[slot] = toSecs(event.startDateTime(Qt::UTC));
+    m_ends[slot] = toSecs(event.endDateTime(Qt::UTC));
+    m_commentHandles[slot] = internComment(event.comment());
+}
+
+void EventStore::setEndDateTime(EventId id, const QDateTime &end)
+{
+    const int slot = slotOf(id);
+    Q_ASSERT(slot != -1);
+    if (slot != -1)
+        m_ends[slot] = toSecs(end.toUTC());
+}
+
+void EventStore::remove(EventId id)
+{
+    const int slot = slotOf(id);
+    if (slot == -1)
+        return;
+
+    releaseComment(m_commentHandles[slot]);
+    clearSlot(id);
+
+    // move the last slot into the gap to keep the columns dense:
+    const int last = m_ids.size() - 1;
+    if (slot != last) {
+        m_ids[slot] = m_ids[last];
+        m_taskIds[slot] = m_taskIds[last];
+        m_userIds[slot] = m_userIds[last];
+        m_reportIds[slot] = m_reportIds[last];
+        m_starts[slot] = m_starts[last];
+        m_ends[slot] = m_ends[last];
+        m_commentHandles[slot] = m_commentHandles[last];
+        setSlot(m_ids[slot], slot);
+    }
+
+    m_ids.removeLast();
+    m_taskIds.removeLast();
+    m_userIds.removeLast();
+    m_reportIds.removeLast();
+    m_starts.removeLast();
+    m_ends.removeLast();
+    m_commentHandles.removeLast();
+
+    if (id == m_maximumId)
+        findMaximumId(id);
+}
+
+void EventStore::clear()
+{
+    m_ids.clear();
+    m_taskIds.clear();
+    m_userIds.clear();
+    m_reportIds.clear();
+    m_starts.clear();
+    m_ends.clear();
+    m_commentHandles.clear();
+    m_denseSlots.clear();
+    m_sparseSlots.clear();
+    m_maximumId = 0;
+    m_comments.clear();
+    m_commentRefCounts.clear();
+    m_freeCommentHandles.clear();
+    m_commentHandleByText.clear();
+
+    // the empty comment is always handle 0 and never released:
+    m_comments.append(QString());
+    m_commentRefCounts.append(1);
+}
+
+EventIdList EventStore::ids() const
+{
+    QVector<EventId> ids = m_ids;
+    std::sort(ids.begin(), ids.end());
+    EventIdList list;
+    list.reserve(ids.size());
+    std::copy(ids.constBegin(), ids.constEnd(), std::back_inserter(list));
+    return list;
+}
+
+EventId EventStore::maximumId() const
+{
+    return m_maximumId;
+}
+
+qint64 EventStore::memoryUsage() const
+{
+    qint64 bytes = sizeof(EventStore);
+    bytes += m_ids.capacity() * sizeof(EventId);
+    bytes += m_taskIds.capacity() * sizeof(TaskId);
+    bytes += m_userIds.capacity() * sizeof(int);
+    bytes += m_reportIds.capacity() * sizeof(int);
+    bytes += m_starts.capacity() * sizeof(qint64);
+    bytes += m_ends.capacity() * sizeof(qint64);
+    bytes += m_commentHandles.capacity() * sizeof(int);
+    bytes += m_denseSlots.capacity() * sizeof(int);
+    // a hash node holds the key, the value and the next pointer and hash value:
+    bytes += m_sparseSlots.size() * (sizeof(void *) + sizeof(uint) + 2 * sizeof(int));
+    bytes += m_commentHandleByText.size() * (sizeof(void *) + sizeof(uint) + sizeof(QString) + sizeof(int));
+    bytes += m_comments.capacity() * sizeof(QString);
+    bytes += m_commentRefCounts.capacity() * sizeof(int);
+    bytes += m_freeCommentHandles.capacity() * sizeof(int);
+    Q_FOREACH (const QString &comment, m_comments)
+        bytes += comment.capacity() * sizeof(QChar);
+    return bytes;
+}
+
+bool EventStore::operator==(const EventStore &other) const
+{
+    if (&other == this)
+        return true;
+    if (size() != other.size())
+        return false;
+    for (int slot = 0; slot < m_ids.size(); ++slot) {
+        if (eventAt(slot) != other.event(m_ids[slot]))
+            return false;
+    }
+    return true;
+}
+
+int EventStore::slotOf(EventId id) const
+{
+    if (id > 0 && id < m_denseSlots.size())
+        return m_denseSlots[id];
+    return m_sparseSlots.value(id, -1);
+}
+
+void EventStore::setSlot(EventId id, int slot)
+{
+    if (id > 0 && id < m_denseSlots.size()) {
+        m_denseSlots[id] = slot;
+        return;
+    }
+
+    const int denseLimit = qMax(MinimumDenseIdLimit, 4 * m_ids.size());
+    if (id > 0 && id < denseLimit) {
+        // grow geometrically, but not beyond the limit:
+        const int oldSize = m_denseSlots.size();
+        const int newSize = qMin(denseLimit, qMax(id + 1, 2 * oldSize));
+        m_denseSlots.resize(newSize);
+        std::fill(m_denseSlots.begin() + oldSize, m_denseSlots.end(), -1);
+        // move ids that now fit into the table out of the hash:
+        for (auto it = m_sparseSlots.begin(); it != m_sparseSlots.end();) {
+            if (it.key() > 0 && it.key() < newSize) {
+                m_denseSlots[it.key()] = it.value();
+                it = m_sparseSlots.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        m_denseSlots[id] = slot;
+    } else {
+        m_sparseSlots.insert(id, slot);
+    }
+}
+
+void EventStore::clearSlot(EventId id)
+{
+    if (id > 0 && id < m_denseSlots.size())
+        m_denseSlots[id] = -1;
+    else
+        m_sparseSlots.remove(id);
+}
+
+void EventStore::findMaximumId(EventId removedId)
+{
+    m_maximumId = 0;
+    if (m_ids.isEmpty())
+        return;
+    // the ids in the hash are few; in the table, no id is above the removed
+    // one, and the next highest id is usually close to it:
+    bool found = false;
+    for (auto it = m_sparseSlots.constBegin(); it != m_sparseSlots.constEnd(); ++it) {
+        if (!found || it.key() > m_maximumId)
+            m_maximumId = it.key();
+        found = true;
+    }
+    const int top = removedId > 0 ? qMin(removedId, m_denseSlots.size()) : m_denseSlots.size();
+    for (int id = top - 1; id > 0; --id) {
+        if (m_denseSlots[id] != -1) {
+            if (!found || id > m_maximumId)
+                m_maximumId = id;
+            break;
+        }
+    }
+}
+
+int EventStore::internComment(const QString &comment)
+{
+    if (comment.isEmpty())
+        return 0;
+
+    const auto it = m_commentHandleByText.constFind(comment);
+    if (it != m_commentHandleByText.constEnd()) {
+        ++m_commentRefCounts[it.value()];
+        return it.value();
+    }
+
+    int handle;
+    if (!m_freeCommentHandles.isEmpty()) {
+        handle = m_freeCommentHandles.takeLast();
+        m_comments[handle] = comment;
+        m_commentRefCounts[handle] = 1;
+    } else {
+        handle = m_comments.size();
+        m_comments.append(comment);
+        m_commentRefCounts.append(1);
+    }
+    m_commentHandleByText.insert(comment, handle);
+    return handle;
+}
+
+void EventStore::releaseComment(int handle)
+{
+    if (handle == 0)
+        return;
+
+    Q_ASSERT(m_commentRefCounts[handle] > 0);
+    if (--m_commentRefCounts[handle] == 0) {
+        m_commentHandleByText.remove(m_comments[handle]);
+        m_comments[handle] = QString();
+        m_freeCommentHandles.append(handle);
+    }
+}
+
+qint64 EventStore::toSecs(const QDateTime &dateTime)
+{
+    if (!dateTime.isValid())
+        return InvalidTime;
+    return dateTime.toMSecsSinceEpoch() / 1000;
+}
+
+QDateTime EventStore::fromSecs(qint64 secs)
+{
+    return QDateTime::fromMSecsSinceEpoch(secs * 1000, Qt::UTC);
+}
@@ -0,0 +1,113 @@
+/*
+  EventStore.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef EVENTSTORE_H
+#define EVENTSTORE_H
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+#include "Event.h"
+
+/** EventStore keeps the events of the model in a compact, column
+    oriented layout.
+    Every event occupies one slot in a set of parallel arrays (id,
+    task, user, report, start and end time as seconds since the epoch,
+    and a handle to an interned comment). Slots are kept dense: when
+    an event is removed, the last slot is moved into its place.
+    Event ids are mapped to slots with a dense lookup table (with a
+    hash as fallback for ids that do not fit into it).
+    Event objects are materialized on demand by event().
+*/
+class EventStore
+{
+public:
+    EventStore();
+
+    int size() const;
+    bool isEmpty() const;
+    void reserve(int size);
+
+    bool contains(EventId id) const;
+    /** Returns the event with the given id, or an invalid event if it does not exist. */
+    Event event(EventId id) const;
+    /** Add the event, or replace the existing event with the same id. */
+    void insert(const Event &event);
+    /** Update only the end time of an existing event. */
+    void setEndDateTime(EventId id, const QDateTime &end);
+    void remove(EventId id);
+    void clear();
+
+    /** Direct column access, by slot. */
+    EventId idAt(int slot) const;
+    TaskId taskIdAt(int slot) const;
+    /** Start time in seconds since the epoch, or the minimum qint64 value if the start is not set. */
+    qint64 startSecsAt(int slot) const;
+    Event eventAt(int slot) const;
+
+    /** All event ids, in ascending order. */
+    EventIdList ids() const;
+    /** The highest event id, or 0 if the store is empty. */
+    EventId maximumId() const;
+
+    /** The number of bytes allocated for the columns, the lookup tables and the comments. */
+    qint64 memoryUsage() const;
+
+    bool operator==(const EventStore &other) const;
+    bool operator!=(const EventStore &other) const
+    {
+        return !operator==(other);
+    }
+
+private:
+    int slotOf(EventId id) const;
+    void setSlot(EventId id, int slot);
+    void clearSlot(EventId id);
+    void findMaximumId(EventId removedId);
+
+    int internComment(const QString &comment);
+    void releaseComment(int handle);
+
+    static qint64 toSecs(const QDateTime &dateTime);
+    static QDateTime fromSecs(qint64 secs);
+
+    QVector<EventId> m_ids;
+    QVector<TaskId> m_taskIds;
+    QVector<int> m_userIds;
+    QVector<int> m_reportIds;
+    QVector<qint64> m_starts;
+    QVector<qint64> m_ends;
+    QVector<int> m_commentHandles;
+
+    // id -> slot; -1 marks an unused entry:
+    QVector<int> m_denseSlots;
+    QHash<EventId, int> m_sparseSlots;
+    EventId m_maximumId = 0;
+
+    // interned comments; handle 0 is the empty comment:
+    QVector<QString> m_comments;
+    QVector<int> m_commentRefCounts;
+    QVector<int> m_freeCommentHandles;
+    QHash<QString, int> m_commentHandleByText;
+};
+
+#endif
@@ -0,0 +1,207 @@
+/*
+  GzipDevice.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "GzipDevice.h"
+
+#include <zlib.h>
+
+namespace {
+const int ChunkSize = 16 * 1024;
+// 15 bits of window size, plus 16 to write a gzip header
+// (or plus 32 to detect gzip or zlib headers when reading):
+const int GzipWindowBits = 15 + 16;
+const int AutoDetectWindowBits = 15 + 32;
+}
+
+GzipDevice::GzipDevice(QIODevice *device, QObject *parent)
+    : QIODevice(parent)
+    , m_device(device)
+{
+}
+
+GzipDevice::~GzipDevice()
+{
+    if (isOpen())
+        close();
+}
+
+bool GzipDevice::open(OpenMode mode)
+{
+    if (isOpen() || !m_device) {
+        setErrorString(tr("The device is already open."));
+        return false;
+    }
+    const OpenMode access = mode & ReadWrite;
+    if (access != ReadOnly && access != WriteOnly) {
+        setErrorString(tr("Compressed data can only be read or written, not both."));
+        return false;
+    }
+    if (!m_device->isOpen() || (m_device->openMode() & access) != access) {
+        setErrorString(tr("The underlying device is not open in the requested mode."));
+        return false;
+    }
+
+    m_stream = new z_stream;
+    m_stream->zalloc = Z_NULL;
+    m_stream->zfree = Z_NULL;
+    m_stream->opaque = Z_NULL;
+    m_stream->next_in = Z_NULL;
+    m_stream->avail_in = 0;
+    const int result = access == WriteOnly
+                       ? deflateInit2(m_stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                                      GzipWindowBits, 8, Z_DEFAULT_STRATEGY)
+                       : inflateInit2(m_stream, AutoDetectWindowBits);
+    if (result != Z_OK) {
+        setErrorString(tr("Cannot initialize the compression library."));
+        delete m_stream;
+        m_stream = nullptr;
+        return false;
+    }
+    m_buffer.resize(ChunkSize);
+    m_streamEnd = false;
+    m_finished = false;
+    // the data is never read in lines, so avoid buffering it twice:
+    return QIODevice::open(mode | Unbuffered);
+}
+
+void GzipDevice::close()
+{
+    if (!isOpen())
+        return;
+    if (openMode() & WriteOnly) {
+        if (!finish())
+            qWarning("GzipDevice: cannot complete the compressed stream");
+        deflateEnd(m_stream);
+    } else {
+        inflateEnd(m_stream);
+    }
+    delete m_stream;
+    m_stream = nullptr;
+    m_buffer.clear();
+    QIODevice::close();
+}
+
+bool GzipDevice::isSequential() const
+{
+    return true;
+}
+
+bool GzipDevice::atEnd() const
+{
+    if (openMode() & WriteOnly)
+        return true;
+    return m_streamEnd && QIODevice::atEnd();
+}
+
+bool GzipDevice::finish()
+{
+    if (!(openMode() & WriteOnly))
+        return false;
+    if (m_finished)
+        return true;
+    m_finished = true;
+    m_stream->next_in = Z_NULL;
+    m_stream->avail_in = 0;
+    return deflateInto(Z_FINISH);
+}
+
+bool GzipDevice::isGzipped(QIODevice *device)
+{
+    const QByteArray header = device->peek(2);
+    return header.size() == 2
+           && static_cast<unsigned char>(header[0]) == 0x1f
+           && static_cast<unsigned char>(header[1]) == 0x8b;
+}
+
+qint64 GzipDevice::readData(char *data, qint64 maxSize)
+{
+    if (m_streamEnd || maxSize <= 0)
+        return 0;
+
+    m_stream->next_out = reinterpret_cast<Bytef *>(data);
+    m_stream->avail_out = static_cast<uInt>(qMin<qint64>(maxSize, ChunkSize * 64));
+    const uInt requested = m_stream->avail_out;
+    while (m_stream->avail_out == requested) {
+        if (m_stream->avail_in == 0) {
+            const qint64 bytesRead = m_device->read(m_buffer.data(), m_buffer.size());
+            if (bytesRead < 0) {
+                setErrorString(m_device->errorString());
+                return -1;
+            }
+            if (bytesRead == 0) {
+                // the compressed stream is truncated:
+                setErrorString(tr("Unexpected end of the compressed data."));
+                m_streamEnd = true;
+                break;
+            }
+            m_stream->next_in = reinterpret_cast<Bytef *>(m_buffer.data());
+            m_stream->avail_in = static_cast<uInt>(bytesRead);
+        }
+
+        const int result = inflate(m_stream, Z_NO_FLUSH);
+        if (result == Z_STREAM_END) {
+            m_streamEnd = true;
+            break;
+        }
+        if (result != Z_OK && result != Z_BUF_ERROR) {
+            setErrorString(tr("The compressed data is corrupted."));
+            return -1;
+        }
+    }
+    return requested - m_stream->avail_out;
+}
+
+qint64 GzipDevice::writeData(const char *data, qint64 size)
+{
+    if (m_finished)
+        return -1;
+    // zlib takes the input size as an unsigned int:
+    qint64 written = 0;
+    while (written < size) {
+        const uInt chunk = static_cast<uInt>(qMin<qint64>(size - written, ChunkSize * 64));
+        m_stream->next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data + written));
+        m_stream->avail_in = chunk;
+        if (!deflateInto(Z_NO_FLUSH))
+            return -1;
+        written += chunk;
+    }
+    return written;
+}
+
+bool GzipDevice::deflateInto(int flush)
+{
+    int result;
+    do {
+        m_stream->next_out = reinterpret_cast<Bytef *>(m_buffer.data());
+        m_stream->avail_out = static_cast<uInt>(m_buffer.size());
+        result = deflate(m_stream, flush);
+        if (result == Z_STREAM_ERROR) {
+            setErrorString(tr("Cannot compress the data."));
+            return false;
+        }
+        const qint64 size = m_buffer.size() - m_stream->avail_out;
+        if (size > 0 && m_device->write(m_buffer.constData(), size) != size) {
+            setErrorString(m_device->errorString());
+            return false;
+        }
+    } while (m_stream->avail_out == 0 || (flush == Z_FINISH && result != Z_STREAM_END));
+    return true;
+}
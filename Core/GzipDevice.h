@@ -0,0 +1,71 @@
+/*
+  GzipDevice.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GZIPDEVICE_H
+#define GZIPDEVICE_H
+
+#include <QByteArray>
+#include <QIODevice>
+
+struct z_stream_s;
+
+/** GzipDevice compresses or decompresses the data passing through it
+    to or from another device, in the gzip format.
+    Open it WriteOnly to compress everything written to it into the
+    underlying device, or ReadOnly to read decompressed data from it.
+    The underlying device has to be open, and is not owned or closed.
+    The device is sequential, it cannot seek.
+*/
+class GzipDevice : public QIODevice
+{
+    Q_OBJECT
+public:
+    explicit GzipDevice(QIODevice *device, QObject *parent = nullptr);
+    ~GzipDevice() override;
+
+    bool open(OpenMode mode) override;
+    void close() override;
+    bool isSequential() const override;
+    bool atEnd() const override;
+
+    /** Write the end of the compressed stream.
+        close() does that as well, but cannot report errors.
+        @return false if the data could not be written */
+    bool finish();
+
+    /** Returns true if the next bytes of @p device are a gzip header. */
+    static bool isGzipped(QIODevice *device);
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 size) override;
+
+private:
+    bool deflateInto(int flush);
+
+    QIODevice *m_device;
+    z_stream_s *m_stream = nullptr;
+    QByteArray m_buffer;
+    bool m_streamEnd = false;
+    bool m_finished = false;
+};
+
+#endif
@@ -0,0 +1,141 @@
+/*
+  HeartbeatJournal.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "HeartbeatJournal.h"
+
+#include <QtDebug>
+
+// every entry is one line: "<event id> <end time in seconds since the epoch>"
+// a partially written last line (after a crash) is ignored when reading
+
+HeartbeatJournal::HeartbeatJournal()
+{
+}
+
+HeartbeatJournal::~HeartbeatJournal()
+{
+    close();
+}
+
+bool HeartbeatJournal::open(const QString &fileName)
+{
+    close();
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadWrite | QIODevice::Append)) {
+        qWarning() << "HeartbeatJournal::open: cannot open" << fileName << m_file.errorString();
+        return false;
+    }
+    return true;
+}
+
+void HeartbeatJournal::close()
+{
+    if (!m_file.isOpen())
+        return;
+    const bool empty = m_file.size() == 0;
+    m_file.close();
+    if (empty)
+        m_file.remove();
+    m_pending.clear();
+}
+
+bool HeartbeatJournal::isOpen() const
+{
+    return m_file.isOpen();
+}
+
+QString HeartbeatJournal::fileName() const
+{
+    return m_file.fileName();
+}
+
+bool HeartbeatJournal::record(const Event &event)
+{
+    if (!m_file.isOpen() || !event.isValid() || !event.endDateTime().isValid())
+        return false;
+
+    const qint64 end = event.endDateTime(Qt::UTC).toMSecsSinceEpoch() / 1000;
+    if (!writeEntry(event.id(), end) || !m_file.flush())
+        return false;
+    m_pending.insert(event.id(), end);
+    return true;
+}
+
+void HeartbeatJournal::checkpointed(EventId id)
+{
+    if (!m_pending.remove(id))
+        return;
+    if (m_pending.isEmpty()) {
+        clear();
+        return;
+    }
+
+    // with several active events, one of them is always pending, compact
+    // the journal to the entries that are still needed:
+    if (!m_file.isOpen() || !m_file.resize(0))
+        return;
+    for (auto it = m_pending.constBegin(); it != m_pending.constEnd(); ++it) {
+        if (!writeEntry(it.key(), it.value()))
+            return;
+    }
+    m_file.flush();
+}
+
+QHash<EventId, QDateTime> HeartbeatJournal::entries() const
+{
+    QHash<EventId, QDateTime> result;
+    QFile file(m_file.fileName());
+    if (!file.open(QIODevice::ReadOnly))
+        return result;
+
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine();
+        if (!line.endsWith('\n'))
+            break; // incomplete entry
+        const QList<QByteArray> fields = line.trimmed().split(' ');
+        if (fields.size() != 2)
+            continue;
+        bool idOk, endOk;
+        const EventId id = fields[0].toInt(&idOk);
+        const qint64 end = fields[1].toLongLong(&endOk);
+        if (idOk && endOk)
+            result.insert(id, QDateTime::fromMSecsSinceEpoch(end * 1000, Qt::UTC));
+    }
+    return result;
+}
+
+void HeartbeatJournal::clear()
+{
+    m_pending.clear();
+    if (m_file.isOpen())
+        m_file.resize(0);
+}
+
+bool HeartbeatJournal::writeEntry(EventId id, qint64 end)
+{
+    const QByteArray line = QByteArray::number(id) + ' ' + QByteArray::number(end) + '\n';
+    return m_file.write(line) == line.size();
+}
+
+QString HeartbeatJournal::journalFileName(const QString &databaseFileName)
+{
+    return databaseFileName + QStringLiteral(".heartbeat");
+}
@@ -0,0 +1,74 @@
+/*
+  HeartbeatJournal.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HEARTBEATJOURNAL_H
+#define HEARTBEATJOURNAL_H
+
+#include <QFile>
+#include <QHash>
+
+#include "Event.h"
+
+/** HeartbeatJournal records the running end time of active events.
+    While an event is active, its end time is updated every few
+    seconds. Instead of writing every update to the database, the
+    current end time is appended to a small journal file next to the
+    database, and the event row is only written at checkpoints.
+    The journal is not synced to disk, it is meant to survive an
+    application crash, not a power loss.
+    When the application starts after a crash, entries() returns the
+    last recorded end time per event, so that the events can be
+    repaired before they are loaded.
+*/
+class HeartbeatJournal
+{
+public:
+    HeartbeatJournal();
+    ~HeartbeatJournal();
+
+    bool open(const QString &fileName);
+    void close();
+    bool isOpen() const;
+    QString fileName() const;
+
+    /** Append the current end time of @p event to the journal. */
+    bool record(const Event &event);
+    /** The event has been written to the database, its journal entries are obsolete.
+        The journal is rewritten with only the last entry of each event that is
+        still pending, so that it does not grow while other events are active. */
+    void checkpointed(EventId id);
+    /** The last recorded end time per event (in UTC). */
+    QHash<EventId, QDateTime> entries() const;
+    /** Drop all entries. */
+    void clear();
+
+    /** The journal file name used for the given database file. */
+    static QString journalFileName(const QString &databaseFileName);
+
+private:
+    bool writeEntry(EventId id, qint64 end);
+
+    QFile m_file;
+    // the last recorded end time (in seconds since the epoch) per pending event:
+    QHash<EventId, qint64> m_pending;
+};
+
+#endif
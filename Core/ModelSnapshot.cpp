@@ -0,0 +1,354 @@
+/*
+  ModelSnapshot.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ModelSnapshot.h"
+#include "CharmConstants.h"
+
+#include <QFile>
+#include <QHash>
+#include <QSaveFile>
+#include <QtDebug>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace {
+const quint32 SnapshotMagic = 0x4e534843; // "CHSN"
+// version 2 keeps the events ordered by start time:
+const quint32 SnapshotFormatVersion = 2;
+// the records are read in place, so the byte order has to match:
+const quint32 ByteOrderMark = 0x01020304;
+const qint64 InvalidTime = std::numeric_limits<qint64>::min();
+
+enum TaskFlags {
+    TaskSubscribed = 0x1,
+    TaskTrackable = 0x2
+};
+
+struct SnapshotHeader
+{
+    quint32 magic;
+    quint32 formatVersion;
+    quint32 byteOrderMark;
+    quint32 databaseVersion;
+    qint64 changeCounter;
+    quint32 taskCount;
+    quint32 eventCount;
+    quint64 stringsOffset; // in bytes, from the start of the file
+    quint64 stringsLength; // in UTF-16 code units
+    quint64 fileSize;
+};
+
+struct StringRef
+{
+    quint32 offset; // in UTF-16 code units, from the start of the string pool
+    quint32 length;
+};
+
+struct TaskRecord
+{
+    qint64 validFrom;
+    qint64 validUntil;
+    qint32 validFromSpec;
+    qint32 validFromOffset;
+    qint32 validUntilSpec;
+    qint32 validUntilOffset;
+    qint32 id;
+    qint32 parent;
+    quint32 flags;
+    quint32 padding;
+    StringRef name;
+    StringRef comment;
+};
+
+struct EventRecord
+{
+    qint64 start;
+    qint64 end;
+    qint32 id;
+    qint32 taskId;
+    qint32 userId;
+    qint32 reportId;
+    StringRef comment;
+};
+
+// all records have to stay 8 byte aligned in the mapped file:
+static_assert(sizeof(SnapshotHeader) % 8 == 0, "unexpected padding in SnapshotHeader");
+static_assert(sizeof(TaskRecord) % 8 == 0, "unexpected padding in TaskRecord");
+static_assert(sizeof(EventRecord) % 8 == 0, "unexpected padding in EventRecord");
+
+class StringPool
+{
+public:
+    StringRef add(const QString &string)
+    {
+        StringRef ref = { 0, 0 };
+        if (string.isEmpty())
+            return ref;
+        const auto it = m_offsets.constFind(string);
+        if (it != m_offsets.constEnd()) {
+            ref.offset = it.value();
+        } else {
+            ref.offset = static_cast<quint32>(m_data.size());
+            m_offsets.insert(string, ref.offset);
+            m_data.append(string);
+        }
+        ref.length = static_cast<quint32>(string.size());
+        return ref;
+    }
+
+    const QString &data() const
+    {
+        return m_data;
+    }
+
+private:
+    QString m_data;
+    QHash<QString, quint32> m_offsets;
+};
+
+void writeTime(const QDateTime &time, qint64 *msecs, qint32 *spec, qint32 *offset)
+{
+    *msecs = InvalidTime;
+    *spec = Qt::LocalTime;
+    *offset = 0;
+    if (!time.isValid())
+        return;
+    *msecs = time.toMSecsSinceEpoch();
+    switch (time.timeSpec()) {
+    case Qt::LocalTime:
+        break;
+    case Qt::OffsetFromUTC:
+        *spec = Qt::OffsetFromUTC;
+        *offset = time.offsetFromUtc();
+        break;
+    default:
+        // time zones are not kept, but the point in time is:
+        *spec = Qt::UTC;
+        break;
+    }
+}
+
+QDateTime readTime(qint64 msecs, qint32 spec, qint32 offset)
+{
+    if (msecs == InvalidTime)
+        return QDateTime();
+    return QDateTime::fromMSecsSinceEpoch(msecs, static_cast<Qt::TimeSpec>(spec), offset);
+}
+
+class StringReader
+{
+public:
+    StringReader(const QChar *data, quint64 length)
+        : m_data(data)
+        , m_length(length)
+    {
+    }
+
+    bool isValid(const StringRef &ref) const
+    {
+        return static_cast<quint64>(ref.offset) + ref.length <= m_length;
+    }
+
+    QString string(const StringRef &ref)
+    {
+        if (ref.length == 0)
+            return QString();
+        // equal strings are stored once, share them in memory as well:
+        QString &string = m_strings[ref.offset];
+        if (string.size() != static_cast<int>(ref.length))
+            string = QString(m_data + ref.offset, ref.length);
+        return string;
+    }
+
+private:
+    const QChar *m_data;
+    quint64 m_length;
+    QHash<quint32, QString> m_strings;
+};
+}
+
+bool ModelSnapshot::write(const QString &fileName, qint64 changeCounter,
+                          const TaskList &tasks, const EventList &events)
+{
+    StringPool strings;
+
+    QByteArray taskRecords(tasks.size() * static_cast<int>(sizeof(TaskRecord)), Qt::Uninitialized);
+    TaskRecord *taskRecord = reinterpret_cast<TaskRecord *>(taskRecords.data());
+    Q_FOREACH (const Task &task, tasks) {
+        std::memset(taskRecord, 0, sizeof(TaskRecord));
+        writeTime(task.validFrom(), &taskRecord->validFrom,
+                  &taskRecord->validFromSpec, &taskRecord->validFromOffset);
+        writeTime(task.validUntil(), &taskRecord->validUntil,
+                  &taskRecord->validUntilSpec, &taskRecord->validUntilOffset);
+        taskRecord->id = task.id();
+        taskRecord->parent = task.parent();
+        taskRecord->flags = (task.subscribed() ? TaskSubscribed : 0)
+                            | (task.trackable() ? TaskTrackable : 0);
+        taskRecord->name = strings.add(task.name());
+        taskRecord->comment = strings.add(task.comment());
+        ++taskRecord;
+    }
+
+    QByteArray eventRecords(events.size() * static_cast<int>(sizeof(EventRecord)), Qt::Uninitialized);
+    EventRecord *eventRecord = reinterpret_cast<EventRecord *>(eventRecords.data());
+    Q_FOREACH (const Event &event, events) {
+        const QDateTime start = event.startDateTime(Qt::UTC);
+        const QDateTime end = event.endDateTime(Qt::UTC);
+        eventRecord->start = start.isValid() ? start.toMSecsSinceEpoch() : InvalidTime;
+        eventRecord->end = end.isValid() ? end.toMSecsSinceEpoch() : InvalidTime;
+        eventRecord->id = event.id();
+        eventRecord->taskId = event.taskId();
+        eventRecord->userId = event.userId();
+        eventRecord->reportId = event.reportId();
+        eventRecord->comment = strings.add(event.comment());
+        ++eventRecord;
+    }
+    // ordered by start time, events without one first, so that reading
+    // can skip the events before a time frame:
+    EventRecord *eventRecordsBegin = reinterpret_cast<EventRecord *>(eventRecords.data());
+    std::stable_sort(eventRecordsBegin, eventRecord, [](const EventRecord &left, const EventRecord &right) {
+        return left.start < right.start;
+    });
+
+    SnapshotHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = SnapshotMagic;
+    header.formatVersion = SnapshotFormatVersion;
+    header.byteOrderMark = ByteOrderMark;
+    header.databaseVersion = CHARM_DATABASE_VERSION;
+    header.changeCounter = changeCounter;
+    header.taskCount = static_cast<quint32>(tasks.size());
+    header.eventCount = static_cast<quint32>(events.size());
+    header.stringsOffset = sizeof(header) + taskRecords.size() + eventRecords.size();
+    header.stringsLength = static_cast<quint64>(strings.data().size());
+    header.fileSize = header.stringsOffset + header.stringsLength * sizeof(QChar);
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "ModelSnapshot::write: cannot open" << fileName << file.errorString();
+        return false;
+    }
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(taskRecords);
+    file.write(eventRecords);
+    file.write(reinterpret_cast<const char *>(strings.data().constData()),
+               strings.data().size() * static_cast<qint64>(sizeof(QChar)));
+    if (!file.commit()) {
+        qWarning() << "ModelSnapshot::write: cannot write" << fileName << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool ModelSnapshot::read(const QString &fileName, qint64 changeCounter,
+                         TaskList *tasks, EventList *events, const QDateTime &since)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    const qint64 size = file.size();
+    if (size < static_cast<qint64>(sizeof(SnapshotHeader)))
+        return false;
+    const uchar *data = file.map(0, size);
+    if (!data)
+        return false;
+
+    const SnapshotHeader *header = reinterpret_cast<const SnapshotHeader *>(data);
+    if (header->magic != SnapshotMagic
+        || header->formatVersion != SnapshotFormatVersion
+        || header->byteOrderMark != ByteOrderMark
+        || header->databaseVersion != CHARM_DATABASE_VERSION
+        || header->changeCounter != changeCounter
+        || header->fileSize != static_cast<quint64>(size)
+        || header->stringsOffset != sizeof(SnapshotHeader)
+        + static_cast<quint64>(header->taskCount) * sizeof(TaskRecord)
+        + static_cast<quint64>(header->eventCount) * sizeof(EventRecord)
+        || header->stringsOffset + header->stringsLength * sizeof(QChar) != header->fileSize) {
+        return false;
+    }
+
+    const TaskRecord *taskRecords = reinterpret_cast<const TaskRecord *>(data + sizeof(SnapshotHeader));
+    const EventRecord *eventRecords = reinterpret_cast<const EventRecord *>(taskRecords + header->taskCount);
+    StringReader strings(reinterpret_cast<const QChar *>(data + header->stringsOffset),
+                         header->stringsLength);
+
+    TaskList snapshotTasks;
+    snapshotTasks.reserve(header->taskCount);
+    for (quint32 i = 0; i < header->taskCount; ++i) {
+        const TaskRecord &record = taskRecords[i];
+        if (!strings.isValid(record.name) || !strings.isValid(record.comment))
+            return false;
+        Task task;
+        task.setId(record.id);
+        task.setParent(record.parent);
+        task.setName(strings.string(record.name));
+        task.setComment(strings.string(record.comment));
+        task.setSubscribed(record.flags & TaskSubscribed);
+        task.setTrackable(record.flags & TaskTrackable);
+        task.setValidFrom(readTime(record.validFrom, record.validFromSpec, record.validFromOffset));
+        task.setValidUntil(readTime(record.validUntil, record.validUntilSpec,
+                                    record.validUntilOffset));
+        snapshotTasks.append(task);
+    }
+
+    // the events without a start time, and those that start in the time frame:
+    const EventRecord *eventRecordsEnd = eventRecords + header->eventCount;
+    const EventRecord *withStart = std::partition_point(eventRecords, eventRecordsEnd,
+                                                        [](const EventRecord &record) {
+        return record.start == InvalidTime;
+    });
+    const EventRecord *first = withStart;
+    if (since.isValid()) {
+        const qint64 sinceMSecs = since.toMSecsSinceEpoch();
+        first = std::partition_point(withStart, eventRecordsEnd, [sinceMSecs](const EventRecord &record) {
+            return record.start < sinceMSecs;
+        });
+    }
+
+    EventList snapshotEvents;
+    snapshotEvents.reserve((withStart - eventRecords) + (eventRecordsEnd - first));
+    const auto readEvents = [&](const EventRecord *begin, const EventRecord *end) {
+        for (const EventRecord *record = begin; record != end; ++record) {
+            if (!strings.isValid(record->comment))
+                return false;
+            Event event;
+            event.setId(record->id);
+            event.setTaskId(record->taskId);
+            event.setUserId(record->userId);
+            event.setReportId(record->reportId);
+            event.setComment(strings.string(record->comment));
+            if (record->start != InvalidTime)
+                event.setStartDateTime(QDateTime::fromMSecsSinceEpoch(record->start, Qt::UTC));
+            if (record->end != InvalidTime)
+                event.setEndDateTime(QDateTime::fromMSecsSinceEpoch(record->end, Qt::UTC));
+            snapshotEvents.append(event);
+        }
+        return true;
+    };
+    if (!readEvents(eventRecords, withStart) || !readEvents(first, eventRecordsEnd))
+        return false;
+
+    *tasks = snapshotTasks;
+    *events = snapshotEvents;
+    return true;
+}
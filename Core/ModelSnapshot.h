@@ -0,0 +1,59 @@
+/*
+  ModelSnapshot.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MODELSNAPSHOT_H
+#define MODELSNAPSHOT_H
+
+#include <QString>
+
+#include "Event.h"
+#include "Task.h"
+
+/** ModelSnapshot keeps a copy of all tasks and events in a binary file,
+    so that the model can be loaded without querying the database.
+    The file starts with a header, followed by fixed size task and
+    event records and a pool of UTF-16 strings. It is memory mapped
+    when reading. Times are stored as milliseconds since the epoch, so
+    no dates need to be parsed. The event records are ordered by start
+    time, so that a time frame can be read without touching the rest.
+    Every snapshot carries the change counter of the database it was
+    taken from (see SqlStorage::changeCounter()). A snapshot is only
+    used if the counter still matches, that is, if the database has
+    not changed since.
+*/
+class ModelSnapshot
+{
+public:
+    /** Write a snapshot of @p tasks and @p events, taken at @p changeCounter.
+        The file is replaced atomically.
+        @return false if the snapshot could not be written */
+    static bool write(const QString &fileName, qint64 changeCounter,
+                      const TaskList &tasks, const EventList &events);
+
+    /** Read the snapshot in @p fileName, if it is intact and was taken at @p changeCounter.
+        If @p since is valid, only the events that start at or after it, and those
+        without a start time, are read; the others are not even decoded.
+        @return false if there is no such snapshot, @p tasks and @p events are unchanged then */
+    static bool read(const QString &fileName, qint64 changeCounter,
+                     TaskList *tasks, EventList *events, const QDateTime &since = QDateTime());
+};
+
+#endif
@@ -144,6 +144,7 @@ bool MySqlStorage::createDatabaseTables()
     }
 
     error = error
+            || !createIndexes()
             || !setMetaData(CHARM_DATABASE_VERSION_DESCRIPTOR,
                             QString().setNum(CHARM_DATABASE_VERSION));
     return !error;
@@ -171,6 +172,7 @@ bool MySqlStorage::connect(Configuration &)
 
 bool MySqlStorage::disconnect()
 {
+    clearStatementCache();
     return false;     // not implemented
 }
 
@@ -214,6 +216,7 @@ MySqlStorage::Parameters MySqlStorage::parseParameterEnvironmentVariable()
 
 void MySqlStorage::configure(const Parameters &parameters)
 {
+    clearStatementCache();
     database().setHostName(parameters.host);
     database().setDatabaseName(parameters.database);
     database().setUserName(parameters.name);
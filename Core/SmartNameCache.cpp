@@ -23,71 +23,74 @@
 
 #include "SmartNameCache.h"
 
-struct IdLessThan
-{
-    bool operator()(const Task &lhs, const Task &rhs) const
-    {
-        return lhs.id() < rhs.id();
-    }
-};
+#include <algorithm>
 
 void SmartNameCache::setAllTasks(const TaskList &taskList)
 {
-    m_tasks = taskList;
-    sortTasks();
-    regenerateSmartNames();
-}
-
-void SmartNameCache::sortTasks()
-{
-    qSort(m_tasks.begin(), m_tasks.end(), IdLessThan());
+    clearTasks();
+    beginBulkUpdate();
+    Q_FOREACH (const Task &task, taskList)
+        insertTask(task);
+    endBulkUpdate();
 }
 
-//single add/modify/delete rebuild the cache each time.
-//If necessary, this could be optimized by keeping the tasks in a "inverse" tree
-//with the task names below the root and their parents further down
-
 void SmartNameCache::modifyTask(const Task &task)
 {
-    const TaskList::Iterator it
-        = qBinaryFind(m_tasks.begin(), m_tasks.end(), Task(task.id(), QString()), IdLessThan());
-    if (it != m_tasks.end())
-        *it = task;
-    sortTasks();
-    regenerateSmartNames();
+    const auto it = m_tasks.constFind(task.id());
+    if (it == m_tasks.constEnd())
+        return;
+    // only the name and the parent matter for the smart names:
+    if (it->name() == task.name() && it->parent() == task.parent()) {
+        m_tasks.insert(task.id(), task);
+        return;
+    }
+
+    const Task oldTask = *it;
+    removeTask(oldTask);
+    insertTask(task);
+    updateDirtyBuckets();
 }
 
 void SmartNameCache::deleteTask(const Task &task)
 {
-    const auto it = qBinaryFind(m_tasks.begin(), m_tasks.end(), Task(task.id(),
-                                                                     QString()), IdLessThan());
-    if (it != m_tasks.end()) {
-        m_tasks.erase(it);
-        regenerateSmartNames();
+    const auto it = m_tasks.constFind(task.id());
+    if (it != m_tasks.constEnd()) {
+        const Task oldTask = *it;
+        removeTask(oldTask);
+        updateDirtyBuckets();
     }
 }
 
 void SmartNameCache::clearTasks()
 {
     m_tasks.clear();
+    m_childIds.clear();
+    m_buckets.clear();
+    m_dirtyBuckets.clear();
     m_smartTaskNamesById.clear();
 }
 
+void SmartNameCache::beginBulkUpdate()
+{
+    ++m_bulkUpdateDepth;
+}
+
+void SmartNameCache::endBulkUpdate()
+{
+    Q_ASSERT(m_bulkUpdateDepth > 0);
+    --m_bulkUpdateDepth;
+    updateDirtyBuckets();
+}
+
 Task SmartNameCache::findTask(TaskId id) const
 {
-    const auto it = qBinaryFind(m_tasks.begin(), m_tasks.end(), Task(id, QString()), IdLessThan());
-    if (it != m_tasks.constEnd()) {
-        return *it;
-    } else {
-        return Task();
-    }
+    return m_tasks.value(id);
 }
 
 void SmartNameCache::addTask(const Task &task)
 {
-    m_tasks.append(task);
-    sortTasks();
-    regenerateSmartNames();
+    insertTask(task);
+    updateDirtyBuckets();
 }
 
 QString SmartNameCache::smartName(const TaskId &id) const
@@ -95,6 +98,81 @@ QString SmartNameCache::smartName(const TaskId &id) const
     return m_smartTaskNamesById.value(id);
 }
 
+QString SmartNameCache::bucketFor(const Task &task)
+{
+    return task.name().section(QLatin1Char('/'), -1);
+}
+
+void SmartNameCache::insertTask(const Task &task)
+{
+    Q_ASSERT(!m_tasks.contains(task.id()));
+    m_tasks.insert(task.id(), task);
+    m_childIds[task.parent()].append(task.id());
+
+    const QString bucket = bucketFor(task);
+    QVector<TaskId> &ids = m_buckets[bucket];
+    ids.insert(std::lower_bound(ids.begin(), ids.end(), task.id()), task.id());
+    markDirty(bucket);
+    // tasks that were added before their parent:
+    markDescendantsDirty(task.id());
+}
+
+void SmartNameCache::removeTask(const Task &task)
+{
+    m_tasks.remove(task.id());
+    m_smartTaskNamesById.remove(task.id());
+
+    const auto siblings = m_childIds.find(task.parent());
+    if (siblings != m_childIds.end()) {
+        siblings->removeOne(task.id());
+        if (siblings->isEmpty())
+            m_childIds.erase(siblings);
+    }
+
+    const QString bucket = bucketFor(task);
+    const auto ids = m_buckets.find(bucket);
+    if (ids != m_buckets.end()) {
+        const auto it = std::lower_bound(ids->begin(), ids->end(), task.id());
+        if (it != ids->end() && *it == task.id())
+            ids->erase(it);
+        if (ids->isEmpty())
+            m_buckets.erase(ids);
+    }
+    markDirty(bucket);
+    markDescendantsDirty(task.id());
+}
+
+void SmartNameCache::markDirty(const QString &bucket)
+{
+    m_dirtyBuckets.insert(bucket);
+}
+
+void SmartNameCache::markDescendantsDirty(TaskId id)
+{
+    QSet<TaskId> visited;
+    QVector<TaskId> pending = m_childIds.value(id);
+    while (!pending.isEmpty()) {
+        const TaskId childId = pending.takeLast();
+        if (visited.contains(childId))
+            continue;   // the parent relation has a cycle
+        visited.insert(childId);
+        const auto it = m_tasks.constFind(childId);
+        if (it == m_tasks.constEnd())
+            continue;
+        markDirty(bucketFor(*it));
+        pending += m_childIds.value(childId);
+    }
+}
+
+void SmartNameCache::updateDirtyBuckets()
+{
+    if (m_bulkUpdateDepth > 0)
+        return;
+    Q_FOREACH (const QString &bucket, m_dirtyBuckets)
+        regenerateSmartNames(bucket);
+    m_dirtyBuckets.clear();
+}
+
 QString SmartNameCache::makeCombined(const Task &task) const
 {
     Q_ASSERT(task.isValid() || task.name().isEmpty());   // an invalid task (id == 0) must not have a name
@@ -109,15 +187,16 @@ QString SmartNameCache::makeCombined(const Task &task) const
     }
 }
 
-void SmartNameCache::regenerateSmartNames()
+void SmartNameCache::regenerateSmartNames(const QString &bucket)
 {
-    m_smartTaskNamesById.clear();
     typedef QPair<TaskId, TaskId> TaskParentPair;
 
     QMap<QString, QVector<TaskParentPair> > byName;
 
-    Q_FOREACH (const Task &task, m_tasks)
+    Q_FOREACH (TaskId id, m_buckets.value(bucket)) {
+        const Task task = findTask(id);
         byName[makeCombined(task)].append(qMakePair(task.id(), task.parent()));
+    }
 
     QSet<QString> cannotMakeUnique;
 
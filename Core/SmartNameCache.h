@@ -26,6 +26,21 @@
 
 #include "Task.h"
 
+#include <QHash>
+#include <QSet>
+#include <QVector>
+
+/** SmartNameCache keeps the shortest unambiguous names of the tasks:
+    a task name is prefixed with the names of as many ancestors as
+    needed to distinguish it from tasks with the same name.
+    Tasks can only be confused with tasks whose name ends in the same
+    segment (the part after the last slash), so the tasks are kept in
+    buckets by that segment. A change to a task only recomputes the
+    names in its bucket, and in the buckets of its descendants, whose
+    names may include its name.
+    Many changes can be combined with beginBulkUpdate() and
+    endBulkUpdate(), the names are then recomputed once at the end.
+*/
 class SmartNameCache
 {
 public:
@@ -36,15 +51,31 @@ public:
     void deleteTask(const Task &task);
     void clearTasks();
 
+    /** Defer recomputing the names until the matching endBulkUpdate(). Calls may be nested. */
+    void beginBulkUpdate();
+    void endBulkUpdate();
+
 private:
-    void regenerateSmartNames();
-    void sortTasks();
+    static QString bucketFor(const Task &task);
+    void insertTask(const Task &task);
+    void removeTask(const Task &task);
+    void markDirty(const QString &bucket);
+    void markDescendantsDirty(TaskId id);
+    void updateDirtyBuckets();
+    void regenerateSmartNames(const QString &bucket);
     Task findTask(TaskId id) const;
     QString makeCombined(const Task &task) const;
 
 private:
-    QMap<TaskId, QString> m_smartTaskNamesById;
-    TaskList m_tasks;
+    QHash<TaskId, QString> m_smartTaskNamesById;
+    QHash<TaskId, Task> m_tasks;
+    // task ids by parent task id:
+    QHash<TaskId, QVector<TaskId> > m_childIds;
+    // sorted task ids by the last segment of the task name:
+    QHash<QString, QVector<TaskId> > m_buckets;
+    // buckets that need to be recomputed:
+    QSet<QString> m_dirtyBuckets;
+    int m_bulkUpdateDepth = 0;
 };
 
 #endif
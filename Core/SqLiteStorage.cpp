@@ -33,7 +33,9 @@
 #include <QtDebug>
 #include <QFileInfo>
 #include <QSqlDatabase>
+#include <QSqlError>
 #include <QSqlQuery>
+#include <QStringList>
 
 #include <cerrno>
 
@@ -111,6 +113,27 @@ static const Fields *Database_Fields[NumberOfTables] = {
 const QString DatabaseName = QStringLiteral("charm.kdab.com");
 const QString DriverName = QStringLiteral("QSQLITE");
 
+// SQLITE TUNING PER DURABILITY PROFILE
+struct DurabilityProfile
+{
+    const char *synchronous;
+    qint64 mmapSize; // bytes
+    int cacheSize; // negative values are KiB, see PRAGMA cache_size
+    const char *tempStore;
+};
+
+// all profiles use write-ahead logging, so readers do not block on writes,
+// they differ in when SQLite waits for the disk:
+static const DurabilityProfile DurabilityProfiles[Configuration::DatabaseDurability_NumberOfProfiles] = {
+    // safe: sync the log on every commit
+    { "FULL", 0, -2000, "DEFAULT" },
+    // balanced: sync at checkpoints only, a power loss may roll back the last commits
+    { "NORMAL", 64 * 1024 * 1024, -16000, "MEMORY" },
+    // fast: like balanced, with more memory for the cache and the mapping;
+    // synchronous = OFF is not offered, a power loss could corrupt the database
+    { "NORMAL", 256 * 1024 * 1024, -64000, "MEMORY" }
+};
+
 SqLiteStorage::SqLiteStorage()
     : SqlStorage()
     , m_database(QSqlDatabase::addDatabase(DriverName, DatabaseName))
@@ -128,6 +151,74 @@ QString SqLiteStorage::lastInsertRowFunction() const
     return QStringLiteral("last_insert_rowid");
 }
 
+QStringList SqLiteStorage::changeCounterStatements() const
+{
+    // SQLite only has row triggers, so bulk changes count once per row:
+    static const char *const CountedTables[] = { "Tasks", "Events", "Subscriptions" };
+    static const char *const Operations[] = { "INSERT", "UPDATE", "DELETE" };
+
+    QStringList statements;
+    statements << QStringLiteral("INSERT INTO MetaData (key, value) SELECT '%1', '0' "
+                                 "WHERE NOT EXISTS (SELECT 1 FROM MetaData WHERE key = '%1');")
+                  .arg(CHARM_DATABASE_CHANGE_COUNTER_DESCRIPTOR);
+    for (const char *table : CountedTables) {
+        for (const char *operation : Operations) {
+            statements << QStringLiteral("CREATE TRIGGER IF NOT EXISTS %1_%2_changes AFTER %3 ON %1 "
+                                         "BEGIN UPDATE MetaData SET value = value + 1 "
+                                         "WHERE key = '%4'; END;")
+                          .arg(QString::fromLatin1(table), QString::fromLatin1(operation).toLower(),
+                               QString::fromLatin1(operation), CHARM_DATABASE_CHANGE_COUNTER_DESCRIPTOR);
+        }
+    }
+    return statements;
+}
+
+QStringList SqLiteStorage::durationRollupStatements() const
+{
+    // an event counts with its whole duration for the day it starts on, like in
+    // DurationRollup; the times are stored in local time, so date() is the local day.
+    // The duration is taken between the UTC times, like Event::duration(), so an
+    // event across a daylight saving time switch counts the time that really passed:
+    const QString duration = QStringLiteral(
+        "IFNULL(strftime('%s', %1.end, 'utc') - strftime('%s', %1.start, 'utc'), 0)");
+    const QString subtractOld = QStringLiteral(
+        "UPDATE TaskDayDurations SET seconds = seconds - %1, events = events - 1 "
+        "WHERE task = OLD.task AND day = date(OLD.start); "
+        "DELETE FROM TaskDayDurations WHERE task = OLD.task AND day = date(OLD.start) AND events <= 0; ")
+                                .arg(duration.arg(QStringLiteral("OLD")));
+    const QString addNew = QStringLiteral(
+        "INSERT OR IGNORE INTO TaskDayDurations (task, day, seconds, events) "
+        "SELECT NEW.task, date(NEW.start), 0, 0 WHERE NEW.task IS NOT NULL AND date(NEW.start) IS NOT NULL; "
+        "UPDATE TaskDayDurations SET seconds = seconds + %1, events = events + 1 "
+        "WHERE task = NEW.task AND day = date(NEW.start); ")
+                           .arg(duration.arg(QStringLiteral("NEW")));
+
+    QStringList statements;
+    statements << QStringLiteral("CREATE TABLE IF NOT EXISTS TaskDayDurations (task INTEGER NOT NULL, "
+                                 "day DATE NOT NULL, seconds INTEGER NOT NULL, events INTEGER NOT NULL, "
+                                 "PRIMARY KEY (task, day));")
+               << QStringLiteral("DELETE FROM TaskDayDurations;")
+               << QStringLiteral("INSERT INTO TaskDayDurations (task, day, seconds, events) "
+                                 "SELECT task, date(start), SUM(%1), COUNT(*) FROM Events "
+                                 "WHERE task IS NOT NULL AND date(start) IS NOT NULL "
+                                 "GROUP BY task, date(start);").arg(duration.arg(QStringLiteral("Events")))
+               << QStringLiteral("DROP TRIGGER IF EXISTS Events_insert_durations;")
+               << QStringLiteral("DROP TRIGGER IF EXISTS Events_update_durations;")
+               << QStringLiteral("DROP TRIGGER IF EXISTS Events_delete_durations;")
+               << QStringLiteral("CREATE TRIGGER IF NOT EXISTS Events_insert_durations AFTER INSERT ON Events "
+                                 "BEGIN %1END;").arg(addNew)
+               << QStringLiteral("CREATE TRIGGER IF NOT EXISTS Events_update_durations AFTER UPDATE ON Events "
+                                 "BEGIN %1%2END;").arg(subtractOld, addNew)
+               << QStringLiteral("CREATE TRIGGER IF NOT EXISTS Events_delete_durations AFTER DELETE ON Events "
+                                 "BEGIN %1END;").arg(subtractOld);
+    return statements;
+}
+
+QString SqLiteStorage::snapshotFileName() const
+{
+    return m_database.databaseName() + QStringLiteral("-snapshot");
+}
+
 QString SqLiteStorage::description() const
 {
     return QObject::tr("local database");
@@ -164,6 +255,9 @@ bool SqLiteStorage::createDatabaseTables()
     }
 
     error = error
+            || !createIndexes()
+            || !createChangeCounter()
+            || !createDurationRollup()
             || !setMetaData(CHARM_DATABASE_VERSION_DESCRIPTOR,
                             QString().setNum(CHARM_DATABASE_VERSION));
     return !error;
@@ -193,6 +287,7 @@ bool SqLiteStorage::connect(Configuration &configuration)
     if (oldDatabaseDirectory.exists())
         migrateDatabaseDirectory(oldDatabaseDirectory, fileInfo.dir());
 
+    clearStatementCache();
     m_database.setHostName(QStringLiteral("localhost"));
     const QString databaseName = fileInfo.absoluteFilePath();
     m_database.setDatabaseName(databaseName);
@@ -217,6 +312,12 @@ bool SqLiteStorage::connect(Configuration &configuration)
         return false;
     }
 
+    // fold a write-ahead log left behind by a crash into the database file
+    // before it is migrated (and copied) by verifyDatabase:
+    QSqlQuery checkpoint(m_database);
+    checkpoint.exec(QStringLiteral("PRAGMA wal_checkpoint(TRUNCATE);"));
+    checkpoint.finish();
+
     if (!verifyDatabase()) {
         if (!createDatabase(configuration)) {
             configuration.failureMessage = QObject::tr(
@@ -225,6 +326,17 @@ bool SqLiteStorage::connect(Configuration &configuration)
         }
     }
 
+    // the profile is persisted in the database, before the rest of the
+    // meta data is loaded by the controller:
+    Configuration::DatabaseDurability durability = configuration.databaseDurability;
+    bool ok;
+    const int storedDurability = getMetaData(MetaKey_Key_DatabaseDurability).toInt(&ok);
+    if (ok && storedDurability >= 0
+        && storedDurability < Configuration::DatabaseDurability_NumberOfProfiles)
+        durability = static_cast<Configuration::DatabaseDurability>(storedDurability);
+    if (!setDurability(durability))
+        qWarning() << "SqLiteStorage::connect: cannot apply the database durability profile";
+
     if (!configuration.newDatabase) {
         const int userid = configuration.user.id();
         const User user = getUser(userid);
@@ -242,6 +354,30 @@ bool SqLiteStorage::connect(Configuration &configuration)
     return true;
 }
 
+bool SqLiteStorage::setDurability(Configuration::DatabaseDurability durability)
+{
+    Q_ASSERT(durability >= 0 && durability < Configuration::DatabaseDurability_NumberOfProfiles);
+    const DurabilityProfile &profile = DurabilityProfiles[durability];
+    const QStringList pragmas = {
+        QStringLiteral("PRAGMA journal_mode = WAL;"),
+        QStringLiteral("PRAGMA synchronous = %1;").arg(QLatin1String(profile.synchronous)),
+        QStringLiteral("PRAGMA mmap_size = %1;").arg(profile.mmapSize),
+        QStringLiteral("PRAGMA cache_size = %1;").arg(profile.cacheSize),
+        QStringLiteral("PRAGMA temp_store = %1;").arg(QLatin1String(profile.tempStore))
+    };
+
+    bool result = true;
+    Q_FOREACH (const QString &pragma, pragmas) {
+        QSqlQuery query(m_database);
+        if (!query.exec(pragma)) {
+            qWarning() << "SqLiteStorage::setDurability:" << pragma << "failed:"
+                       << query.lastError().text();
+            result = false;
+        }
+    }
+    return result;
+}
+
 bool SqLiteStorage::migrateDatabaseDirectory(QDir oldDirectory, const QDir &newDirectory) const
 {
     if (oldDirectory == newDirectory)
@@ -260,6 +396,7 @@ bool SqLiteStorage::migrateDatabaseDirectory(QDir oldDirectory, const QDir &newD
 
 bool SqLiteStorage::disconnect()
 {
+    clearStatementCache();
     m_database.removeDatabase(DatabaseName);
     m_database.close();
     return true; // neither of the two methods return a value
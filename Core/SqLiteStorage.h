@@ -44,11 +44,17 @@ public:
 
     QSqlDatabase &database() override;
 
+    bool setDurability(Configuration::DatabaseDurability durability) override;
+
+    QString snapshotFileName() const override;
+
 protected:
     bool createDatabase(Configuration &) override;
     bool createDatabaseTables() override;
     bool migrateDatabaseDirectory(QDir, const QDir &) const;
     QString lastInsertRowFunction() const override;
+    QStringList changeCounterStatements() const override;
+    QStringList durationRollupStatements() const override;
 
 private:
     QSqlDatabase m_database;
@@ -25,6 +25,7 @@
 #include "SqlStorage.h"
 #include "CharmConstants.h"
 #include "CharmExceptions.h"
+#include "DurationRollup.h"
 #include "Event.h"
 #include "SqlRaiiTransactor.h"
 #include "State.h"
@@ -33,6 +34,7 @@
 #include <QDateTime>
 #include <QFile>
 #include <QFileInfo>
+#include <QSet>
 #include <QSqlDatabase>
 #include <QSqlError>
 #include <QSqlField>
@@ -52,6 +54,11 @@ SqlStorage::~SqlStorage()
 {
 }
 
+bool SqlStorage::setDurability(Configuration::DatabaseDurability)
+{
+    return true;
+}
+
 bool SqlStorage::verifyDatabase()
 {
     // if the database is empty, it is not ok :-)
@@ -74,39 +81,242 @@ bool SqlStorage::verifyDatabase()
     if (version > CHARM_DATABASE_VERSION)
         throw UnsupportedDatabaseVersionException(QObject::tr("Database version is too new."));
 
-    if (version == CHARM_DATABASE_VERSION_BEFORE_TRACKABLE) {
-        return migrateDB(QStringLiteral(
-                             "ALTER TABLE Tasks ADD trackable INTEGER"),
-                         CHARM_DATABASE_VERSION_BEFORE_TRACKABLE);
-    } else if (version == CHARM_DATABASE_VERSION_BEFORE_COMMENT) {
-        return migrateDB(QStringLiteral(
-                             "ALTER TABLE Tasks ADD comment varchar(256)"),
-                         CHARM_DATABASE_VERSION_BEFORE_COMMENT);
-    }
+    return migrateDB(version);
+}
+
+QStringList SqlStorage::indexStatements()
+{
+    return QStringList()
+           << QStringLiteral("CREATE INDEX Events_event_id ON Events (event_id)")
+           << QStringLiteral("CREATE INDEX Events_start ON Events (start)")
+           << QStringLiteral("CREATE INDEX Events_task ON Events (task)")
+           << QStringLiteral("CREATE INDEX Events_report_user ON Events (report_id, user_id)")
+           << QStringLiteral("CREATE INDEX Subscriptions_task_user ON Subscriptions (task, user_id)");
+}
+
+QVector<SqlStorage::Migration> SqlStorage::migrations() const
+{
+    QVector<Migration> steps;
+    steps << Migration { CHARM_DATABASE_VERSION_BEFORE_TRACKABLE,
+                         QStringList(QStringLiteral("ALTER TABLE Tasks ADD trackable INTEGER")) }
+          << Migration { CHARM_DATABASE_VERSION_BEFORE_COMMENT,
+                         QStringList(QStringLiteral("ALTER TABLE Tasks ADD comment varchar(256)")) }
+          << Migration { CHARM_DATABASE_VERSION_BEFORE_INDEXES, indexStatements() }
+          << Migration { CHARM_DATABASE_VERSION_BEFORE_CHANGE_COUNTER, changeCounterStatements() }
+          << Migration { CHARM_DATABASE_VERSION_BEFORE_DURATION_ROLLUP, durationRollupStatements() };
+    return steps;
+}
 
-    throw UnsupportedDatabaseVersionException(QObject::tr("Database version is not supported."));
+QStringList SqlStorage::changeCounterStatements() const
+{
+    return QStringList();
+}
+
+bool SqlStorage::createChangeCounter()
+{
+    return runStatements(changeCounterStatements());
+}
+
+QStringList SqlStorage::durationRollupStatements() const
+{
+    return QStringList();
+}
+
+bool SqlStorage::createDurationRollup()
+{
+    return runStatements(durationRollupStatements());
+}
+
+bool SqlStorage::getDurationRollup(DurationRollup *rollup)
+{
+    if (durationRollupStatements().isEmpty())
+        return false;
+
+    QSqlQuery &query = preparedQuery(GetDurationRollup);
+    if (!runQuery(query))
+        return false;
+    rollup->clear();
+    while (query.next()) {
+        const QDate day = QDate::fromString(query.value(1).toString(), Qt::ISODate);
+        if (day.isValid() && query.value(3).toInt() > 0)
+            rollup->add(query.value(0).value<TaskId>(), day, query.value(2).toInt(), query.value(3).toInt());
+    }
     return true;
 }
 
-TaskList SqlStorage::getAllTasks()
+bool SqlStorage::runStatements(const QStringList &statements)
 {
-    TaskList tasks;
-    QSqlQuery query(database());
-    query.prepare(QStringLiteral(
-                      "select * from Tasks left join Subscriptions on Tasks.task_id = Subscriptions.task;"));
+    bool error = false;
+    Q_FOREACH (const QString &statement, statements) {
+        QSqlQuery query(database());
+        query.prepare(statement);
+        if (!runQuery(query))
+            error = true;
+    }
+    return !error;
+}
 
-    // FIXME merge record retrieval with getTask:
-    if (runQuery(query)) {
-        while (query.next())
-        {
-            Task task = makeTaskFromRecord(query.record());
-            tasks.append(task);
-        }
+qint64 SqlStorage::changeCounter()
+{
+    bool ok;
+    const qint64 counter = getMetaData(CHARM_DATABASE_CHANGE_COUNTER_DESCRIPTOR).toLongLong(&ok);
+    return ok ? counter : -1;
+}
+
+QString SqlStorage::snapshotFileName() const
+{
+    return QString();
+}
+
+bool SqlStorage::createIndexes()
+{
+    return runStatements(indexStatements());
+}
+
+QString SqlStorage::statementText(Statement statement) const
+{
+    switch (statement) {
+    case GetAllTasks:
+        return QStringLiteral(
+            "select * from Tasks left join Subscriptions on Tasks.task_id = Subscriptions.task;");
+    case AddTask:
+        return QStringLiteral(
+            "INSERT into Tasks (task_id, name, parent, validfrom, validuntil, trackable, comment) "
+            "values ( ?, ?, ?, ?, ?, ?, ? );");
+    case GetTask:
+        return QStringLiteral(
+            "SELECT * FROM Tasks LEFT JOIN Subscriptions ON Tasks.task_id = Subscriptions.task WHERE task_id = ?;");
+    case ModifyTask:
+        return QStringLiteral("UPDATE Tasks set name = ?, parent = ?, validfrom = ?, validuntil = ?, "
+                              "trackable = ?, comment = ? where task_id = ?;");
+    case DeleteTask:
+        return QStringLiteral("DELETE from Tasks where task_id = ?;");
+    case DeleteTaskEvents:
+        return QStringLiteral("DELETE from Events where task = ?;");
+    case DeleteAllTasks:
+        return QStringLiteral("DELETE from Tasks;");
+    case GetAllEvents:
+        return QStringLiteral("SELECT * from Events;");
+    case GetEventsStartingSince:
+        return QStringLiteral("SELECT * from Events WHERE start >= ? OR start IS NULL;");
+    case GetEventsStartingBefore:
+        return QStringLiteral("SELECT * from Events WHERE start < ?;");
+    case GetEventsThatStartInTimeFrame:
+        return QStringLiteral("SELECT * from Events WHERE start >= ? AND start < ?;");
+    case InsertEvent:
+        return QStringLiteral("INSERT into Events values "
+                              "( NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL );");
+    case GetLastInsertedEvent:
+        return QStringLiteral("SELECT id from Events WHERE id = %1();").arg(lastInsertRowFunction());
+    case InitializeEvent:
+        return QStringLiteral("UPDATE Events SET event_id = ?, installation_id = ?, report_id = ? "
+                              "WHERE id = ?;");
+    case AddEvent:
+        return QStringLiteral("INSERT into Events (user_id, installation_id, report_id, "
+                              "task, comment, start, end) values ( ?, ?, ?, ?, ?, ?, ? );");
+    case GetEvent:
+        return QStringLiteral("SELECT * FROM Events WHERE event_id = ?;");
+    case ModifyEvent:
+        return QStringLiteral("UPDATE Events set task = ?, comment = ?, start = ?, end = ?, "
+                              "user_id = ?, report_id = ? where event_id = ?;");
+    case DeleteEvent:
+        return QStringLiteral("DELETE from Events where event_id = ?;");
+    case DeleteAllEvents:
+        return QStringLiteral("DELETE from Events;");
+    case GetUser:
+        return QStringLiteral("SELECT * from Users WHERE user_id = ?;");
+    case InsertUser:
+        return QStringLiteral("INSERT into Users ( id, user_id, name ) VALUES (NULL, NULL, ?);");
+    case GetLastInsertedUser:
+        return QStringLiteral("SELECT id from Users WHERE id = %1();").arg(lastInsertRowFunction());
+    case InitializeUser:
+        return QStringLiteral("UPDATE Users SET user_id = ? WHERE id = ?;");
+    case ModifyUser:
+        return QStringLiteral("UPDATE Users SET name = ? WHERE user_id = ?;");
+    case DeleteUser:
+        return QStringLiteral("DELETE from Users WHERE user_id = ?;");
+    case AddSubscription:
+        return QStringLiteral("INSERT into Subscriptions VALUES (NULL, ?, ?);");
+    case DeleteSubscription:
+        return QStringLiteral("DELETE from Subscriptions WHERE user_id = ? AND task = ?;");
+    case GetMetaData:
+        return QStringLiteral("SELECT * FROM MetaData WHERE key = ?;");
+    case UpdateMetaData:
+        return QStringLiteral("UPDATE MetaData SET value = ? WHERE key = ?;");
+    case InsertMetaData:
+        return QStringLiteral("INSERT INTO MetaData VALUES ( NULL, ?, ? );");
+    case GetDurationRollup:
+        return QStringLiteral("SELECT task, day, seconds, events FROM TaskDayDurations;");
+    case NumberOfStatements:
+        break;
+    }
+    Q_ASSERT_X(false, Q_FUNC_INFO, "unknown statement");
+    return QString();
+}
+
+QSqlQuery &SqlStorage::preparedQuery(Statement statement)
+{
+    QHash<int, QSqlQuery>::iterator it = m_statements.find(statement);
+    if (it != m_statements.end()) {
+        ++m_statementCacheHits;
+        return it.value();
     }
 
+    ++m_statementCacheMisses;
+    QSqlQuery query(database());
+    // the full table reads only ever step forward, which lets the driver
+    // avoid keeping all rows around:
+    query.setForwardOnly(statement == GetAllTasks || statement == GetAllEvents
+                         || statement == GetEventsStartingSince
+                         || statement == GetEventsStartingBefore
+                         || statement == GetEventsThatStartInTimeFrame
+                         || statement == GetDurationRollup);
+    if (!query.prepare(statementText(statement))) {
+        // do not cache failed statements, but let runQuery report the error:
+        m_uncachedStatement = query;
+        return m_uncachedStatement;
+    }
+    return m_statements.insert(statement, query).value();
+}
+
+int SqlStorage::statementCacheHits() const
+{
+    return m_statementCacheHits;
+}
+
+int SqlStorage::statementCacheMisses() const
+{
+    return m_statementCacheMisses;
+}
+
+void SqlStorage::clearStatementCache()
+{
+    m_statements.clear();
+    m_uncachedStatement = QSqlQuery();
+}
+
+TaskList SqlStorage::getAllTasks()
+{
+    TaskList tasks;
+    visitAllTasks([&tasks](const Task &task) {
+        tasks.append(task);
+        return true;
+    });
     return tasks;
 }
 
+bool SqlStorage::visitAllTasks(const TaskVisitor &visitor)
+{
+    QSqlQuery &query = preparedQuery(GetAllTasks);
+
+    // FIXME merge record retrieval with getTask:
+    bool result = runQuery(query);
+    while (result && query.next())
+        result = visitor(makeTaskFromRecord(query.record()));
+    query.finish();
+    return result;
+}
+
 bool SqlStorage::setAllTasks(const User &user, const TaskList &tasks)
 {
     SqlRaiiTransactor transactor(database());
@@ -130,6 +340,21 @@ bool SqlStorage::setAllTasks(const User &user, const TaskList &tasks)
     return true;
 }
 
+bool SqlStorage::applyTaskChanges(const TaskList &added, const TaskList &modified)
+{
+    SqlRaiiTransactor transactor(database());
+    Q_FOREACH (const Task &task, added) {
+        if (!addTask(task, transactor))
+            return false;
+    }
+    Q_FOREACH (const Task &task, modified) {
+        if (!modifyTask(task))
+            return false;
+    }
+    transactor.commit();
+    return true;
+}
+
 bool SqlStorage::addTask(const Task &task)
 {
     SqlRaiiTransactor t(database());
@@ -143,60 +368,50 @@ bool SqlStorage::addTask(const Task &task)
 
 bool SqlStorage::addTask(const Task &task, const SqlRaiiTransactor &)
 {
-    QSqlQuery query(database());
-    query.prepare(QLatin1String(
-                      "INSERT into Tasks (task_id, name, parent, validfrom, validuntil, trackable, comment) "
-                      "values ( :task_id, :name, :parent, :validfrom, :validuntil, :trackable, :comment);"));
-    query.bindValue(QStringLiteral(":task_id"), task.id());
-    query.bindValue(QStringLiteral(":name"), task.name());
-    query.bindValue(QStringLiteral(":parent"), task.parent());
-    query.bindValue(QStringLiteral(":validfrom"), task.validFrom());
-    query.bindValue(QStringLiteral(":validuntil"), task.validUntil());
-    query.bindValue(QStringLiteral(":trackable"), task.trackable() ? 1 : 0);
-    query.bindValue(QStringLiteral(":comment"), task.comment());
+    QSqlQuery &query = preparedQuery(AddTask);
+    query.bindValue(0, task.id());
+    query.bindValue(1, task.name());
+    query.bindValue(2, task.parent());
+    query.bindValue(3, task.validFrom());
+    query.bindValue(4, task.validUntil());
+    query.bindValue(5, task.trackable() ? 1 : 0);
+    query.bindValue(6, task.comment());
     return runQuery(query);
 }
 
 Task SqlStorage::getTask(int taskid)
 {
-    QSqlQuery query(database());
-    query.prepare(QStringLiteral(
-                      "SELECT * FROM Tasks LEFT JOIN Subscriptions ON Tasks.task_id = Subscriptions.task WHERE task_id = :id;"));
-    query.bindValue(QStringLiteral(":id"), taskid);
+    QSqlQuery &query = preparedQuery(GetTask);
+    query.bindValue(0, taskid);
 
-    if (runQuery(query) && query.next()) {
-        Task task = makeTaskFromRecord(query.record());
-        return task;
-    } else {
-        return Task();
-    }
+    Task task;
+    if (runQuery(query) && query.next())
+        task = makeTaskFromRecord(query.record());
+    query.finish();
+    return task;
 }
 
 bool SqlStorage::modifyTask(const Task &task)
 {
-    QSqlQuery query(database());
-    query.prepare(QLatin1String("UPDATE Tasks set name = :name, parent = :parent, "
-                                "validfrom = :validfrom, validuntil = :validuntil, trackable = :trackable "
-                                "where task_id = :task_id;"));
-    query.bindValue(QStringLiteral(":task_id"), task.id());
-    query.bindValue(QStringLiteral(":name"), task.name());
-    query.bindValue(QStringLiteral(":parent"), task.parent());
-    query.bindValue(QStringLiteral(":validfrom"), task.validFrom());
-    query.bindValue(QStringLiteral(":validuntil"), task.validUntil());
-    query.bindValue(QStringLiteral(":trackable"), task.trackable() ? 1 : 0);
+    QSqlQuery &query = preparedQuery(ModifyTask);
+    query.bindValue(0, task.name());
+    query.bindValue(1, task.parent());
+    query.bindValue(2, task.validFrom());
+    query.bindValue(3, task.validUntil());
+    query.bindValue(4, task.trackable() ? 1 : 0);
+    query.bindValue(5, task.comment());
+    query.bindValue(6, task.id());
     return runQuery(query);
 }
 
 bool SqlStorage::deleteTask(const Task &task)
 {
     SqlRaiiTransactor transactor(database());
-    QSqlQuery query(database());
-    query.prepare(QStringLiteral("DELETE from Tasks where task_id = :task_id;"));
-    query.bindValue(QStringLiteral(":task_id"), task.id());
+    QSqlQuery &query = preparedQuery(DeleteTask);
+    query.bindValue(0, task.id());
     bool rc = runQuery(query);
-    QSqlQuery query2(database());
-    query2.prepare(QStringLiteral("DELETE from Events where task = :task_id;"));
-    query2.bindValue(QStringLiteral(":task_id"), task.id());
+    QSqlQuery &query2 = preparedQuery(DeleteTaskEvents);
+    query2.bindValue(0, task.id());
     bool rc2 = runQuery(query2);
     if (rc && rc2) {
         transactor.commit();
@@ -219,8 +434,7 @@ bool SqlStorage::deleteAllTasks()
 
 bool SqlStorage::deleteAllTasks(const SqlRaiiTransactor &)
 {
-    QSqlQuery query(database());
-    query.prepare(QStringLiteral("DELETE from Tasks;"));
+    QSqlQuery &query = preparedQuery(DeleteAllTasks);
     return runQuery(query);
 }
 
@@ -256,12 +470,53 @@ Event SqlStorage::makeEventFromRecord(const QSqlRecord &record)
 EventList SqlStorage::getAllEvents()
 {
     EventList events;
-    QSqlQuery query(database());
-    query.prepare(QStringLiteral("SELECT * from Events;"));
+    visitAllEvents([&events](const Event &event) {
+        events.append(event);
+        return true;
+    });
+    return events;
+}
+
+bool SqlStorage::visitAllEvents(const EventVisitor &visitor)
+{
+    QSqlQuery &query = preparedQuery(GetAllEvents);
+    bool result = runQuery(query);
+    while (result && query.next())
+        result = visitor(makeEventFromRecord(query.record()));
+    query.finish();
+    return result;
+}
+
+EventList SqlStorage::getEventsStartingSince(const QDateTime &start)
+{
+    QSqlQuery &query = preparedQuery(GetEventsStartingSince);
+    // the times are stored the way the events return them, in local time:
+    query.bindValue(0, start.toLocalTime());
+    return runEventQuery(query);
+}
+
+EventList SqlStorage::getEventsThatStartInTimeFrame(const QDateTime &start, const QDateTime &end)
+{
+    if (!start.isValid()) {
+        QSqlQuery &query = preparedQuery(GetEventsStartingBefore);
+        query.bindValue(0, end.toLocalTime());
+        return runEventQuery(query);
+    }
+
+    QSqlQuery &query = preparedQuery(GetEventsThatStartInTimeFrame);
+    query.bindValue(0, start.toLocalTime());
+    query.bindValue(1, end.toLocalTime());
+    return runEventQuery(query);
+}
+
+EventList SqlStorage::runEventQuery(QSqlQuery &query)
+{
+    EventList events;
     if (runQuery(query)) {
         while (query.next())
             events.append(makeEventFromRecord(query.record()));
     }
+    query.finish();
     return events;
 }
 
@@ -280,38 +535,30 @@ Event SqlStorage::makeEvent(const SqlRaiiTransactor &)
     Event event;
 
     { // insert a new record in the database
-        QSqlQuery query(database());
-        query.prepare(QLatin1String("INSERT into Events values "
-                                    "( NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL );"));
+        QSqlQuery &query = preparedQuery(InsertEvent);
         result = runQuery(query);
         Q_ASSERT(result); // this has to suceed
     }
     if (result) { // retrieve the AUTOINCREMENT id value of it
-        const QString statement = QString::fromLocal8Bit(
-            "SELECT id from Events WHERE id = %1();").arg(
-            lastInsertRowFunction());
-        QSqlQuery query(database());
-        query.prepare(statement);
+        QSqlQuery &query = preparedQuery(GetLastInsertedEvent);
         result = runQuery(query);
         if (result && query.next()) {
-            int indexField = query.record().indexOf(QStringLiteral("id"));
-            event.setId(query.value(indexField).toInt());
+            event.setId(query.value(0).toInt());
             Q_ASSERT(event.id() > 0);
         } else {
             Q_ASSERT_X(false, Q_FUNC_INFO,
                        "database implementation error (SELECT)");
         }
+        query.finish();
     }
     if (result) {
         // modify the created record to make sure event_id is unique
         // within the installation:
-        QSqlQuery query(database());
-        query.prepare(QLatin1String("UPDATE Events SET event_id = :event_id, "
-                                    "installation_id = :installation_id, report_id = :report_id WHERE id = :id;"));
-        query.bindValue(QStringLiteral(":event_id"), event.id());
-        query.bindValue(QStringLiteral(":installation_id"), 1);
-        query.bindValue(QStringLiteral(":report_id"), event.reportId());
-        query.bindValue(QStringLiteral(":id"), event.id());
+        QSqlQuery &query = preparedQuery(InitializeEvent);
+        query.bindValue(0, event.id());
+        query.bindValue(1, 1);
+        query.bindValue(2, event.reportId());
+        query.bindValue(3, event.id());
         result = runQuery(query);
         Q_ASSERT_X(result, Q_FUNC_INFO,
                    "database implementation error (UPDATE)");
@@ -325,21 +572,62 @@ Event SqlStorage::makeEvent(const SqlRaiiTransactor &)
     }
 }
 
+EventIdList SqlStorage::addEvents(const EventList &events, const SqlRaiiTransactor &)
+{
+    if (events.isEmpty())
+        return EventIdList();
+
+    // the database assigns the ids: reserving a block after the highest id
+    // in use is not safe, on MySQL reading it is a snapshot read that does
+    // not keep other writers to a shared database from using the same ids
+    EventIdList ids;
+    ids.reserve(events.size());
+    Q_FOREACH (const Event &event, events) {
+        int id = 0;
+        {
+            QSqlQuery &query = preparedQuery(AddEvent);
+            query.bindValue(0, event.userId());
+            query.bindValue(1, 1);
+            query.bindValue(2, event.reportId());
+            query.bindValue(3, event.taskId());
+            query.bindValue(4, event.comment());
+            query.bindValue(5, event.startDateTime());
+            query.bindValue(6, event.endDateTime());
+            if (!runQuery(query))
+                return EventIdList();
+            id = query.lastInsertId().toInt();
+            if (id <= 0)
+                return EventIdList();
+        }
+        {
+            // event_id is the same as the row id, see makeEvent:
+            QSqlQuery &query = preparedQuery(InitializeEvent);
+            query.bindValue(0, id);
+            query.bindValue(1, 1);
+            query.bindValue(2, event.reportId());
+            query.bindValue(3, id);
+            if (!runQuery(query))
+                return EventIdList();
+        }
+        ids.append(id);
+    }
+    return ids;
+}
+
 Event SqlStorage::getEvent(int id)
 {
-    QSqlQuery query(database());
-    query.prepare(QStringLiteral("SELECT * FROM Events WHERE event_id = :id;"));
-    query.bindValue(QStringLiteral(":id"), id);
+    QSqlQuery &query = preparedQuery(GetEvent);
+    query.bindValue(0, id);
 
+    Event event;
     if (runQuery(query) && query.next()) {
-        Event event = makeEventFromRecord(query.record());
+        event = makeEventFromRecord(query.record());
         // FIXME this is going to fail with multiple installations
         Q_ASSERT(!query.next()); // eventid has to be unique
         Q_ASSERT(event.isValid()); // only valid events in database
-        return event;
-    } else {
-        return Event();
     }
+    query.finish();
+    return event;
 }
 
 bool SqlStorage:: modifyEvent(const Event &event)
@@ -355,30 +643,55 @@ bool SqlStorage:: modifyEvent(const Event &event)
 
 bool SqlStorage::modifyEvent(const Event &event, const SqlRaiiTransactor &)
 {
-    QSqlQuery query(database());
-    query.prepare(QLatin1String("UPDATE Events set task = :task, comment = :comment, "
-                                "start = :start, end = :end, user_id = :user, report_id = :report "
-                                "where event_id = :id;"));
-    query.bindValue(QStringLiteral(":id"), event.id());
-    query.bindValue(QStringLiteral(":user"), event.userId());
-    query.bindValue(QStringLiteral(":task"), event.taskId());
-    query.bindValue(QStringLiteral(":report"), event.reportId());
-    query.bindValue(QStringLiteral(":comment"), event.comment());
-    query.bindValue(QStringLiteral(":start"), event.startDateTime());
-    query.bindValue(QStringLiteral(":end"), event.endDateTime());
+    QSqlQuery &query = preparedQuery(ModifyEvent);
+    query.bindValue(0, event.taskId());
+    query.bindValue(1, event.comment());
+    query.bindValue(2, event.startDateTime());
+    query.bindValue(3, event.endDateTime());
+    query.bindValue(4, event.userId());
+    query.bindValue(5, event.reportId());
+    query.bindValue(6, event.id());
 
     return runQuery(query);
 }
 
 bool SqlStorage::deleteEvent(const Event &event)
 {
-    QSqlQuery query(database());
-    query.prepare(QStringLiteral("DELETE from Events where event_id = :id;"));
-    query.bindValue(QStringLiteral(":id"), event.id());
+    SqlRaiiTransactor transactor(database());
+    if (deleteEvent(event, transactor)) {
+        transactor.commit();
+        return true;
+    } else {
+        return false;
+    }
+}
+
+bool SqlStorage::deleteEvent(const Event &event, const SqlRaiiTransactor &)
+{
+    QSqlQuery &query = preparedQuery(DeleteEvent);
+    query.bindValue(0, event.id());
 
     return runQuery(query);
 }
 
+bool SqlStorage::applyEventChanges(const EventList &added, const EventList &modified,
+                                   const EventList &deleted, EventIdList &addedIds)
+{
+    SqlRaiiTransactor transactor(database());
+    addedIds = addEvents(added, transactor);
+    if (addedIds.size() != added.size())
+        return false;
+    Q_FOREACH (const Event &event, modified) {
+        if (!modifyEvent(event, transactor))
+            return false;
+    }
+    Q_FOREACH (const Event &event, deleted) {
+        if (!deleteEvent(event, transactor))
+            return false;
+    }
+    return transactor.commit();
+}
+
 bool SqlStorage::deleteAllEvents()
 {
     SqlRaiiTransactor transactor(database());
@@ -392,8 +705,7 @@ bool SqlStorage::deleteAllEvents()
 
 bool SqlStorage::deleteAllEvents(const SqlRaiiTransactor &)
 {
-    QSqlQuery query(database());
-    query.prepare(QStringLiteral("DELETE from Events;"));
+    QSqlQuery &query = preparedQuery(DeleteAllEvents);
     return runQuery(query);
 }
 
@@ -418,31 +730,45 @@ bool SqlStorage::runQuery(QSqlQuery &query)
 #endif
 }
 
-bool SqlStorage::migrateDB(const QString &queryString, int oldVersion)
+bool SqlStorage::migrateDB(int fromVersion)
 {
-    const QFileInfo info(Configuration::instance().localStorageDatabase);
+    const QVector<Migration> steps = migrations();
+    QVector<Migration>::const_iterator step = steps.constBegin();
+    while (step != steps.constEnd() && step->fromVersion != fromVersion)
+        ++step;
+    if (step == steps.constEnd())
+        throw UnsupportedDatabaseVersionException(QObject::tr("Database version is not supported."));
+
+    // keep a copy of the database as it was before the first step:
+    const QFileInfo info(database().databaseName());
     if (info.exists()) {
-        QFile::copy(info.fileName(), info.fileName().append(QStringLiteral("-backup-version-%1")
-                                                            .arg(oldVersion)));
+        QFile::copy(info.absoluteFilePath(),
+                    info.absoluteFilePath() + QStringLiteral("-backup-version-%1").arg(fromVersion));
     }
-    SqlRaiiTransactor transactor(database());
-    QSqlQuery query(database());
-    query.prepare(queryString);
-    if (!runQuery(query)) {
-        throw UnsupportedDatabaseVersionException(QObject::tr(
-                                                      "Could not upgrade database from version %1 to version %2: %3").arg(
-                                                      QString::number(
-                                                          oldVersion),
-                                                      QString
-                                                      ::
-                                                      number(oldVersion + 1),
-                                                      query
-                                                      .
-                                                      lastError().text()));
-    }
-    setMetaData(CHARM_DATABASE_VERSION_DESCRIPTOR, QString::number(oldVersion + 1), transactor);
-    transactor.commit();
-    return verifyDatabase();
+
+    int version = fromVersion;
+    for (; step != steps.constEnd(); ++step) {
+        Q_ASSERT(step->fromVersion == version);
+        clearStatementCache();
+        SqlRaiiTransactor transactor(database());
+        Q_FOREACH (const QString &statement, step->statements) {
+            QSqlQuery query(database());
+            query.prepare(statement);
+            if (!runQuery(query)) {
+                throw UnsupportedDatabaseVersionException(
+                    QObject::tr("Could not upgrade database from version %1 to version %2: %3")
+                    .arg(QString::number(version), QString::number(version + 1),
+                         query.lastError().text()));
+            }
+        }
+        setMetaData(CHARM_DATABASE_VERSION_DESCRIPTOR, QString::number(version + 1), transactor);
+        transactor.commit();
+        ++version;
+    }
+
+    if (version != CHARM_DATABASE_VERSION)
+        throw UnsupportedDatabaseVersionException(QObject::tr("Database version is not supported."));
+    return true;
 }
 
 void SqlStorage::stateChanged(State previous)
@@ -455,9 +781,8 @@ User SqlStorage::getUser(int userid)
 {
     User user;
 
-    QSqlQuery query(database());
-    query.prepare(QStringLiteral("SELECT * from Users WHERE user_id = :user_id;"));
-    query.bindValue(QStringLiteral(":user_id"), userid);
+    QSqlQuery &query = preparedQuery(GetUser);
+    query.bindValue(0, userid);
 
     if (runQuery(query)) {
         if (query.next()) {
@@ -472,6 +797,7 @@ User SqlStorage::getUser(int userid)
             qCritical() << "SqlStorage::getUser: no user with id" << userid;
         }
     }
+    query.finish();
 
     return user;
 }
@@ -484,10 +810,8 @@ User SqlStorage::makeUser(const QString &name)
     user.setName(name);
 
     { // create a new record:
-        QSqlQuery query(database());
-        query.prepare(QStringLiteral(
-                          "INSERT into Users ( id, user_id, name ) VALUES (NULL, NULL, :name);"));
-        query.bindValue(QStringLiteral(":name"), user.name());
+        QSqlQuery &query = preparedQuery(InsertUser);
+        query.bindValue(0, user.name());
 
         result = runQuery(query);
         if (!result) {
@@ -496,29 +820,24 @@ User SqlStorage::makeUser(const QString &name)
         }
     }
     if (result) { // find it and determine key:
-        QSqlQuery query(database());
-
-        const QString statement = QString::fromLocal8Bit(
-            "SELECT id from Users WHERE id = %1();").arg(
-            lastInsertRowFunction());
-        query.prepare(statement);
+        QSqlQuery &query = preparedQuery(GetLastInsertedUser);
 
         result = runQuery(query);
         if (result && query.next()) {
-            int idField = query.record().indexOf(QStringLiteral("id"));
-            user.setId(query.value(idField).toInt());
+            user.setId(query.value(0).toInt());
             Q_ASSERT(user.id() != 0);
+            query.finish();
         } else {
             qCritical()
                 << "SqlStorage::makeUser: FAILED to find newly created user";
+            query.finish();
             return user;
         }
     }
     if (result) { // make a unique user id:
-        QSqlQuery query(database());
-        query.prepare(QStringLiteral("UPDATE Users SET user_id = :id WHERE id = :idx;"));
-        query.bindValue(QStringLiteral(":id"), user.id());
-        query.bindValue(QStringLiteral(":idx"), user.id());
+        QSqlQuery &query = preparedQuery(InitializeUser);
+        query.bindValue(0, user.id());
+        query.bindValue(1, user.id());
         result = runQuery(query);
         if (!result)
             user.setId(0); // make invalid
@@ -532,19 +851,17 @@ User SqlStorage::makeUser(const QString &name)
 
 bool SqlStorage::modifyUser(const User &user)
 {
-    QSqlQuery query(database());
-    query.prepare(QStringLiteral("UPDATE Users SET name = :name WHERE user_id = :id;"));
-    query.bindValue(QStringLiteral(":name"), user.name());
-    query.bindValue(QStringLiteral(":id"), user.id());
+    QSqlQuery &query = preparedQuery(ModifyUser);
+    query.bindValue(0, user.name());
+    query.bindValue(1, user.id());
 
     return runQuery(query);
 }
 
 bool SqlStorage::deleteUser(const User &user)
 {
-    QSqlQuery query(database());
-    query.prepare(QStringLiteral("DELETE from Users WHERE user_id = :id;"));
-    query.bindValue(QStringLiteral(":id"), user.id());
+    QSqlQuery &query = preparedQuery(DeleteUser);
+    query.bindValue(0, user.id());
     return runQuery(query);
 }
 
@@ -553,10 +870,9 @@ bool SqlStorage::addSubscription(User user, Task task)
     Task dbTask = getTask(task.id());
 
     if (!dbTask.isValid() || (dbTask.isValid() && !dbTask.subscribed())) {
-        QSqlQuery query(database());
-        query.prepare(QStringLiteral("INSERT into Subscriptions VALUES (NULL, :user_id, :task);"));
-        query.bindValue(QStringLiteral(":user_id"), user.id());
-        query.bindValue(QStringLiteral(":task"), task.id());
+        QSqlQuery &query = preparedQuery(AddSubscription);
+        query.bindValue(0, user.id());
+        query.bindValue(1, task.id());
         return runQuery(query);
     } else {
         return true;
@@ -565,11 +881,9 @@ bool SqlStorage::addSubscription(User user, Task task)
 
 bool SqlStorage::deleteSubscription(User user, Task task)
 {
-    QSqlQuery query(database());
-    query.prepare(QStringLiteral(
-                      "DELETE from Subscriptions WHERE user_id = :user_id AND task = :task;"));
-    query.bindValue(QStringLiteral(":user_id"), user.id());
-    query.bindValue(QStringLiteral(":task"), task.id());
+    QSqlQuery &query = preparedQuery(DeleteSubscription);
+    query.bindValue(0, user.id());
+    query.bindValue(1, task.id());
     return runQuery(query);
 }
 
@@ -588,29 +902,27 @@ bool SqlStorage::setMetaData(const QString &key, const QString &value, const Sql
     // find out if the key is in the database:
     bool result;
     {
-        QSqlQuery query(database());
-        query.prepare(QStringLiteral("SELECT * FROM MetaData WHERE MetaData.key = :key;"));
-        query.bindValue(QStringLiteral(":key"), key);
+        QSqlQuery &query = preparedQuery(GetMetaData);
+        query.bindValue(0, key);
         if (runQuery(query) && query.next()) {
             result = true;
         } else {
             result = false;
         }
+        query.finish();
     }
 
     if (result) { // key exists, let's update:
-        QSqlQuery query(database());
-        query.prepare(QStringLiteral("UPDATE MetaData SET value = :value WHERE key = :key;"));
-        query.bindValue(QStringLiteral(":value"), value);
-        query.bindValue(QStringLiteral(":key"), key);
+        QSqlQuery &query = preparedQuery(UpdateMetaData);
+        query.bindValue(0, value);
+        query.bindValue(1, key);
 
         return runQuery(query);
     } else {
         // key does not exist, let's insert:
-        QSqlQuery query(database());
-        query.prepare(QStringLiteral("INSERT INTO MetaData VALUES ( NULL, :key, :value );"));
-        query.bindValue(QStringLiteral(":key"), key);
-        query.bindValue(QStringLiteral(":value"), value);
+        QSqlQuery &query = preparedQuery(InsertMetaData);
+        query.bindValue(0, key);
+        query.bindValue(1, value);
 
         return runQuery(query);
     }
@@ -620,16 +932,16 @@ bool SqlStorage::setMetaData(const QString &key, const QString &value, const Sql
 
 QString SqlStorage::getMetaData(const QString &key)
 {
-    QSqlQuery query(database());
-    query.prepare(QStringLiteral("SELECT * FROM MetaData WHERE key = :key;"));
-    query.bindValue(QStringLiteral(":key"), key);
+    QSqlQuery &query = preparedQuery(GetMetaData);
+    query.bindValue(0, key);
 
+    QString value;
     if (runQuery(query) && query.next()) {
         int valueField = query.record().indexOf(QStringLiteral("value"));
-        return query.value(valueField).toString();
-    } else {
-        return QString();
+        value = query.value(valueField).toString();
     }
+    query.finish();
+    return value;
 }
 
 Task SqlStorage::makeTaskFromRecord(const QSqlRecord &record)
@@ -681,10 +993,12 @@ QString SqlStorage::setAllTasksAndEvents(const User &user, const TaskList &tasks
     Q_ASSERT(getAllTasks().isEmpty());
 
     // now import Events and Tasks from the XML document:
+    QSet<TaskId> taskIds;
     Q_FOREACH (const Task &task, tasks) {
         // don't use our own addTask method, it emits signals and that
         // confuses the model, because the task tree is not inserted depth-first:
         if (addTask(task, transactor)) {
+            taskIds.insert(task.id());
             if (task.subscribed()) {
                 bool result = addSubscription(user, task);
                 Q_ASSERT(result);
@@ -698,20 +1012,18 @@ QString SqlStorage::setAllTasksAndEvents(const User &user, const TaskList &tasks
             return QObject::tr("Cannot add imported tasks.");
         }
     }
+    EventList newEvents;
+    newEvents.reserve(events.size());
     Q_FOREACH (const Event &event, events) {
         if (!event.isValid()) continue;
-        Task task = getTask(event.taskId());
-        if (!task.isValid()) {
+        if (!taskIds.contains(event.taskId())) {
             // semantical error
             continue;
         }
-        Event newEvent = makeEvent(transactor);
-        int id = newEvent.id();
-        newEvent = event;
-        newEvent.setId(id);
-        if (!modifyEvent(newEvent, transactor))
-            return QObject::tr("Error adding imported event.");
+        newEvents.append(event);
     }
+    if (addEvents(newEvents, transactor).size() != newEvents.size())
+        return QObject::tr("Error adding imported event.");
 
     transactor.commit();
     return QString();
@@ -24,18 +24,24 @@
 #ifndef SQLSTORAGE_H
 #define SQLSTORAGE_H
 
+#include <QHash>
+#include <QSqlQuery>
 #include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <functional>
 
 #include "Task.h"
 #include "User.h"
 #include "State.h"
 #include "Event.h"
 #include "CharmExceptions.h"
+#include "Configuration.h"
 
+class DurationRollup;
 class QSqlDatabase;
-class QSqlQuery;
 class QSqlRecord;
-class Configuration;
 class SqlRaiiTransactor;
 
 class SqlStorage
@@ -53,6 +59,10 @@ public:
 
     virtual QSqlDatabase &database() = 0;
 
+    // apply the durability profile to the open connection
+    // backends that cannot tune this just return true
+    virtual bool setDurability(Configuration::DatabaseDurability durability);
+
     // application:
     void stateChanged(State previous);
 
@@ -62,9 +72,23 @@ public:
     bool modifyUser(const User &user);
     bool deleteUser(const User &user);
 
+    /** Visitors for reading all tasks or events row by row.
+     * Return false to stop the iteration.
+     */
+    typedef std::function<bool (const Task &)> TaskVisitor;
+    typedef std::function<bool (const Event &)> EventVisitor;
+
     // task database functions:
     TaskList getAllTasks();
+    /** Pass all tasks to @p visitor, without building a list first.
+     * @return false if the query failed or the visitor stopped the iteration
+     */
+    bool visitAllTasks(const TaskVisitor &visitor);
     bool setAllTasks(const User &user, const TaskList &tasks);
+    /** Add and modify the given tasks in one transaction. The subscriptions are not changed.
+     * @param added new tasks, parents before their children
+     */
+    bool applyTaskChanges(const TaskList &added, const TaskList &modified);
     bool addTask(const Task &task);
     bool addTask(const Task &task, const SqlRaiiTransactor &);
     Task getTask(int taskid);
@@ -75,14 +99,35 @@ public:
 
     // event database functions:
     EventList getAllEvents();
+    /** Pass all events to @p visitor, without building a list first.
+     * @return false if the query failed or the visitor stopped the iteration
+     */
+    bool visitAllEvents(const EventVisitor &visitor);
+    /** All events that start at or after @p start, and the events without a start time. */
+    EventList getEventsStartingSince(const QDateTime &start);
+    /** All events that start at or after @p start and before @p end.
+     * If @p start is invalid, all events that start before @p end.
+     */
+    EventList getEventsThatStartInTimeFrame(const QDateTime &start, const QDateTime &end);
 
     // all events are created by the storage interface
     Event makeEvent();
     Event makeEvent(const SqlRaiiTransactor &);
+    /** Add complete events in one go.
+     * The database assigns new ids, the ids of @p events are ignored.
+     * @return the new ids, in the order of @p events, or an empty list on failure
+     */
+    EventIdList addEvents(const EventList &events, const SqlRaiiTransactor &);
     Event getEvent(int eventid);
     bool modifyEvent(const Event &event);
     bool modifyEvent(const Event &event, const SqlRaiiTransactor &);
     bool deleteEvent(const Event &event);
+    bool deleteEvent(const Event &event, const SqlRaiiTransactor &);
+    /** Add, modify and delete the given events in one transaction.
+     * @param addedIds the new ids of the added events, see addEvents()
+     */
+    bool applyEventChanges(const EventList &added, const EventList &modified,
+                           const EventList &deleted, EventIdList &addedIds);
     bool deleteAllEvents();
     bool deleteAllEvents(const SqlRaiiTransactor &);
 
@@ -99,6 +144,21 @@ public:
     // database metadata management functions
     QString getMetaData(const QString &);
 
+    /** A counter the database increments whenever tasks, events or
+     * subscriptions change, no matter which connection changes them.
+     * @return the counter, or -1 if the backend does not keep one
+     */
+    qint64 changeCounter();
+
+    /** Read the seconds per task and day of all events, which the
+     * database keeps up to date by itself (see durationRollupStatements()).
+     * @return false if the backend does not keep them, or the query failed
+     */
+    bool getDurationRollup(DurationRollup *rollup);
+
+    // where to keep the model snapshot, empty if the backend does not use one
+    virtual QString snapshotFileName() const;
+
     /*! @brief update all tasks and events in a single-transaction during imports
       @return an empty String on success, an error message otherwise
       */
@@ -114,6 +174,27 @@ public:
     // run the query and process possible errors
     static bool runQuery(QSqlQuery &);
 
+    /** The storage functions keep their prepared statements for reuse.
+     * The cache belongs to the current connection, backends clear it
+     * when they connect or disconnect.
+     */
+    int statementCacheHits() const;
+    int statementCacheMisses() const;
+    void clearStatementCache();
+
+    /** A step of the schema migration chain.
+     * The statements upgrade the database from version fromVersion to
+     * fromVersion + 1. They are executed in a single transaction.
+     */
+    struct Migration
+    {
+        int fromVersion;
+        QStringList statements;
+    };
+
+    /** The statements that create the indexes of the current schema. */
+    static QStringList indexStatements();
+
 protected:
     // Put the basic database structure into the database.
     // This includes creating the tables et cetera.
@@ -130,10 +211,80 @@ protected:
      */
     virtual QString lastInsertRowFunction() const = 0;
 
+    /** The migration chain, ordered by version.
+     * Backends may reimplement this if a step needs a different SQL dialect.
+     */
+    virtual QVector<Migration> migrations() const;
+
+    // create the indexes for a freshly created database
+    bool createIndexes();
+
+    /** The statements that set up the change counter, see changeCounter().
+     * They have to be safe to run on a database that already has it.
+     * The default implementation returns none.
+     */
+    virtual QStringList changeCounterStatements() const;
+    bool createChangeCounter();
+
+    /** The statements that set up the TaskDayDurations table, which
+     * keeps the seconds per task and day (see DurationRollup) updated
+     * with every change to the events. They have to be safe to run on a
+     * database that already has it. The default implementation returns
+     * none, the backend then does not keep the table.
+     */
+    virtual QStringList durationRollupStatements() const;
+    bool createDurationRollup();
+
 private:
-    bool migrateDB(const QString &queryString, int oldVersion);
+    enum Statement {
+        GetAllTasks,
+        AddTask,
+        GetTask,
+        ModifyTask,
+        DeleteTask,
+        DeleteTaskEvents,
+        DeleteAllTasks,
+        GetAllEvents,
+        GetEventsStartingSince,
+        GetEventsStartingBefore,
+        GetEventsThatStartInTimeFrame,
+        InsertEvent,
+        GetLastInsertedEvent,
+        InitializeEvent,
+        AddEvent,
+        GetEvent,
+        ModifyEvent,
+        DeleteEvent,
+        DeleteAllEvents,
+        GetUser,
+        InsertUser,
+        GetLastInsertedUser,
+        InitializeUser,
+        ModifyUser,
+        DeleteUser,
+        AddSubscription,
+        DeleteSubscription,
+        GetMetaData,
+        UpdateMetaData,
+        InsertMetaData,
+        GetDurationRollup,
+        NumberOfStatements
+    };
+
+    QString statementText(Statement) const;
+    // the prepared query for the statement, values are bound by position:
+    QSqlQuery &preparedQuery(Statement);
+
+    bool migrateDB(int fromVersion);
+    bool runStatements(const QStringList &statements);
+    EventList runEventQuery(QSqlQuery &query);
     Event makeEventFromRecord(const QSqlRecord &);
     Task makeTaskFromRecord(const QSqlRecord &);
+
+    QHash<int, QSqlQuery> m_statements;
+    QSqlQuery m_uncachedStatement;
+    int m_statementCacheHits = 0;
+    int m_statementCacheMisses = 0;
 };
 
 #endif
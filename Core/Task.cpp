@@ -26,11 +26,10 @@
 #include "Task.h"
 #include "CharmConstants.h"
 #include "CharmExceptions.h"
+#include "TaskListValidator.h"
 
 #include <QtDebug>
-
-#include <set>
-#include <algorithm>
+#include <QXmlStreamWriter>
 
 Task::Task()
 {
@@ -197,6 +196,22 @@ QDomElement Task::toXml(QDomDocument document) const
     return element;
 }
 
+void Task::toXml(QXmlStreamWriter &writer) const
+{
+    writer.writeStartElement(tagName());
+    writer.writeAttribute(TaskIdElement, QString::number(id()));
+    writer.writeAttribute(TaskParentId, QString::number(parent()));
+    writer.writeAttribute(TaskSubscribed, QString::number(subscribed() ? 1 : 0));
+    writer.writeAttribute(TaskTrackable, QString::number(trackable() ? 1 : 0));
+    if (validFrom().isValid())
+        writer.writeAttribute(TaskValidFrom, validFrom().toString(Qt::ISODate));
+    if (validUntil().isValid())
+        writer.writeAttribute(TaskValidUntil, validUntil().toString(Qt::ISODate));
+    if (!name().isEmpty())
+        writer.writeCharacters(name());
+    writer.writeEndElement();
+}
+
 Task Task::fromXml(const QDomElement &element, int databaseSchemaVersion)
 {   // in case any task object creates trouble with
     // serialization/deserialization, add an object of it to
@@ -290,90 +305,19 @@ void Task::setComment(const QString &comment)
 
 bool Task::checkForUniqueTaskIds(const TaskList &tasks)
 {
-    std::set<TaskId> ids;
-
-    for (TaskList::const_iterator it = tasks.begin(); it != tasks.end(); ++it)
-        ids.insert((*it).id());
-
-    return static_cast<int>(ids.size()) == tasks.size();
-}
-
-/** collectTaskIds visits the task and all subtasks recursively, and
- * adds all visited task ids to visitedIds.
- * @returns false if any visited task id is already in visitedIds
- * @param id the parent task to traverse
- * @param visitedIds reference to a TaskId set that contains already
- * visited task ids
- * @param tasks the tasklist to process
- */
-bool collectTaskIds(std::set<TaskId> &visitedIds, TaskId id, const TaskList &tasks)
-{
-    bool foundSelf = false;
-    TaskIdList children;
-
-    // find children and the task itself (the parameter tasks is not sorted)
-    for (TaskList::const_iterator it = tasks.begin(); it != tasks.end(); ++it) {
-        if ((*it).parent() == id)
-            children << (*it).id();
-        if ((*it).id() == id) {
-            // just checking that it really exists...
-            if (std::find(visitedIds.begin(), visitedIds.end(), id) != visitedIds.end()) {
-                return false;
-            } else {
-                if ((*it).isValid()) {
-                    visitedIds.insert(id);
-                    foundSelf = true;
-                } else {
-                    return false;
-                }
-            }
-        }
-    }
-
-    if (!foundSelf)
-        return false;
-
-    Q_FOREACH (const TaskId i, children)
-        collectTaskIds(visitedIds, i, tasks);
-
-    return true;
+    return TaskListValidator(tasks).hasUniqueTaskIds();
 }
 
 /** checkForTreeness checks a task list against cycles in the
  * parent-child relationship, and for orphans (tasks where the parent
  * task does not exist). If the task list contains invalid tasks,
  * false is returned as well.
+ * Use TaskListValidator directly to find out what the problems are.
  *
  * @return false, if cycles in the task tree or orphans have been found
  * @param tasks the tasklist to verify
  */
 bool Task::checkForTreeness(const TaskList &tasks)
 {
-    std::set<TaskId> ids;
-
-    for (TaskList::const_iterator it = tasks.begin(); it != tasks.end(); ++it) {
-        if (!(*it).isValid())
-            return false;
-        if ((*it).parent() == 0) {
-            if (!collectTaskIds(ids, (*it).id(), tasks))
-                return false;
-        }
-    }
-
-    // the count of ids now must be equal to the count of tasks,
-    // otherwise tasks contains elements that are not in the subtrees
-    // of toplevel elements
-    if (ids.size() != static_cast<unsigned>(tasks.size())) {
-#ifndef NDEBUG
-        Q_FOREACH (const Task &task, tasks) {
-            if (find(ids.begin(), ids.end(), task.id()) == ids.end()) {
-                qDebug() << "Orphan task:";
-                task.dump();
-            }
-        }
-#endif
-        return false;
-    }
-
-    return true;
+    return TaskListValidator(tasks).isValid();
 }
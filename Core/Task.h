@@ -37,6 +37,8 @@
 typedef int TaskId;
 Q_DECLARE_METATYPE(TaskId)
 
+class QXmlStreamWriter;
+
 class Task;
 /** A task list is a list of tasks that belong together.
     Example: All tasks for one user. */
@@ -98,6 +100,8 @@ public:
     static QString taskListTagName();
 
     QDomElement toXml(QDomDocument) const;
+    /** Write the same element as toXml(QDomDocument) to a stream writer. */
+    void toXml(QXmlStreamWriter &) const;
 
     static Task fromXml(const QDomElement &, int databaseSchemaVersion = 1);
 
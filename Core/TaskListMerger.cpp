@@ -23,6 +23,35 @@
 
 #include "TaskListMerger.h"
 #include "CharmExceptions.h"
+#include "TaskListValidator.h"
+
+#include <QHash>
+#include <QSet>
+
+namespace {
+// orders tasks so that a task never precedes its parent, if the
+// parent is part of the list as well:
+TaskList parentsFirst(const TaskList &tasks)
+{
+    QHash<TaskId, int> indexes;
+    for (int i = 0; i < tasks.size(); ++i)
+        indexes.insert(tasks.at(i).id(), i);
+
+    TaskList ordered;
+    ordered.reserve(tasks.size());
+    QSet<TaskId> done;
+    Q_FOREACH (const Task &task, tasks) {
+        TaskList ancestry;
+        for (int i = indexes.value(task.id(), -1); i != -1 && !done.contains(tasks.at(i).id());
+             i = indexes.value(tasks.at(i).parent(), -1)) {
+            done.insert(tasks.at(i).id());
+            ancestry.prepend(tasks.at(i));
+        }
+        ordered << ancestry;
+    }
+    return ordered;
+}
+}
 
 TaskListMerger::TaskListMerger()
 {
@@ -51,6 +80,9 @@ void TaskListMerger::setNewTasks(const TaskList &tasks)
 void TaskListMerger::calculateResults() const
 {
     if (m_resultsValid) return;
+    m_addedTasks.clear();
+    m_modifiedTasks.clear();
+    m_updatedTasks.clear();
 
     // insert sentinels at end of list:
     const TaskId maxId = qMax(
@@ -74,9 +106,11 @@ void TaskListMerger::calculateResults() const
             // manually)
             ++oldIt;
         } else if ((*oldIt).id() == (*newIt).id()) {
-            //
-            if (*oldIt != *newIt) {
+            // Task::operator==() ignores the description, an import
+            // that only changes it still has to update the task:
+            if (*oldIt != *newIt || (*oldIt).comment() != (*newIt).comment()) {
                 m_modifiedTasks << (*oldIt);
+                m_updatedTasks << (*newIt);
                 *oldIt = *newIt;
             }
             ++oldIt;
@@ -90,29 +124,36 @@ void TaskListMerger::calculateResults() const
     } while (oldIt != oldTasks.end() || newIt != newTasks.end());
 
     oldTasks.pop_back(); // remove sentinel
+    m_addedTasks = parentsFirst(m_addedTasks);
     m_results = oldTasks + m_addedTasks;
 
     // one last check: if tasks where modified through the new task
     // lists, maybe local-only tasks have become orphans?
-    if (!Task::checkForUniqueTaskIds(m_results))
+    const TaskListValidator validator(m_results);
+    if (!validator.hasUniqueTaskIds())
         throw InvalidTaskListException(QObject::tr(
-                                           "the merged task list is invalid, it contains duplicate task ids"));
+                                           "the merged task list is invalid, it contains duplicate task ids")
+                                       + QLatin1Char('\n') + validator.problemsDescription());
 
-    if (!Task::checkForTreeness(m_results))
+    if (!validator.isValid())
         throw InvalidTaskListException(QObject::tr(
-                                           "the merged tasks database is not a directed graph, this is seriously bad, go fix it"));
+                                           "the merged tasks database is not a directed graph, this is seriously bad, go fix it")
+                                       + QLatin1Char('\n') + validator.problemsDescription());
 
     m_resultsValid = true;
 }
 
 void TaskListMerger::verifyTaskList(const TaskList &tasks)
 {
-    if (!Task::checkForUniqueTaskIds(tasks))
-        throw InvalidTaskListException(QObject::tr("task list contains duplicate task ids"));
+    const TaskListValidator validator(tasks);
+    if (!validator.hasUniqueTaskIds())
+        throw InvalidTaskListException(QObject::tr("task list contains duplicate task ids")
+                                       + QLatin1Char('\n') + validator.problemsDescription());
 
-    if (!Task::checkForTreeness(tasks))
+    if (!validator.isValid())
         throw InvalidTaskListException(QObject::tr(
-                                           "task list is not a directed graph, this is seriously bad, go fix it"));
+                                           "task list is not a directed graph, this is seriously bad, go fix it")
+                                       + QLatin1Char('\n') + validator.problemsDescription());
 
 }
 
@@ -128,6 +169,12 @@ TaskList TaskListMerger::modifiedTasks() const
     return m_modifiedTasks;
 }
 
+TaskList TaskListMerger::updatedTasks() const
+{
+    calculateResults();
+    return m_updatedTasks;
+}
+
 TaskList TaskListMerger::mergedTaskList() const
 {
     calculateResults();
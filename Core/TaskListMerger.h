@@ -42,6 +42,11 @@
  * assumed new. If a task id exists in both lists, but differs,
  * newtasks is assumed to contain the newer state, and the returned
  * list will contain the task as it was in newtasks.
+ *
+ * Besides the merged list, the merger reports the difference to
+ * oldtasks: addedTasks() (ordered so that parents precede their
+ * children) and updatedTasks(). Applying these is enough to bring
+ * oldtasks to the merged state, there are never any removals.
  */
 class TaskListMerger
 {
@@ -53,7 +58,10 @@ public:
 
     TaskList mergedTaskList() const;
     TaskList addedTasks() const;
+    /** The modified tasks, in the state they had in oldtasks. */
     TaskList modifiedTasks() const;
+    /** The modified tasks, in the state they have in newtasks. */
+    TaskList updatedTasks() const;
 
 private:
     void verifyTaskList(const TaskList &tasks);
@@ -65,6 +73,7 @@ private:
     mutable TaskList m_results;
     mutable TaskList m_addedTasks;
     mutable TaskList m_modifiedTasks;
+    mutable TaskList m_updatedTasks;
 };
 
 #endif
@@ -0,0 +1,151 @@
+/*
+  TaskListValidator.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "TaskListValidator.h"
+
+#include <QHash>
+#include <QObject>
+#include <QStringList>
+#include <QVector>
+
+namespace {
+QString idsString(const TaskIdList &ids, const QString &separator)
+{
+    QStringList strings;
+    Q_FOREACH (TaskId id, ids)
+        strings << QString::number(id);
+    return strings.join(separator);
+}
+}
+
+TaskListValidator::TaskListValidator(const TaskList &tasks)
+{
+    // index the tasks by id, the first occurrence of a duplicate id wins:
+    QHash<TaskId, int> indexes;
+    indexes.reserve(tasks.size());
+    for (int i = 0; i < tasks.size(); ++i) {
+        const TaskId id = tasks[i].id();
+        if (indexes.contains(id)) {
+            if (!m_duplicateTaskIds.contains(id))
+                m_duplicateTaskIds << id;
+            continue;
+        }
+        indexes.insert(id, i);
+        if (!tasks[i].isValid())
+            m_invalidTasks << tasks[i];
+    }
+
+    // follow the parent links from every task that has not been seen yet.
+    // A task on the current path that is reached again closes a cycle:
+    enum Colour {
+        Unvisited,
+        OnPath,
+        Done
+    };
+    QVector<char> colours(tasks.size(), Unvisited);
+    QVector<int> pathPositions(tasks.size(), -1);
+    QVector<int> path;
+    for (int i = 0; i < tasks.size(); ++i) {
+        if (colours[i] != Unvisited || !tasks[i].isValid() || indexes.value(tasks[i].id()) != i)
+            continue;
+
+        path.clear();
+        int current = i;
+        Q_FOREVER {
+            colours[current] = OnPath;
+            pathPositions[current] = path.size();
+            path.append(current);
+
+            const TaskId parentId = tasks[current].parent();
+            if (parentId == 0)
+                break;   // a top level task
+            const auto parent = indexes.constFind(parentId);
+            if (parent == indexes.constEnd()) {
+                m_orphanTaskIds << tasks[current].id();
+                break;
+            }
+            if (colours[*parent] == OnPath) {
+                TaskIdList cycle;
+                for (int j = pathPositions[*parent]; j < path.size(); ++j)
+                    cycle << tasks[path[j]].id();
+                m_cycles << cycle;
+                break;
+            }
+            if (colours[*parent] == Done)
+                break;
+            current = *parent;
+        }
+
+        Q_FOREACH (int j, path)
+            colours[j] = Done;
+    }
+}
+
+bool TaskListValidator::isValid() const
+{
+    return m_invalidTasks.isEmpty() && m_duplicateTaskIds.isEmpty()
+           && m_orphanTaskIds.isEmpty() && m_cycles.isEmpty();
+}
+
+bool TaskListValidator::hasUniqueTaskIds() const
+{
+    return m_duplicateTaskIds.isEmpty();
+}
+
+TaskList TaskListValidator::invalidTasks() const
+{
+    return m_invalidTasks;
+}
+
+TaskIdList TaskListValidator::duplicateTaskIds() const
+{
+    return m_duplicateTaskIds;
+}
+
+TaskIdList TaskListValidator::orphanTaskIds() const
+{
+    return m_orphanTaskIds;
+}
+
+QList<TaskIdList> TaskListValidator::cycles() const
+{
+    return m_cycles;
+}
+
+QString TaskListValidator::problemsDescription() const
+{
+    QStringList problems;
+    if (!m_invalidTasks.isEmpty())
+        problems << QObject::tr("%n task(s) with an invalid task id", nullptr, m_invalidTasks.size());
+    if (!m_duplicateTaskIds.isEmpty()) {
+        problems << QObject::tr("duplicate task ids: %1")
+            .arg(idsString(m_duplicateTaskIds, QStringLiteral(", ")));
+    }
+    if (!m_orphanTaskIds.isEmpty()) {
+        problems << QObject::tr("tasks whose parent does not exist: %1")
+            .arg(idsString(m_orphanTaskIds, QStringLiteral(", ")));
+    }
+    Q_FOREACH (const TaskIdList &cycle, m_cycles) {
+        problems << QObject::tr("cycle in the task tree: %1")
+            .arg(idsString(cycle, QStringLiteral(" -> ")));
+    }
+    return problems.join(QLatin1Char('\n'));
+}
@@ -0,0 +1,69 @@
+/*
+  TaskListValidator.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TASKLISTVALIDATOR_H
+#define TASKLISTVALIDATOR_H
+
+#include <QList>
+#include <QString>
+
+#include "Task.h"
+
+/** TaskListValidator checks that a task list forms a tree.
+ *
+ * It finds all problems of the list in a single pass: invalid tasks
+ * (with task id 0), duplicate task ids, orphans (tasks whose parent is
+ * not in the list) and cycles in the parent-child relationship. The
+ * tasks are indexed in a hash, and the parent links are followed
+ * iteratively, colouring every task once, so the check is linear in
+ * the number of tasks.
+ */
+class TaskListValidator
+{
+public:
+    explicit TaskListValidator(const TaskList &tasks);
+
+    /** True if the tasks form a tree: no invalid tasks, no duplicates, no orphans and no cycles. */
+    bool isValid() const;
+    /** True if no task id occurs more than once. */
+    bool hasUniqueTaskIds() const;
+
+    /** The tasks with an invalid task id. */
+    TaskList invalidTasks() const;
+    /** The task ids that occur more than once, each reported once. */
+    TaskIdList duplicateTaskIds() const;
+    /** The ids of the tasks whose parent is not in the list. */
+    TaskIdList orphanTaskIds() const;
+    /** The cycles, each as the path of task ids from a task up to the
+     * task whose parent is the first one again. */
+    QList<TaskIdList> cycles() const;
+
+    /** A human readable description of the problems, one per line. */
+    QString problemsDescription() const;
+
+private:
+    TaskList m_invalidTasks;
+    TaskIdList m_duplicateTaskIds;
+    TaskIdList m_orphanTaskIds;
+    QList<TaskIdList> m_cycles;
+};
+
+#endif
@@ -0,0 +1,221 @@
+/*
+  TaskSearchIndex.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "TaskSearchIndex.h"
+
+#include <QStringList>
+
+namespace {
+const int TrigramLength = 3;
+}
+
+void TaskSearchIndex::setAllTasks(const TaskList &tasks)
+{
+    clearTasks();
+    Q_FOREACH (const Task &task, tasks) {
+        Entry entry;
+        entry.task = task;
+        m_entries.insert(task.id(), entry);
+        m_childIds[task.parent()].append(task.id());
+    }
+    reindexAll();
+}
+
+void TaskSearchIndex::addTask(const Task &task)
+{
+    Q_ASSERT(!m_entries.contains(task.id()));
+    Entry entry;
+    entry.task = task;
+    m_entries.insert(task.id(), entry);
+    m_childIds[task.parent()].append(task.id());
+    // this also indexes tasks that were added before their parent:
+    reindexSubtree(task.id());
+    invalidateLastQuery();
+}
+
+void TaskSearchIndex::modifyTask(const Task &task)
+{
+    const auto it = m_entries.find(task.id());
+    Q_ASSERT(it != m_entries.end());
+    if (it == m_entries.end())
+        return;
+
+    const Task oldTask = it->task;
+    it->task = task;
+    if (oldTask.parent() != task.parent()) {
+        m_childIds[oldTask.parent()].removeOne(task.id());
+        m_childIds[task.parent()].append(task.id());
+    }
+    // the full names of all descendants contain the task name:
+    if (oldTask.parent() != task.parent() || oldTask.name() != task.name()) {
+        reindexSubtree(task.id());
+        invalidateLastQuery();
+    }
+}
+
+void TaskSearchIndex::deleteTask(const Task &task)
+{
+    const auto it = m_entries.find(task.id());
+    if (it == m_entries.end())
+        return;
+
+    const TaskId parent = it->task.parent();
+    removePostings(task.id(), it->text);
+    m_entries.erase(it);
+    m_childIds[parent].removeOne(task.id());
+    Q_FOREACH (TaskId child, m_childIds.value(task.id()))
+        reindexSubtree(child);
+    invalidateLastQuery();
+}
+
+void TaskSearchIndex::clearTasks()
+{
+    m_entries.clear();
+    m_childIds.clear();
+    m_trigrams.clear();
+    invalidateLastQuery();
+}
+
+const QSet<TaskId> &TaskSearchIndex::find(const QString &query) const
+{
+    const QString normalized = query.simplified().toLower();
+    if (m_lastResultValid && normalized == m_lastQuery)
+        return m_lastResult;
+
+    const QStringList words = normalized.split(QLatin1Char(' '), QString::SkipEmptyParts);
+    QSet<TaskId> candidates;
+    bool haveCandidates = false;
+    if (m_lastResultValid && normalized.startsWith(m_lastQuery)) {
+        // every word of the last query is contained in a word of this one:
+        candidates = m_lastResult;
+        haveCandidates = true;
+    } else {
+        Q_FOREACH (const QString &word, words) {
+            for (int i = 0; i + TrigramLength <= word.length(); ++i) {
+                const QSet<TaskId> postings = m_trigrams.value(word.mid(i, TrigramLength));
+                if (haveCandidates) {
+                    candidates.intersect(postings);
+                } else {
+                    candidates = postings;
+                    haveCandidates = true;
+                }
+            }
+        }
+    }
+
+    m_lastResult.clear();
+    const auto matches = [this, &words](TaskId id) {
+        const QString &text = m_entries.value(id).text;
+        Q_FOREACH (const QString &word, words) {
+            if (!text.contains(word))
+                return false;
+        }
+        return true;
+    };
+    if (haveCandidates) {
+        Q_FOREACH (TaskId id, candidates) {
+            if (matches(id))
+                m_lastResult.insert(id);
+        }
+    } else {
+        for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+            if (matches(it.key()))
+                m_lastResult.insert(it.key());
+        }
+    }
+    m_lastQuery = normalized;
+    m_lastResultValid = true;
+    return m_lastResult;
+}
+
+const QString &TaskSearchIndex::fullName(TaskId id) const
+{
+    static const QString empty;
+    const auto it = m_entries.constFind(id);
+    return it == m_entries.constEnd() ? empty : it->path;
+}
+
+void TaskSearchIndex::setIdPaddingLength(int length)
+{
+    if (length == m_idPaddingLength)
+        return;
+    m_idPaddingLength = length;
+    reindexAll();
+    invalidateLastQuery();
+}
+
+void TaskSearchIndex::reindexAll()
+{
+    // index from the top of the tree down, so that the parent paths are known:
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        if (!m_entries.contains(it->task.parent()))
+            reindexSubtree(it.key());
+    }
+}
+
+void TaskSearchIndex::reindexSubtree(TaskId id)
+{
+    QVector<TaskId> stack;
+    stack.append(id);
+    while (!stack.isEmpty()) {
+        const TaskId current = stack.takeLast();
+        const auto it = m_entries.find(current);
+        if (it == m_entries.end())
+            continue;
+
+        const auto parent = m_entries.constFind(it->task.parent());
+        const QString name = it->task.name().simplified();
+        it->path = parent == m_entries.constEnd() ? name : parent->path + QLatin1Char('/') + name;
+        const QString text = QStringLiteral("%1 %2")
+                             .arg(current, m_idPaddingLength, 10, QLatin1Char('0'))
+                             .arg(it->path).toLower();
+        if (text != it->text) {
+            removePostings(current, it->text);
+            it->text = text;
+            addPostings(current, it->text);
+        }
+        stack += m_childIds.value(current);
+    }
+}
+
+void TaskSearchIndex::addPostings(TaskId id, const QString &text)
+{
+    for (int i = 0; i + TrigramLength <= text.length(); ++i)
+        m_trigrams[text.mid(i, TrigramLength)].insert(id);
+}
+
+void TaskSearchIndex::removePostings(TaskId id, const QString &text)
+{
+    for (int i = 0; i + TrigramLength <= text.length(); ++i) {
+        const auto it = m_trigrams.find(text.mid(i, TrigramLength));
+        if (it == m_trigrams.end())
+            continue;
+        it->remove(id);
+        if (it->isEmpty())
+            m_trigrams.erase(it);
+    }
+}
+
+void TaskSearchIndex::invalidateLastQuery()
+{
+    m_lastResultValid = false;
+    m_lastResult.clear();
+}
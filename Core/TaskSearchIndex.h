@@ -0,0 +1,88 @@
+/*
+  TaskSearchIndex.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TASKSEARCHINDEX_H
+#define TASKSEARCHINDEX_H
+
+#include "Task.h"
+
+#include <QHash>
+#include <QSet>
+#include <QVector>
+
+/** TaskSearchIndex finds tasks by their id and their full name (the
+    names of all ancestors and the task, separated by slashes).
+    A query matches a task if every word of it is contained in that
+    text, ignoring case.
+    The lower cased text of every task is kept, together with postings
+    of all its trigrams: words of three characters or more only need to
+    look at the tasks that contain all their trigrams. The result of
+    the last query is kept as well, a query that extends it (the user
+    typed another character) only checks the previous matches.
+    The ids are padded with zeros as they are displayed, see
+    setIdPaddingLength().
+    The full names are kept up to date when tasks are renamed or
+    moved, and can be used without building them again, see fullName().
+*/
+class TaskSearchIndex
+{
+public:
+    void setAllTasks(const TaskList &tasks);
+    void addTask(const Task &task);
+    void modifyTask(const Task &task);
+    void deleteTask(const Task &task);
+    void clearTasks();
+
+    /** Pad the indexed ids with zeros to @p length digits, like
+        CharmDataModel::taskIdAndNameString() does. */
+    void setIdPaddingLength(int length);
+
+    /** The ids of the tasks matching @p query. All tasks match an empty query.
+        The reference stays valid until the next query or change of the index. */
+    const QSet<TaskId> &find(const QString &query) const;
+
+    /** The full name of the task, or an empty string if it is not in the index. */
+    const QString &fullName(TaskId id) const;
+
+private:
+    struct Entry {
+        Task task;
+        QString path;
+        QString text;
+    };
+
+    void reindexAll();
+    void reindexSubtree(TaskId id);
+    void addPostings(TaskId id, const QString &text);
+    void removePostings(TaskId id, const QString &text);
+    void invalidateLastQuery();
+
+    QHash<TaskId, Entry> m_entries;
+    // task ids by parent task id:
+    QHash<TaskId, QVector<TaskId> > m_childIds;
+    QHash<QString, QSet<TaskId> > m_trigrams;
+    int m_idPaddingLength = 0;
+    mutable QString m_lastQuery;
+    mutable QSet<TaskId> m_lastResult;
+    mutable bool m_lastResultValid = false;
+};
+
+#endif
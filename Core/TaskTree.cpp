@@ -0,0 +1,235 @@
+/*
+  TaskTree.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "TaskTree.h"
+
+#include <QPair>
+
+#include <algorithm>
+
+TaskTree::TaskTree()
+{
+    clear();
+}
+
+void TaskTree::setAllTasks(const TaskList &tasks)
+{
+    clear();
+    m_nodes.reserve(tasks.size() + 1);
+    m_nodeIndexes.reserve(tasks.size());
+
+    QVector<int> nodes;
+    nodes.reserve(tasks.size());
+    Q_FOREACH (const Task &task, tasks) {
+        Q_ASSERT(!contains(task.id()));      // the tasks form a tree and have unique task ids
+        nodes.append(allocateNode(task));
+    }
+
+    // create parent-child-relationships, the children end up ordered by task id:
+    std::sort(nodes.begin(), nodes.end(), [this](int left, int right) {
+        return m_nodes[left].task.id() < m_nodes[right].task.id();
+    });
+    Q_FOREACH (int node, nodes)
+        link(node, parentNodeFor(m_nodes[node].task));
+}
+
+void TaskTree::clear()
+{
+    m_nodes.clear();
+    m_freeNodes.clear();
+    m_nodeIndexes.clear();
+    m_nodes.append(Node());
+    m_labelsValid = false;
+}
+
+void TaskTree::addTask(const Task &task)
+{
+    Q_ASSERT(!contains(task.id()));
+    if (contains(task.id()))
+        return;
+    const int node = allocateNode(task);
+    link(node, parentNodeFor(task));
+}
+
+void TaskTree::modifyTask(const Task &task)
+{
+    const int node = nodeFor(task.id());
+    Q_ASSERT(node != -1);
+    if (node == -1)
+        return;
+
+    m_nodes[node].task = task;
+    const int parent = parentNodeFor(task);
+    if (parent != m_nodes[node].parent) {
+        unlink(node);
+        link(node, parent);
+    }
+}
+
+void TaskTree::removeTask(TaskId id)
+{
+    const int node = nodeFor(id);
+    if (node == -1)
+        return;
+
+    Q_ASSERT_X(m_nodes[node].children.isEmpty(), Q_FUNC_INFO,
+               "Cannot remove a task that has children");
+    // keep the tree consistent anyway, orphans become top level tasks:
+    while (!m_nodes[node].children.isEmpty()) {
+        const int child = m_nodes[node].children.last();
+        unlink(child);
+        link(child, 0);
+    }
+
+    unlink(node);
+    m_nodes[node].task = Task();
+    m_nodeIndexes.remove(id);
+    m_freeNodes.append(node);
+}
+
+bool TaskTree::contains(TaskId id) const
+{
+    return m_nodeIndexes.contains(id);
+}
+
+int TaskTree::size() const
+{
+    return m_nodeIndexes.size();
+}
+
+TaskId TaskTree::maximumTaskId() const
+{
+    TaskId maxTaskId = 0;
+    for (auto it = m_nodeIndexes.constBegin(); it != m_nodeIndexes.constEnd(); ++it)
+        maxTaskId = qMax(maxTaskId, it.key());
+    return maxTaskId;
+}
+
+TaskTreeItem TaskTree::root() const
+{
+    return TaskTreeItem(this, 0);
+}
+
+TaskTreeItem TaskTree::item(TaskId id) const
+{
+    const int node = nodeFor(id);
+    return TaskTreeItem(this, node == -1 ? 0 : node);
+}
+
+TaskTreeItem TaskTree::itemAt(int node) const
+{
+    Q_ASSERT(node >= 0 && node < m_nodes.size());
+    return TaskTreeItem(this, node);
+}
+
+int TaskTree::nodeFor(TaskId id) const
+{
+    if (id <= 0)
+        return -1;
+    return m_nodeIndexes.value(id, -1);
+}
+
+int TaskTree::parentNodeFor(const Task &task) const
+{
+    const int parent = nodeFor(task.parent());
+    return parent == -1 ? 0 : parent;
+}
+
+int TaskTree::allocateNode(const Task &task)
+{
+    int node;
+    if (!m_freeNodes.isEmpty()) {
+        node = m_freeNodes.takeLast();
+        m_nodes[node].task = task;
+    } else {
+        node = m_nodes.size();
+        Node newNode;
+        newNode.task = task;
+        m_nodes.append(newNode);
+    }
+    m_nodeIndexes.insert(task.id(), node);
+    return node;
+}
+
+void TaskTree::link(int node, int parent)
+{
+    Q_ASSERT(m_nodes[node].parent == -1);
+    QVector<int> &siblings = m_nodes[parent].children;
+    m_nodes[node].parent = parent;
+    m_nodes[node].row = siblings.size();
+    siblings.append(node);
+    m_labelsValid = false;
+}
+
+void TaskTree::unlink(int node)
+{
+    const int parent = m_nodes[node].parent;
+    if (parent == -1)
+        return;
+
+    QVector<int> &siblings = m_nodes[parent].children;
+    const int row = m_nodes[node].row;
+    Q_ASSERT(siblings.value(row, -1) == node);
+    siblings.remove(row);
+    // the following siblings move up by one:
+    for (int i = row; i < siblings.size(); ++i)
+        m_nodes[siblings[i]].row = i;
+    m_nodes[node].parent = -1;
+    m_nodes[node].row = -1;
+    m_labelsValid = false;
+}
+
+const TaskTree::Node &TaskTree::labelledNode(int node) const
+{
+    if (!m_labelsValid)
+        relabel();
+    return m_nodes[node];
+}
+
+void TaskTree::relabel() const
+{
+    m_preorder.clear();
+    m_preorder.reserve(m_nodeIndexes.size() + 1);
+
+    // depth first, with an explicit stack of (node, next child) pairs:
+    QVector<QPair<int, int> > stack;
+    m_nodes[0].enter = 0;
+    m_nodes[0].depth = -1;
+    m_preorder.append(0);
+    stack.append(qMakePair(0, 0));
+    while (!stack.isEmpty()) {
+        const int node = stack.last().first;
+        const int next = stack.last().second;
+        const QVector<int> &children = m_nodes[node].children;
+        if (next < children.size()) {
+            const int child = children[next];
+            ++stack.last().second;
+            m_nodes[child].enter = m_preorder.size();
+            m_nodes[child].depth = m_nodes[node].depth + 1;
+            m_preorder.append(child);
+            stack.append(qMakePair(child, 0));
+        } else {
+            m_nodes[node].exit = m_preorder.size();
+            stack.removeLast();
+        }
+    }
+    m_labelsValid = true;
+}
@@ -0,0 +1,101 @@
+/*
+  TaskTree.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TASKTREE_H
+#define TASKTREE_H
+
+#include <QHash>
+#include <QVector>
+
+#include "Task.h"
+#include "TaskTreeItem.h"
+
+/** TaskTree keeps the task tree of the model in one contiguous array of nodes.
+    Node 0 is the imaginary root that has all top level tasks as its
+    children. Every node stores the task, the index of its parent node,
+    its row in the parent and the indexes of its children, so that
+    parent, row, child and child count lookups are constant time.
+    Task ids are mapped to nodes with a hash. Nodes of removed tasks
+    are reused, the nodes of the other tasks do not move.
+    The children of a node are ordered by task id after setAllTasks(),
+    added and re-parented tasks are appended.
+    The nodes are also labelled with their preorder enter and exit
+    positions and their depth, so that ancestry tests are two integer
+    comparisons and the tasks of a subtree are a contiguous range of
+    the preorder. The labels are recomputed lazily, on the first query
+    after the structure of the tree changed.
+*/
+class TaskTree
+{
+public:
+    TaskTree();
+
+    void setAllTasks(const TaskList &tasks);
+    void clear();
+    /** Add the task as the last child of its parent, or of the root if the parent does not exist. */
+    void addTask(const Task &task);
+    /** Replace the task. If its parent changed, it becomes the last child of the new parent. */
+    void modifyTask(const Task &task);
+    /** Remove the task. The task must not have children. */
+    void removeTask(TaskId id);
+
+    bool contains(TaskId id) const;
+    /** The number of tasks, not counting the root. */
+    int size() const;
+    TaskId maximumTaskId() const;
+
+    TaskTreeItem root() const;
+    /** The item of the task, or the root item if the task does not exist. */
+    TaskTreeItem item(TaskId id) const;
+    /** The item stored in @p node, see TaskTreeItem::node(). */
+    TaskTreeItem itemAt(int node) const;
+
+private:
+    friend class TaskTreeItem;
+
+    struct Node {
+        Task task;
+        int parent = -1;
+        int row = -1;
+        QVector<int> children;
+        // preorder labels, see relabel():
+        mutable int enter = -1;
+        mutable int exit = -1;
+        mutable int depth = -1;
+    };
+
+    int nodeFor(TaskId id) const;
+    int parentNodeFor(const Task &task) const;
+    int allocateNode(const Task &task);
+    void link(int node, int parent);
+    void unlink(int node);
+    const Node &labelledNode(int node) const;
+    void relabel() const;
+
+    QVector<Node> m_nodes;
+    QVector<int> m_freeNodes;
+    QHash<TaskId, int> m_nodeIndexes;
+    // the nodes in preorder, valid if m_labelsValid:
+    mutable QVector<int> m_preorder;
+    mutable bool m_labelsValid = false;
+};
+
+#endif
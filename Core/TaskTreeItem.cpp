@@ -3,10 +3,7 @@
 
   This file is part of Charm, a task-based time tracking application.
 
-  Copyright (C) 2007-2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
-
-  Author: Mirko Boehm <mirko.boehm@kdab.com>
-  Author: Frank Osterfeld <frank.osterfeld@kdab.com>
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
 
   This program is free software; you can redistribute it and/or modify
   it under the terms of the GNU General Public License as published by
@@ -23,119 +20,91 @@
 */
 
 #include "TaskTreeItem.h"
-
-#include <QtDebug>
+#include "TaskTree.h"
 
 TaskTreeItem::TaskTreeItem()
 {
 }
 
-TaskTreeItem::TaskTreeItem(const Task &task, TaskTreeItem *parent)
-    : m_parent(parent)
-    , m_task(task)
+TaskTreeItem::TaskTreeItem(const TaskTree *tree, int node)
+    : m_tree(tree)
+    , m_node(node)
 {
-    if (m_parent)
-        m_parent->m_children.append(this);
 }
 
-TaskTreeItem::TaskTreeItem(const TaskTreeItem &other)
+const Task &TaskTreeItem::task() const
 {
-    if (this != &other)
-        *this = other;
-}
+    static const Task InvalidTask;
 
-TaskTreeItem &TaskTreeItem::operator=(const TaskTreeItem &other)
-{
-    if (this != &other) {
-        m_children = other.m_children;
-        m_parent = other.m_parent;
-        m_task = other.m_task;
-        if (m_parent)
-            m_parent->m_children.append(this);
-    }
-    return *this;
+    if (m_tree)
+        return m_tree->m_nodes[m_node].task;
+    return InvalidTask;
 }
 
-TaskTreeItem::~TaskTreeItem()
+bool TaskTreeItem::isValid() const
 {
-    if (m_parent)
-        m_parent->m_children.removeAt(row());
+    // the root item has no parent, and thus is not valid
+    return m_tree != nullptr && m_node > 0 && task().isValid();
 }
 
-void TaskTreeItem::makeChildOf(TaskTreeItem &parent)
+TaskTreeItem TaskTreeItem::parent() const
 {
-    if (m_parent != &parent) {
-        Q_ASSERT(!parent.m_children.contains(this));      // that would be wrong
-
-        // if there is an existing parent, unregister with it:
-        // parent can only be zero if there never was a parent so far
-        if (m_parent != 0) {
-            m_parent->m_children.removeAt(row());
-            m_parent = nullptr;
-        }
-
-        // register with the new parent
-        m_parent = &parent;
-        parent.m_children.append(this);
-    } else {
-        // hm, should this be allowed?
-        // done
+    if (m_tree) {
+        const int parent = m_tree->m_nodes[m_node].parent;
+        if (parent != -1)
+            return TaskTreeItem(m_tree, parent);
     }
+    return TaskTreeItem();
 }
 
-Task &TaskTreeItem::task()
+TaskTreeItem TaskTreeItem::child(int row) const
 {
-    return m_task;
-}
-
-const Task &TaskTreeItem::task() const
-{
-    return m_task;
+    if (row >= 0 && row < childCount()) {
+        return TaskTreeItem(m_tree, m_tree->m_nodes[m_node].children[row]);
+    } else {
+        Q_ASSERT_X(false, Q_FUNC_INFO, "Invalid item position");
+        return TaskTreeItem();
+    }
 }
 
-bool TaskTreeItem::isValid() const
+int TaskTreeItem::row() const
 {
-    return m_parent != 0 && m_task.isValid();
+    const int row = m_tree ? m_tree->m_nodes[m_node].row : -1;
+    Q_ASSERT_X(row != -1, Q_FUNC_INFO,
+               "Calling row() on an invalid item");
+    return row;
 }
 
-const TaskTreeItem &TaskTreeItem::child(int row) const
+int TaskTreeItem::childCount() const
 {
-    static TaskTreeItem InvalidItem;
-
-    if (row >= 0 && row < m_children.size()) {
-        return *m_children.at(row);
-    } else {
-        Q_ASSERT_X(false, Q_FUNC_INFO, "Invalid item position");
-        return InvalidItem;
-    }
+    return m_tree ? m_tree->m_nodes[m_node].children.size() : 0;
 }
 
-int TaskTreeItem::row() const
+int TaskTreeItem::depth() const
 {
-    if (m_parent) {
-        int row = m_parent->m_children.indexOf(this);
-        Q_ASSERT_X(row != -1, Q_FUNC_INFO,
-                   "Internal error - cannot find myself in my parents family");
-        return row;
-    } else {
-        Q_ASSERT_X(false, Q_FUNC_INFO,
-                   "Calling row() on an invalid item");
-        return -1;
-    }
+    return m_tree ? m_tree->labelledNode(m_node).depth : -1;
 }
 
-int TaskTreeItem::childCount() const
+bool TaskTreeItem::isAncestorOf(const TaskTreeItem &other) const
 {
-    return m_children.size();
+    if (!m_tree || other.m_tree != m_tree || other.m_node == m_node)
+        return false;
+    const TaskTree::Node &node = m_tree->labelledNode(m_node);
+    const TaskTree::Node &otherNode = m_tree->labelledNode(other.m_node);
+    return node.enter < otherNode.enter && otherNode.enter < node.exit;
 }
 
 TaskList TaskTreeItem::children() const
 {
     TaskList tasks;
-    for (int i = 0; i < m_children.size(); ++i) {
-        tasks << m_children[i]->task()
-              << m_children[i]->children();
-    }
+    if (!m_tree)
+        return tasks;
+
+    // the subtree is the range of the preorder after the item itself:
+    const TaskTree::Node &node = m_tree->labelledNode(m_node);
+    tasks.reserve(node.exit - node.enter - 1);
+    for (int i = node.enter + 1; i < node.exit; ++i)
+        tasks << m_tree->m_nodes[m_tree->m_preorder[i]].task;
 
     return tasks;
 }
@@ -143,8 +112,17 @@ TaskList TaskTreeItem::children() const
 TaskIdList TaskTreeItem::childIds() const
 {
     TaskIdList idList;
-    // get the list of children, and sort by task id:
-    Q_FOREACH (const TaskTreeItem *item, m_children)
-        idList.append(item->task().id());
+    for (int i = 0; i < childCount(); ++i)
+        idList.append(child(i).task().id());
     return idList;
 }
+
+int TaskTreeItem::node() const
+{
+    return m_node;
+}
+
+bool TaskTreeItem::operator==(const TaskTreeItem &other) const
+{
+    return m_tree == other.m_tree && m_node == other.m_node;
+}
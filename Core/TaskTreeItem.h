@@ -3,10 +3,7 @@
 
   This file is part of Charm, a task-based time tracking application.
 
-  Copyright (C) 2007-2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
-
-  Author: Mirko Boehm <mirko.boehm@kdab.com>
-  Author: Frank Osterfeld <frank.osterfeld@kdab.com>
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
 
   This program is free software; you can redistribute it and/or modify
   it under the terms of the GNU General Public License as published by
@@ -25,60 +22,64 @@
 #ifndef TASKTREEITEM_H
 #define TASKTREEITEM_H
 
-#include <QList>
-
 #include "Task.h"
 
+class TaskTree;
+
 /** TaskTreeItem is a node in the task tree.
     The tasks form a tree, since tasks can belong to a parent task.
-    This structure is modeled by storing TaskTreeItems in a map that
-    associates them with the respective task id.
+    The nodes of the tree are stored in a TaskTree, a TaskTreeItem is
+    a lightweight handle that refers to one of them. It stays valid as
+    long as the task is in the tree.
     Every TaskTreeItem has a parent that represents the parent
     task. If a task has no parent, it is a child of the root
     TaskTreeItem stored in the model.
-    Every TaskTreeItem keeps a list of children.
     Every TaskTreeItem also has a position in it's parents list of
     children. This integer position can be retrieved by calling row on
-    the item.
+    the item, it is cached in the tree and does not require a search.
 */
 class TaskTreeItem
 {
 public:
-    typedef QList<const TaskTreeItem *> ConstPointerList;
-    typedef std::map<TaskId, TaskTreeItem> Map;
-
     TaskTreeItem();
-
-    explicit TaskTreeItem(const Task &task, TaskTreeItem *parent = nullptr);
-    TaskTreeItem(const TaskTreeItem &other);
-    TaskTreeItem &operator=(const TaskTreeItem &other);
-
-    ~TaskTreeItem();
-
-    void makeChildOf(TaskTreeItem &parent);
+    TaskTreeItem(const TaskTree *tree, int node);
 
     bool isValid() const;
 
-    Task &task();
-
     const Task &task() const;
 
-    const TaskTreeItem &child(int row) const;
+    TaskTreeItem parent() const;
+
+    TaskTreeItem child(int row) const;
 
     int row() const;
 
     int childCount() const;
 
-    // recursively find all children of this item
-    // warning: SLOW
+    /** The number of ancestors, not counting the root: top level tasks have depth 0, the root -1. */
+    int depth() const;
+
+    /** True if @p other is in the subtree below this item.
+        An item is not it's own ancestor. */
+    bool isAncestorOf(const TaskTreeItem &other) const;
+
+    // find all children of this item, recursively, in preorder
     TaskList children() const;
 
     TaskIdList childIds() const;
 
+    /** The position of the item in the node array of the tree, see TaskTree::itemAt(). */
+    int node() const;
+
+    bool operator==(const TaskTreeItem &other) const;
+    bool operator!=(const TaskTreeItem &other) const
+    {
+        return !operator==(other);
+    }
+
 private:
-    TaskTreeItem *m_parent = nullptr;
-    ConstPointerList m_children;
-    Task m_task;
+    const TaskTree *m_tree = nullptr;
+    int m_node = -1;
 };
 
 #endif
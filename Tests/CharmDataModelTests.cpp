@@ -24,6 +24,7 @@
 
 #include "CharmDataModelTests.h"
 
+#include "Core/Event.h"
 #include "Core/Task.h"
 #include "Core/TaskTreeItem.h"
 #include "Core/CharmDataModel.h"
@@ -31,6 +32,38 @@
 #include <QtDebug>
 #include <QtTest/QtTest>
 
+#include <algorithm>
+
+namespace {
+// counts the event notifications of the model:
+class RecordingAdapter : public CharmDataModelAdapterInterface
+{
+public:
+    void resetTasks() override {}
+    void taskAboutToBeAdded(TaskId, int) override {}
+    void taskAdded(TaskId) override {}
+    void taskModified(TaskId) override {}
+    void taskParentChanged(TaskId, TaskId, TaskId) override {}
+    void taskAboutToBeDeleted(TaskId) override {}
+    void taskDeleted(TaskId) override {}
+
+    void resetEvents() override { ++resets; }
+    void eventAboutToBeAdded(EventId) override {}
+    void eventAdded(EventId) override { ++singleChanges; }
+    void eventModified(EventId, Event) override { ++singleChanges; }
+    void eventAboutToBeDeleted(EventId) override {}
+    void eventDeleted(EventId) override { ++singleChanges; }
+    void eventsChanged(const EventChangeSet &changeSet) override { changes << changeSet; }
+
+    void eventActivated(EventId) override {}
+    void eventDeactivated(EventId) override {}
+
+    int resets = 0;
+    int singleChanges = 0;
+    QList<EventChangeSet> changes;
+};
+}
+
 CharmDataModelTests::CharmDataModelTests()
     : QObject()
 {
@@ -175,6 +208,329 @@ void CharmDataModelTests::modifyTaskTest()
     QVERIFY(model.taskTreeItem(0).childCount() == 0);
 }
 
+static bool checkRows(const TaskTreeItem &item)
+{
+    for (int row = 0; row < item.childCount(); ++row) {
+        const TaskTreeItem child = item.child(row);
+        if (child.row() != row || child.parent() != item || !checkRows(child))
+            return false;
+    }
+    return true;
+}
+
+void CharmDataModelTests::taskTreeRowsTest()
+{
+    CharmDataModel model;
+    model.setAllTasks(m_referenceModel->getAllTasks());
+    const TaskTreeItem root = model.taskTreeItem(0);
+    QVERIFY(checkRows(root));
+    // after setAllTasks, the children are ordered by task id:
+    QCOMPARE(root.childIds(), TaskIdList() << 1000 << 2000);
+    QCOMPARE(model.taskTreeItem(1002).row(), 1);
+    QCOMPARE(model.taskTreeItem(2220).parent().task().id(), 2200);
+    QVERIFY(!root.isValid());
+    QVERIFY(!model.taskTreeItem(2000).parent().isValid());
+
+    // removing a task moves the following siblings up:
+    const TaskTreeItem task1_3 = model.taskTreeItem(1003);
+    const Task task1_1 = model.getTask(1001);
+    model.deleteTask(task1_1);
+    QCOMPARE(model.taskTreeItem(1002).row(), 0);
+    QCOMPARE(task1_3.row(), 1);
+    QVERIFY(checkRows(root));
+
+    // added tasks are appended, and may reuse the node of a deleted task:
+    model.addTask(Task(1004, QStringLiteral("Task 1-4"), 1000));
+    QCOMPARE(model.taskTreeItem(1000).childIds(), TaskIdList() << 1002 << 1003 << 1004);
+    QCOMPARE(model.taskTreeItem(1004).row(), 2);
+    QCOMPARE(task1_3.task().id(), 1003);
+    QVERIFY(checkRows(root));
+
+    // re-parented tasks are appended to the new parent:
+    Task task1_2 = model.getTask(1002);
+    task1_2.setParent(2200);
+    model.modifyTask(task1_2);
+    QCOMPARE(model.taskTreeItem(1000).childIds(), TaskIdList() << 1003 << 1004);
+    QCOMPARE(model.taskTreeItem(2200).childIds(), TaskIdList() << 2210 << 2220 << 1002);
+    QCOMPARE(model.taskTreeItem(1002).row(), 2);
+    QCOMPARE(model.taskTreeItem(1002).parent(), model.taskTreeItem(2200));
+    QVERIFY(checkRows(root));
+    QCOMPARE(model.getAllTasks().size(), 11);
+}
+
+void CharmDataModelTests::isParentOfTest()
+{
+    CharmDataModel model;
+    model.setAllTasks(m_referenceModel->getAllTasks());
+    QVERIFY(model.isParentOf(1000, 1001));
+    QVERIFY(model.isParentOf(2000, 2210));
+    QVERIFY(model.isParentOf(2200, 2210));
+    QVERIFY(!model.isParentOf(2100, 2210));
+    QVERIFY(!model.isParentOf(1001, 1000));
+    QVERIFY(!model.isParentOf(1000, 1000));
+    QVERIFY(!model.isParentOf(9999, 1000));
+    QCOMPARE(model.taskTreeItem(0).depth(), -1);
+    QCOMPARE(model.taskTreeItem(2000).depth(), 0);
+    QCOMPARE(model.taskTreeItem(2220).depth(), 2);
+    QCOMPARE(model.taskTreeItem(2000).children().size(), 6);
+
+    // the labels follow structural changes:
+    Task task2_2 = model.getTask(2200);
+    task2_2.setParent(1000);
+    model.modifyTask(task2_2);
+    QVERIFY(model.isParentOf(1000, 2210));
+    QVERIFY(!model.isParentOf(2000, 2210));
+    QCOMPARE(model.taskTreeItem(2220).depth(), 2);
+    QCOMPARE(model.taskTreeItem(2000).children().size(), 3);
+    model.addTask(Task(2230, QStringLiteral("Task 2-2-3"), 2200));
+    QVERIFY(model.isParentOf(1000, 2230));
+    QCOMPARE(model.taskTreeItem(2230).depth(), 2);
+    QCOMPARE(model.taskTreeItem(1000).children().size(), 7);
+    const Task task2_2_1 = model.getTask(2210);
+    model.deleteTask(task2_2_1);
+    QCOMPARE(model.taskTreeItem(1000).children().size(), 6);
+}
+
+void CharmDataModelTests::fullTaskNameTest()
+{
+    CharmDataModel model;
+    model.setAllTasks(m_referenceModel->getAllTasks());
+    QCOMPARE(model.fullTaskName(model.getTask(2210)), QStringLiteral("Task 2/Task 2-2/Task 2-2-1"));
+    QCOMPARE(model.taskIdAndFullNameString(1001).section(QLatin1Char(' '), 1),
+             QStringLiteral("Task 1/Task 1-1"));
+
+    // renaming and moving a task changes the names of its subtree only:
+    Task task2_2 = model.getTask(2200);
+    task2_2.setName(QStringLiteral("Renamed"));
+    model.modifyTask(task2_2);
+    QCOMPARE(model.fullTaskName(model.getTask(2220)), QStringLiteral("Task 2/Renamed/Task 2-2-2"));
+    QCOMPARE(model.fullTaskName(model.getTask(2110)), QStringLiteral("Task 2/Task 2-1/Task 2-1-1"));
+    task2_2.setParent(1000);
+    model.modifyTask(task2_2);
+    QCOMPARE(model.fullTaskName(model.getTask(2210)), QStringLiteral("Task 1/Renamed/Task 2-2-1"));
+
+    // tasks that differ from the model are named as they are:
+    Task edited = model.getTask(2210);
+    edited.setName(QStringLiteral("Edited"));
+    QCOMPARE(model.fullTaskName(edited), QStringLiteral("Task 1/Renamed/Edited"));
+}
+
+void CharmDataModelTests::eventsThatStartInTimeFrameTest()
+{
+    CharmDataModel model;
+    const QDate monday(2019, 3, 4);
+    EventList events;
+    for (int i = 0; i < 14; ++i) {
+        Event event;
+        event.setId(100 - i);   // ids in reverse order of start times
+        event.setTaskId(1000);
+        event.setStartDateTime(QDateTime(monday.addDays(i), QTime(9, 0)));
+        event.setEndDateTime(QDateTime(monday.addDays(i), QTime(10, 0)));
+        events << event;
+    }
+    model.setAllEvents(events);
+
+    EventIdList expected;
+    for (int i = 0; i < 7; ++i)
+        expected << events[i].id();
+    QCOMPARE(model.eventsThatStartInTimeFrame(monday, monday.addDays(7)), expected);
+    QCOMPARE(model.eventIdsThatStartInTimeFrame(monday, monday.addDays(7)).size(), 7);
+    QVERIFY(model.eventIdsThatStartInTimeFrame(monday, monday).isEmpty());
+    QVERIFY(model.eventsThatStartInTimeFrame(monday.addDays(-7), monday).isEmpty());
+
+    // moving an event out of the range updates the index:
+    Event moved = events[3];
+    moved.setStartDateTime(QDateTime(monday.addDays(10), QTime(9, 0)));
+    moved.setEndDateTime(QDateTime(monday.addDays(10), QTime(10, 0)));
+    model.modifyEvent(moved);
+    expected.removeAll(moved.id());
+    QCOMPARE(model.eventsThatStartInTimeFrame(monday, monday.addDays(7)), expected);
+
+    // adding and deleting:
+    Event added;
+    added.setId(200);
+    added.setTaskId(1000);
+    added.setStartDateTime(QDateTime(monday, QTime(8, 0)));
+    added.setEndDateTime(QDateTime(monday, QTime(8, 30)));
+    model.addEvent(added);
+    expected.prepend(added.id());
+    QCOMPARE(model.eventsThatStartInTimeFrame(monday, monday.addDays(7)), expected);
+
+    model.deleteEvent(events[0]);
+    expected.removeAll(events[0].id());
+    QCOMPARE(model.eventsThatStartInTimeFrame(monday, monday.addDays(7)), expected);
+
+    model.clearEvents();
+    QVERIFY(model.eventIdsThatStartInTimeFrame(monday, monday.addDays(14)).isEmpty());
+}
+
+void CharmDataModelTests::recentEventsTest()
+{
+    CharmDataModel model;
+    QSignalSpy requests(&model, SIGNAL(eventsRequested(QDateTime,QDateTime)));
+    const QDate monday(2019, 3, 4);
+    auto makeEvent = [](EventId id, const QDate &date) {
+        Event event;
+        event.setId(id);
+        event.setTaskId(1000);
+        event.setStartDateTime(QDateTime(date, QTime(9, 0)));
+        event.setEndDateTime(QDateTime(date, QTime(10, 0)));
+        return event;
+    };
+
+    const QDateTime since(monday, QTime(0, 0));
+    EventList recent;
+    recent << makeEvent(1, monday) << makeEvent(2, monday.addDays(1));
+    model.setRecentEvents(recent, since);
+    QCOMPARE(model.eventsLoadedSince(), since);
+    QCOMPARE(model.eventCount(), 2);
+
+    // nothing to load for ranges inside the window:
+    model.ensureEventsLoadedSince(monday.addDays(1));
+    QCOMPARE(requests.count(), 0);
+
+    // older ranges are requested once:
+    model.ensureEventsLoadedSince(monday.addDays(-7));
+    QCOMPARE(requests.count(), 1);
+    QCOMPARE(requests.at(0).at(0).toDateTime(), QDateTime(monday.addDays(-7), QTime(0, 0)));
+    QCOMPARE(requests.at(0).at(1).toDateTime(), since);
+    QCOMPARE(model.eventsLoadedSince(), QDateTime(monday.addDays(-7), QTime(0, 0)));
+    model.ensureEventsLoadedSince(monday.addDays(-3));
+    QCOMPARE(requests.count(), 1);
+
+    // loaded events are added, duplicates are skipped:
+    EventList older;
+    older << makeEvent(3, monday.addDays(-5)) << makeEvent(1, monday);
+    model.addLoadedEvents(older);
+    QCOMPARE(model.eventCount(), 3);
+    QCOMPARE(model.eventsThatStartInTimeFrame(monday.addDays(-7), monday).size(), 1);
+
+    model.ensureAllEventsLoaded();
+    QCOMPARE(requests.count(), 2);
+    QVERIFY(!requests.at(1).at(0).toDateTime().isValid());
+    QCOMPARE(requests.at(1).at(1).toDateTime(), QDateTime(monday.addDays(-7), QTime(0, 0)));
+    QVERIFY(!model.eventsLoadedSince().isValid());
+    model.ensureEventsLoadedSince(monday.addYears(-10));
+    QCOMPARE(requests.count(), 2);
+
+    // a complete event list replaces the window:
+    model.setRecentEvents(recent, since);
+    model.setAllEvents(recent);
+    QVERIFY(!model.eventsLoadedSince().isValid());
+}
+
+void CharmDataModelTests::durationRollupTest()
+{
+    CharmDataModel model;
+    const QDate monday(2019, 3, 4);
+    auto makeEvent = [](EventId id, TaskId task, const QDate &date, int minutes) {
+        Event event;
+        event.setId(id);
+        event.setTaskId(task);
+        event.setStartDateTime(QDateTime(date, QTime(23, 0)));
+        event.setEndDateTime(QDateTime(date, QTime(23, 0)).addSecs(60 * minutes));
+        return event;
+    };
+    auto weekOf = [monday](const CharmDataModel &dataModel) {
+        return dataModel.durationRollup().secondsPerTask(monday, monday.addDays(7), 7, [](const QDate &date) {
+            return date.dayOfWeek() - 1;
+        });
+    };
+
+    model.setRecentEvents(EventList() << makeEvent(1, 1000, monday, 30), QDateTime(monday, QTime(0, 0)));
+    QVERIFY(!model.durationRollupIsComplete());
+    // events that pass midnight count for the day they start on:
+    model.addEvent(makeEvent(2, 1000, monday, 90));
+    QCOMPARE(weekOf(model).value(1000), QVector<int>() << 7200 << 0 << 0 << 0 << 0 << 0 << 0);
+
+    Event moved = makeEvent(2, 1001, monday.addDays(2), 90);
+    model.modifyEvent(moved);
+    QCOMPARE(weekOf(model).value(1000).at(0), 1800);
+    QCOMPARE(weekOf(model).value(1001).at(2), 5400);
+    model.deleteEvent(moved);
+    QVERIFY(!weekOf(model).contains(1001));
+
+    // a rollup from the storage already counts the events loaded later:
+    DurationRollup stored;
+    stored.addEvent(makeEvent(1, 1000, monday, 30));
+    stored.addEvent(makeEvent(3, 1000, monday.addDays(-7), 60));
+    model.setDurationRollup(stored);
+    QVERIFY(model.durationRollupIsComplete());
+    model.addLoadedEvents(EventList() << makeEvent(3, 1000, monday.addDays(-7), 60));
+    QVERIFY(model.durationRollup() == stored);
+    QCOMPARE(model.durationRollup().cell(1000, monday.addDays(-7)).seconds, 3600);
+
+    // complete event lists bring their own rollup:
+    model.setAllEvents(EventList() << makeEvent(1, 1000, monday, 30));
+    QVERIFY(model.durationRollupIsComplete());
+    QCOMPARE(model.durationRollup().cell(1000, monday.addDays(-7)).events, 0);
+}
+
+void CharmDataModelTests::bulkUpdateTest()
+{
+    CharmDataModel model;
+    auto makeEvent = [](EventId id, TaskId task) {
+        Event event;
+        event.setId(id);
+        event.setTaskId(task);
+        event.setStartDateTime(QDateTime(QDate(2019, 3, 4), QTime(9, 0)).addSecs(3600 * id));
+        event.setEndDateTime(event.startDateTime().addSecs(1800));
+        return event;
+    };
+    model.setAllEvents(EventList() << makeEvent(1, 1000) << makeEvent(2, 1000) << makeEvent(3, 1000));
+    RecordingAdapter adapter;
+    model.registerAdapter(&adapter);
+
+    model.beginBulkUpdate();
+    model.beginBulkUpdate();
+    model.addEvent(makeEvent(4, 1000));
+    model.modifyEvent(makeEvent(4, 1001));   // still an added event
+    model.addEvent(makeEvent(5, 1000));
+    model.deleteEvent(makeEvent(5, 1000));   // never seen by the adapters
+    model.modifyEvent(makeEvent(1, 1002));
+    model.deleteEvent(makeEvent(2, 1000));
+    model.deleteEvent(makeEvent(3, 1000));
+    model.addEvent(makeEvent(3, 1000));      // came back, so it is modified
+    model.endBulkUpdate();
+    QVERIFY(adapter.changes.isEmpty());
+    // the model itself is up to date during the update:
+    QCOMPARE(model.eventForId(4).taskId(), TaskId(1001));
+    model.endBulkUpdate();
+
+    QCOMPARE(adapter.singleChanges, 0);
+    QCOMPARE(adapter.changes.size(), 1);
+    const EventChangeSet changes = adapter.changes.first();
+    QCOMPARE(changes.added, EventIdList() << 4);
+    EventIdList modified = changes.modified;
+    std::sort(modified.begin(), modified.end());
+    QCOMPARE(modified, EventIdList() << 1 << 3);
+    QCOMPARE(changes.removed, EventIdList() << 2);
+    TaskIdList tasks = changes.tasks;
+    std::sort(tasks.begin(), tasks.end());
+    QCOMPARE(tasks, TaskIdList() << 1000 << 1001 << 1002);
+
+    // nothing changed, nothing to tell:
+    model.beginBulkUpdate();
+    model.addEvent(makeEvent(6, 1000));
+    model.deleteEvent(makeEvent(6, 1000));
+    model.endBulkUpdate();
+    QCOMPARE(adapter.changes.size(), 1);
+
+    // a reset includes the changes so far:
+    const int resets = adapter.resets;
+    model.beginBulkUpdate();
+    model.addEvent(makeEvent(7, 1000));
+    model.clearEvents();
+    model.endBulkUpdate();
+    QCOMPARE(adapter.resets, resets + 1);
+    QCOMPARE(adapter.changes.size(), 1);
+
+    // outside of a bulk update, the adapters hear about every change:
+    model.addEvent(makeEvent(8, 1000));
+    QCOMPARE(adapter.singleChanges, 1);
+    model.unregisterAdapter(&adapter);
+}
+
 void CharmDataModelTests::cleanupTestCase()
 {
     m_referenceModel->clearTasks();
@@ -40,6 +40,13 @@ private Q_SLOTS:
     void createAndDestroyTest();
     void addAndRemoveTasksTest();
     void modifyTaskTest();
+    void taskTreeRowsTest();
+    void isParentOfTest();
+    void fullTaskNameTest();
+    void eventsThatStartInTimeFrameTest();
+    void recentEventsTest();
+    void durationRollupTest();
+    void bulkUpdateTest();
     void cleanupTestCase();
 
 private:
@@ -265,6 +265,144 @@ void ControllerTests::toAndFromXmlTest()
     QDomDocument document2 = m_controller->exportDatabasetoXml();
 }
 
+void ControllerTests::heartbeatJournalReplayTest()
+{
+    const TaskList tasks = m_controller->storage()->getAllTasks();
+    QVERIFY(!tasks.isEmpty());
+    const QDateTime start = QDateTime::currentDateTime().addSecs(-3600);
+    Event event = m_controller->storage()->makeEvent();
+    event.setTaskId(tasks.first().id());
+    event.setStartDateTime(start);
+    event.setEndDateTime(start.addSecs(60));
+    QVERIFY(m_controller->modifyEvent(event));
+
+    // heartbeats only go to the journal, not to the database:
+    Event running = event;
+    running.setEndDateTime(start.addSecs(600));
+    m_controller->recordHeartbeat(running);
+    running.setEndDateTime(start.addSecs(1200));
+    m_controller->recordHeartbeat(running);
+    QCOMPARE(m_controller->storage()->getEvent(event.id()).duration(), 60);
+
+    // a new session replays the journal left behind by a crash:
+    m_controller->stateChanged(Connecting, Connected);
+    QCOMPARE(m_controller->storage()->getEvent(event.id()).duration(), 1200);
+
+    // a checkpoint makes the journal obsolete:
+    running.setEndDateTime(start.addSecs(1800));
+    m_controller->recordHeartbeat(running);
+    running.setEndDateTime(start.addSecs(2400));
+    QVERIFY(m_controller->modifyEvent(running));
+    m_controller->stateChanged(Connecting, Connected);
+    QCOMPARE(m_controller->storage()->getEvent(event.id()).duration(), 2400);
+}
+
+void ControllerTests::heartbeatJournalCompactionTest()
+{
+    const TaskList tasks = m_controller->storage()->getAllTasks();
+    QVERIFY(tasks.size() >= 2);
+    const QDateTime start = QDateTime::currentDateTime().addSecs(-7200);
+    Event first = m_controller->storage()->makeEvent();
+    first.setTaskId(tasks.at(0).id());
+    first.setStartDateTime(start);
+    first.setEndDateTime(start.addSecs(60));
+    QVERIFY(m_controller->modifyEvent(first));
+    Event second = m_controller->storage()->makeEvent();
+    second.setTaskId(tasks.at(1).id());
+    second.setStartDateTime(start.addSecs(30));
+    second.setEndDateTime(start.addSecs(90));
+    QVERIFY(m_controller->modifyEvent(second));
+
+    // two active events, checkpointed in turns, so one is always pending:
+    QFile journal(HeartbeatJournal::journalFileName(m_localPath));
+    for (int i = 1; i <= 50; ++i) {
+        first.setEndDateTime(start.addSecs(60 + i * 10));
+        second.setEndDateTime(start.addSecs(90 + i * 10));
+        m_controller->recordHeartbeat(first);
+        m_controller->recordHeartbeat(second);
+        QVERIFY(m_controller->modifyEvent(i % 2 ? first : second));
+        // only the last entry of the pending event is left:
+        QVERIFY(journal.open(QIODevice::ReadOnly));
+        QCOMPARE(journal.readAll().count('\n'), 1);
+        journal.close();
+    }
+
+    // the compacted journal still repairs the pending event after a crash:
+    QCOMPARE(m_controller->storage()->getEvent(first.id()).duration(), first.duration() - 10);
+    m_controller->stateChanged(Connecting, Connected);
+    QCOMPARE(m_controller->storage()->getEvent(first.id()).duration(), first.duration());
+    QCOMPARE(m_controller->storage()->getEvent(second.id()).duration(), second.duration());
+}
+
+void ControllerTests::applyTaskChangesTest()
+{
+    const Task stored = m_controller->storage()->getTask(2000);
+    QVERIFY(stored.isValid());
+    const int tasksBefore = m_definedTasks.size();
+
+    // the merger hands out tasks without subscriptions:
+    Task modified(stored);
+    modified.setName(QStringLiteral("Task-2-2-Name"));
+    modified.setComment(QStringLiteral("Task-2-2-Description"));
+    modified.setSubscribed(false);
+    const Task added(3000, QStringLiteral("Task-3-Name"), 1000);
+    QVERIFY(m_controller->applyTaskChanges(TaskList() << added, TaskList() << modified));
+
+    QCOMPARE(m_definedTasks.size(), tasksBefore + 1);
+    QVERIFY(m_definedTasks.contains(added));
+    const Task updated = m_controller->storage()->getTask(2000);
+    QCOMPARE(updated.name(), modified.name());
+    QCOMPARE(updated.comment(), modified.comment());
+    QCOMPARE(updated.subscribed(), stored.subscribed());
+    Q_FOREACH (const Task &task, m_definedTasks) {
+        if (task.id() == updated.id()) {
+            QVERIFY(task == updated);
+            QCOMPARE(task.comment(), modified.comment());
+        }
+    }
+    QCOMPARE(m_controller->storage()->getTask(3000), added);
+}
+
+void ControllerTests::applyEventChangesTest()
+{
+    const TaskList tasks = m_controller->storage()->getAllTasks();
+    QVERIFY(!tasks.isEmpty());
+    const QDateTime start = QDateTime::currentDateTime().addDays(-7);
+    Event toModify = m_controller->storage()->makeEvent();
+    toModify.setTaskId(tasks.first().id());
+    toModify.setStartDateTime(start);
+    toModify.setEndDateTime(start.addSecs(3600));
+    QVERIFY(m_controller->modifyEvent(toModify));
+    const Event toDelete = m_controller->storage()->makeEvent();
+    QVERIFY(toDelete.isValid());
+
+    QSignalSpy started(m_controller, SIGNAL(bulkUpdateStarted()));
+    QSignalSpy finished(m_controller, SIGNAL(bulkUpdateFinished()));
+    QSignalSpy added(m_controller, SIGNAL(eventAdded(Event)));
+    EventList newEvents;
+    for (int i = 0; i < 3; ++i) {
+        Event event;
+        event.setTaskId(tasks.first().id());
+        event.setStartDateTime(start.addDays(i + 1));
+        event.setEndDateTime(start.addDays(i + 1).addSecs(3600));
+        newEvents << event;
+    }
+    Event modified = toModify;
+    modified.setComment(QStringLiteral("modified"));
+    QVERIFY(m_controller->applyEventChanges(newEvents, EventList() << modified,
+                                            EventList() << toDelete));
+
+    QCOMPARE(started.count(), 1);
+    QCOMPARE(finished.count(), 1);
+    QCOMPARE(added.count(), 3);
+    Q_FOREACH (const Event &event, newEvents) {
+        QVERIFY(event.id() > 0);
+        QCOMPARE(m_controller->storage()->getEvent(event.id()).startDateTime(), event.startDateTime());
+    }
+    QCOMPARE(m_controller->storage()->getEvent(toModify.id()).comment(), modified.comment());
+    QVERIFY(!m_controller->storage()->getEvent(toDelete.id()).isValid());
+}
+
 void ControllerTests::disconnectFromBackendTest()
 {
     QVERIFY(m_controller->disconnectFromBackend());
@@ -58,6 +58,13 @@ private Q_SLOTS:
 
     void toAndFromXmlTest();
 
+    void heartbeatJournalReplayTest();
+    void heartbeatJournalCompactionTest();
+
+    void applyTaskChangesTest();
+
+    void applyEventChangesTest();
+
     // this is now done by the model:
     // void startModifyEndEventTest();
 
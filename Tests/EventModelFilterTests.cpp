@@ -22,6 +22,7 @@
 */
 
 #include "EventModelFilterTests.h"
+#include "Charm/EventModelAdapter.h"
 #include "Charm/EventModelFilter.h"
 #include "Core/CharmDataModel.h"
 #include "Core/Event.h"
@@ -306,4 +307,199 @@ void EventModelFilterTests::checkEventSpanOver2Days()
     m_referenceModel->clearEvents();
 }
 
+void EventModelFilterTests::checkAdapterRows()
+{
+    m_referenceModel->clearEvents();
+    EventModelAdapter adapter(m_referenceModel);
+    const QDateTime start = QDateTime::currentDateTime();
+    for (int i = 1; i <= 200; ++i) {
+        Event event;
+        event.setId(i);
+        event.setTaskId(1000);
+        event.setStartDateTime(start.addSecs(i * 60));
+        event.setEndDateTime(start.addSecs(i * 60 + 30));
+        m_referenceModel->addEvent(event);
+    }
+
+    // delete more events than fit between two renumberings, from the front
+    // and from the back, and add some in between:
+    for (int i = 1; i <= 100; ++i) {
+        if (i % 3 != 0)
+            m_referenceModel->deleteEvent(m_referenceModel->eventForId(i));
+    }
+    for (int i = 200; i > 150; i -= 2)
+        m_referenceModel->deleteEvent(m_referenceModel->eventForId(i));
+    for (int i = 201; i <= 210; ++i) {
+        Event event;
+        event.setId(i);
+        event.setTaskId(1000);
+        event.setStartDateTime(start);
+        event.setEndDateTime(start.addSecs(30));
+        m_referenceModel->addEvent(event);
+    }
+    m_referenceModel->deleteEvent(m_referenceModel->eventForId(99));
+
+    const EventIdList ids = m_referenceModel->eventIds();
+    QCOMPARE(adapter.rowCount(), ids.size());
+    Q_FOREACH (EventId id, ids) {
+        const QModelIndex index = adapter.indexForEvent(m_referenceModel->eventForId(id));
+        QVERIFY(index.isValid());
+        QCOMPARE(adapter.eventForIndex(index).id(), id);
+    }
+    QVERIFY(!adapter.indexForEvent(m_referenceModel->eventForId(1)).isValid());
+
+    m_referenceModel->clearEvents();
+}
+
+void EventModelFilterTests::checkOrderAndTotalDuration()
+{
+    m_referenceModel->clearEvents();
+    m_eventModelFilter->setFilterStartDate(m_thisWeekSpan.timespan.first);
+    m_eventModelFilter->setFilterEndDate(m_thisWeekSpan.timespan.second);
+    const QDateTime monday(m_thisWeekSpan.timespan.first, QTime(8, 0));
+    const auto makeEvent = [&](EventId id, int startHours, int minutes) {
+        Event event;
+        event.setId(id);
+        event.setTaskId(1000);
+        event.setStartDateTime(monday.addSecs(startHours * 3600));
+        event.setEndDateTime(monday.addSecs(startHours * 3600 + minutes * 60));
+        return event;
+    };
+    const auto ids = [this]() {
+        EventIdList ids;
+        Q_FOREACH (const Event &event, m_eventModelFilter->events())
+            ids << event.id();
+        return ids;
+    };
+
+    // added out of order, and one outside of the time frame:
+    m_referenceModel->addEvent(makeEvent(1, 2, 10));
+    m_referenceModel->addEvent(makeEvent(2, 0, 20));
+    m_referenceModel->addEvent(makeEvent(3, 1, 30));
+    m_referenceModel->addEvent(makeEvent(4, -48, 40));
+    QCOMPARE(ids(), EventIdList() << 2 << 3 << 1);
+    QCOMPARE(m_eventModelFilter->totalDuration(), 60 * 60);
+    QCOMPARE(m_eventModelFilter->indexForEvent(m_referenceModel->eventForId(3)).row(), 1);
+
+    // moving an event in time moves its row:
+    m_referenceModel->modifyEvent(makeEvent(2, 3, 5));
+    QCOMPARE(ids(), EventIdList() << 3 << 1 << 2);
+    QCOMPARE(m_eventModelFilter->totalDuration(), 45 * 60);
+    m_referenceModel->modifyEvent(makeEvent(2, -1, 5));
+    QCOMPARE(ids(), EventIdList() << 2 << 3 << 1);
+
+    // into and out of the time frame:
+    m_referenceModel->modifyEvent(makeEvent(4, 4, 40));
+    QCOMPARE(ids(), EventIdList() << 2 << 3 << 1 << 4);
+    QCOMPARE(m_eventModelFilter->totalDuration(), 85 * 60);
+    m_referenceModel->modifyEvent(makeEvent(3, -48, 30));
+    QCOMPARE(ids(), EventIdList() << 2 << 1 << 4);
+    m_referenceModel->deleteEvent(m_referenceModel->eventForId(1));
+    QCOMPARE(ids(), EventIdList() << 2 << 4);
+    QCOMPARE(m_eventModelFilter->totalDuration(), 45 * 60);
+
+    // a task filter:
+    m_eventModelFilter->setFilterTaskId(2000);
+    QVERIFY(m_eventModelFilter->events().isEmpty());
+    QCOMPARE(m_eventModelFilter->totalDuration(), 0);
+    m_eventModelFilter->setFilterTaskId(TaskId());
+    QCOMPARE(ids(), EventIdList() << 2 << 4);
+
+    m_referenceModel->clearEvents();
+}
+
+void EventModelFilterTests::checkBulkRemoval()
+{
+    m_referenceModel->clearEvents();
+    m_eventModelFilter->setFilterStartDate(m_thisWeekSpan.timespan.first);
+    m_eventModelFilter->setFilterEndDate(m_thisWeekSpan.timespan.second);
+    const QDateTime monday(m_thisWeekSpan.timespan.first, QTime(8, 0));
+    const auto makeEvent = [&](EventId id) {
+        Event event;
+        event.setId(id);
+        event.setTaskId(1000);
+        event.setStartDateTime(monday.addSecs(id * 600));
+        event.setEndDateTime(monday.addSecs(id * 600 + 60));
+        return event;
+    };
+    const auto ids = [this]() {
+        EventIdList ids;
+        Q_FOREACH (const Event &event, m_eventModelFilter->events())
+            ids << event.id();
+        return ids;
+    };
+    for (EventId id = 1; id <= 10; ++id)
+        m_referenceModel->addEvent(makeEvent(id));
+    QCOMPARE(m_eventModelFilter->rowCount(), 10);
+
+    // few enough removals that the adapter removes the rows instead of
+    // resetting, after the events are gone from the data model:
+    QSignalSpy resets(m_eventModelFilter, SIGNAL(modelReset()));
+    m_referenceModel->beginBulkUpdate();
+    m_referenceModel->deleteEvent(makeEvent(3));
+    m_referenceModel->deleteEvent(makeEvent(4));
+    m_referenceModel->deleteEvent(makeEvent(8));
+    m_referenceModel->endBulkUpdate();
+    QCOMPARE(resets.count(), 0);
+    QCOMPARE(ids(), EventIdList() << 1 << 2 << 5 << 6 << 7 << 9 << 10);
+    QCOMPARE(m_eventModelFilter->totalDuration(), 7 * 60);
+
+    // removing bulk added events, as undoing a batch command does:
+    m_referenceModel->beginBulkUpdate();
+    m_referenceModel->addEvent(makeEvent(11));
+    m_referenceModel->addEvent(makeEvent(12));
+    m_referenceModel->endBulkUpdate();
+    QCOMPARE(m_eventModelFilter->rowCount(), 9);
+    m_referenceModel->beginBulkUpdate();
+    m_referenceModel->deleteEvent(makeEvent(11));
+    m_referenceModel->deleteEvent(makeEvent(12));
+    m_referenceModel->endBulkUpdate();
+    QCOMPARE(resets.count(), 0);
+    QCOMPARE(ids(), EventIdList() << 1 << 2 << 5 << 6 << 7 << 9 << 10);
+    QCOMPARE(m_eventModelFilter->totalDuration(), 7 * 60);
+
+    m_referenceModel->clearEvents();
+}
+
+void EventModelFilterTests::checkLongEventsBeforeLoadedWindow()
+{
+    const QDate monday(2019, 3, 4);
+    const auto makeEvent = [](EventId id, const QDateTime &start, int hours) {
+        Event event;
+        event.setId(id);
+        event.setTaskId(1000);
+        event.setStartDateTime(start);
+        event.setEndDateTime(start.addSecs(hours * 3600));
+        return event;
+    };
+    // all end in the week, the longer ones start before the loaded window:
+    const EventList stored = EventList()
+                             << makeEvent(1, QDateTime(monday, QTime(9, 0)), 1)
+                             << makeEvent(2, QDateTime(monday.addDays(-2), QTime(8, 0)), 50)
+                             << makeEvent(3, QDateTime(monday.addDays(-4), QTime(8, 0)), 100);
+
+    CharmDataModel model;
+    model.setAllTasks(TaskList() << Task(1000, QStringLiteral("Task 1")));
+    const QDateTime since(monday, QTime(0, 0));
+    model.setRecentEvents(EventList() << stored.first(), since);
+    // answer the requests for older events like the controller does:
+    connect(&model, &CharmDataModel::eventsRequested,
+            &model, [&](const QDateTime &start, const QDateTime &end) {
+        EventList loaded;
+        Q_FOREACH (const Event &event, stored) {
+            if (event.startDateTime() >= start && event.startDateTime() < end)
+                loaded << event;
+        }
+        model.addLoadedEvents(loaded);
+    });
+
+    EventModelFilter filter(&model);
+    filter.setFilterStartDate(monday);
+    filter.setFilterEndDate(monday.addDays(7));
+    EventIdList ids;
+    Q_FOREACH (const Event &event, filter.events())
+        ids << event.id();
+    QCOMPARE(ids, EventIdList() << 3 << 2 << 1);
+}
+
 QTEST_MAIN(EventModelFilterTests)
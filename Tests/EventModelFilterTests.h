@@ -46,6 +46,10 @@ private Q_SLOTS:
     void checkDaysFilter();
     void checkEventSpanOver2Weeks();
     void checkEventSpanOver2Days();
+    void checkAdapterRows();
+    void checkOrderAndTotalDuration();
+    void checkBulkRemoval();
+    void checkLongEventsBeforeLoadedWindow();
 
 private:
     CharmDataModel *m_referenceModel = nullptr;
@@ -0,0 +1,160 @@
+/*
+  EventStoreTests.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "EventStoreTests.h"
+
+#include "Core/EventStore.h"
+
+#include <QtTest/QtTest>
+
+#include <map>
+
+namespace {
+Event makeEvent(EventId id, TaskId task, const QDateTime &start, const QString &comment)
+{
+    Event event;
+    event.setId(id);
+    event.setTaskId(task);
+    event.setUserId(1);
+    event.setReportId(0);
+    event.setComment(comment);
+    event.setStartDateTime(start);
+    event.setEndDateTime(start.addSecs(3600));
+    return event;
+}
+}
+
+void EventStoreTests::testInsertAndRemove()
+{
+    const QDateTime start(QDate(2019, 3, 4), QTime(9, 0));
+    EventStore store;
+    QVERIFY(store.isEmpty());
+
+    const Event e1 = makeEvent(1, 1000, start, QStringLiteral("Meeting"));
+    const Event e2 = makeEvent(2, 1001, start.addDays(1), QStringLiteral("Meeting"));
+    const Event e3 = makeEvent(3, 1002, start.addDays(2), QString());
+    store.insert(e1);
+    store.insert(e2);
+    store.insert(e3);
+    QCOMPARE(store.size(), 3);
+    QCOMPARE(store.event(1), e1);
+    QCOMPARE(store.event(2), e2);
+    QCOMPARE(store.event(3), e3);
+    QVERIFY(!store.event(4).isValid());
+    QCOMPARE(store.maximumId(), EventId(3));
+
+    // replacing keeps the slot:
+    Event e2b = e2;
+    e2b.setComment(QStringLiteral("Review"));
+    e2b.setTaskId(1003);
+    store.insert(e2b);
+    QCOMPARE(store.size(), 3);
+    QCOMPARE(store.event(2), e2b);
+
+    // removing from the middle moves the last event into the gap:
+    store.remove(1);
+    QCOMPARE(store.size(), 2);
+    QVERIFY(!store.contains(1));
+    QCOMPARE(store.event(2), e2b);
+    QCOMPARE(store.event(3), e3);
+    QCOMPARE(store.ids(), EventIdList() << 2 << 3);
+
+    // events without an end time stay without one:
+    Event open;
+    open.setId(5);
+    open.setTaskId(1000);
+    open.setStartDateTime(start);
+    store.insert(open);
+    QCOMPARE(store.event(5), open);
+    QVERIFY(!store.event(5).endDateTime().isValid());
+    store.setEndDateTime(5, start.addSecs(60));
+    QCOMPARE(store.event(5).duration(), 60);
+
+    // removing the highest id finds the next one:
+    QCOMPARE(store.maximumId(), EventId(5));
+    store.remove(5);
+    QCOMPARE(store.maximumId(), EventId(3));
+    store.remove(2);
+    QCOMPARE(store.maximumId(), EventId(3));
+
+    store.clear();
+    QVERIFY(store.isEmpty());
+    QVERIFY(!store.contains(2));
+    QCOMPARE(store.maximumId(), EventId(0));
+}
+
+void EventStoreTests::testSparseIds()
+{
+    const QDateTime start(QDate(2019, 3, 4), QTime(9, 0));
+    EventStore store;
+    const EventIdList ids = EventIdList() << -5 << 1 << 2000000 << 70000 << 3;
+    Q_FOREACH (EventId id, ids)
+        store.insert(makeEvent(id, 1000, start, QString::number(id)));
+    QCOMPARE(store.size(), ids.size());
+    Q_FOREACH (EventId id, ids)
+        QCOMPARE(store.event(id).comment(), QString::number(id));
+
+    QCOMPARE(store.maximumId(), EventId(2000000));
+
+    store.remove(2000000);
+    QCOMPARE(store.maximumId(), EventId(70000));
+    store.remove(-5);
+    QCOMPARE(store.ids(), EventIdList() << 1 << 3 << 70000);
+    QCOMPARE(store.event(70000).comment(), QStringLiteral("70000"));
+    store.remove(70000);
+    QCOMPARE(store.maximumId(), EventId(3));
+}
+
+void EventStoreTests::testMemoryUsage()
+{
+    // a history of about eight years, with a handful of recurring comments:
+    const int count = 300000;
+    const QDateTime start(QDate(2011, 1, 3), QTime(8, 0));
+    QStringList comments;
+    for (int i = 0; i < 50; ++i)
+        comments << QStringLiteral("Recurring comment number %1").arg(i);
+
+    EventStore store;
+    store.reserve(count);
+    qint64 commentBytes = 0;
+    for (int i = 0; i < count; ++i) {
+        const Event event = makeEvent(i + 1, 1000 + i % 200, start.addSecs(i * 900LL),
+                                      comments[i % comments.size()]);
+        store.insert(event);
+        // every comment read from the database is a separate allocation:
+        commentBytes += sizeof(QArrayData) + (event.comment().size() + 1) * sizeof(QChar);
+    }
+
+    // the previous layout: one std::map node per event, holding an Event
+    // with two QDateTimes, plus one comment string per event:
+    const qint64 mapNodeBytes = 4 * sizeof(void *) + sizeof(std::pair<const EventId, Event>);
+    const qint64 mapBytes = count * mapNodeBytes + commentBytes;
+    const qint64 storeBytes = store.memoryUsage();
+
+    qDebug() << "EventStore:" << storeBytes / 1024 << "KiB for" << count << "events,"
+             << "event map (estimated, without allocator and QDateTime overhead):"
+             << mapBytes / 1024 << "KiB";
+    QVERIFY(storeBytes < mapBytes);
+    QCOMPARE(store.size(), count);
+    QCOMPARE(store.event(count / 2).comment(), comments[(count / 2 - 1) % comments.size()]);
+}
+
+QTEST_MAIN(EventStoreTests)
@@ -32,6 +32,7 @@
 #include <QString>
 #include <QtTest/QtTest>
 #include <QSharedPointer>
+#include <QBuffer>
 #include <QDomDocument>
 
 ImportExportTests::ImportExportTests()
@@ -85,6 +86,109 @@ void ImportExportTests::importExportTest()
 //    }
 }
 
+void ImportExportTests::streamingImportTest()
+{
+    const QString filename = QStringLiteral(
+        ":/importExportTest/Data/test-database-export.charmdatabaseexport");
+    QFile file(filename);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QDomDocument dom;
+    QVERIFY(dom.setContent(&file));
+    QVERIFY(controller()->importDatabaseFromXml(dom).isEmpty());
+    QSharedPointer<CharmDataModel> domImport(model()->clone());
+
+    QVERIFY(file.seek(0));
+    qint64 lastPosition = -1;
+    int progressCalls = 0;
+    const QString result = controller()->importDatabaseFromXml(
+        &file, [&](qint64 bytesRead, qint64 totalBytes) {
+        ++progressCalls;
+        lastPosition = bytesRead;
+        return totalBytes == file.size();
+    });
+    QVERIFY2(result.isEmpty(), qPrintable(result));
+    QVERIFY(progressCalls > 0);
+    QCOMPARE(lastPosition, file.size());
+    QCOMPARE(*domImport.data(), *model());
+}
+
+void ImportExportTests::canceledImportTest()
+{
+    const QString filename = QStringLiteral(
+        ":/importExportTest/Data/test-database-export.charmdatabaseexport");
+    importDatabase(filename);
+    QSharedPointer<CharmDataModel> before(model()->clone());
+
+    QFile file(filename);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QString result = controller()->importDatabaseFromXml(
+        &file, [](qint64, qint64) {
+        return false;
+    });
+    QVERIFY(!result.isEmpty());
+    QCOMPARE(*before.data(), *model());
+
+    // the database has to be unchanged as well, not only the model:
+    controller()->stateChanged(Connected, Connected);
+    QCOMPARE(*before.data(), *model());
+}
+
+void ImportExportTests::invalidImportTest()
+{
+    const QString filename = QStringLiteral(
+        ":/importExportTest/Data/test-database-export.charmdatabaseexport");
+    importDatabase(filename);
+    QSharedPointer<CharmDataModel> before(model()->clone());
+
+    QFile file(filename);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QByteArray truncated = file.readAll();
+    truncated.truncate(truncated.size() / 2);
+    QBuffer buffer(&truncated);
+    QVERIFY(buffer.open(QIODevice::ReadOnly));
+    QVERIFY(!controller()->importDatabaseFromXml(&buffer).isEmpty());
+    QCOMPARE(*before.data(), *model());
+    controller()->stateChanged(Connected, Connected);
+    QCOMPARE(*before.data(), *model());
+}
+
+void ImportExportTests::streamingExportTest_data()
+{
+    QTest::addColumn<bool>("compressed");
+    QTest::newRow("plain") << false;
+    QTest::newRow("gzip") << true;
+}
+
+void ImportExportTests::streamingExportTest()
+{
+    QFETCH(bool, compressed);
+    const QString filename = QStringLiteral(
+        ":/importExportTest/Data/test-database-export.charmdatabaseexport");
+    importDatabase(filename);
+    QSharedPointer<CharmDataModel> original(model()->clone());
+
+    QBuffer buffer;
+    QVERIFY(buffer.open(QIODevice::WriteOnly));
+    const QString exportResult = controller()->exportDatabasetoXml(&buffer, compressed);
+    QVERIFY2(exportResult.isEmpty(), qPrintable(exportResult));
+    buffer.close();
+    QCOMPARE(buffer.data().startsWith("<?xml"), !compressed);
+
+    if (!compressed) {
+        // the DOM based readers have to understand the streamed export as well:
+        QDomDocument dom;
+        QVERIFY(dom.setContent(buffer.data()));
+        QCOMPARE(dom.documentElement().tagName(), QStringLiteral("charmdatabase"));
+        QVERIFY(controller()->importDatabaseFromXml(dom).isEmpty());
+        QCOMPARE(*original.data(), *model());
+    }
+
+    QVERIFY(buffer.open(QIODevice::ReadOnly));
+    const QString importResult = controller()->importDatabaseFromXml(&buffer);
+    QVERIFY2(importResult.isEmpty(), qPrintable(importResult));
+    QCOMPARE(*original.data(), *model());
+}
+
 void ImportExportTests::importBenchmark()
 {
     const QString filename = QStringLiteral(
@@ -109,6 +213,19 @@ void ImportExportTests::exportBenchmark()
     }
 }
 
+void ImportExportTests::streamingExportBenchmark()
+{
+    const QString filename = QStringLiteral(
+        ":/importExportTest/Data/test-database-export.charmdatabaseexport");
+    const QString localFileName(QStringLiteral("ImportExportTests-temp.charmdatabaseexport"));
+    importDatabase(filename);
+    QBENCHMARK {
+        QFile outfile(localFileName);
+        QVERIFY(outfile.open(QIODevice::WriteOnly));
+        QVERIFY(controller()->exportDatabasetoXml(&outfile).isEmpty());
+    }
+}
+
 void ImportExportTests::cleanupTestCase()
 {
     destroy();
@@ -118,9 +235,8 @@ void ImportExportTests::importDatabase(const QString &filename)
 {
     QFile file(filename);
     QVERIFY(file.open(QIODevice::ReadOnly));
-    QDomDocument dom;
-    QVERIFY(dom.setContent(&file));
-    QVERIFY(controller()->importDatabaseFromXml(dom).isEmpty());
+    const QString result = controller()->importDatabaseFromXml(&file);
+    QVERIFY2(result.isEmpty(), qPrintable(result));
 }
 
 QTEST_MAIN(ImportExportTests)
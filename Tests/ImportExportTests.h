@@ -36,8 +36,14 @@ public:
 private Q_SLOTS:
     void initTestCase();
     void importExportTest();
+    void streamingImportTest();
+    void canceledImportTest();
+    void invalidImportTest();
+    void streamingExportTest_data();
+    void streamingExportTest();
     void importBenchmark();
     void exportBenchmark();
+    void streamingExportBenchmark();
     void cleanupTestCase();
 
 private:
@@ -0,0 +1,295 @@
+/*
+  ModelSnapshotTests.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ModelSnapshotTests.h"
+
+#include "Core/CharmConstants.h"
+#include "Core/ModelSnapshot.h"
+#include "Core/SqLiteStorage.h"
+#include "Core/SqlRaiiTransactor.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QtTest/QtTest>
+
+#include <algorithm>
+
+namespace {
+// large enough to make the difference at startup visible:
+const int BenchmarkTaskCount = 500;
+const int BenchmarkEventCount = 100000;
+
+TaskList makeTasks()
+{
+    TaskList tasks;
+    Task root;
+    root.setId(1);
+    root.setName(QStringLiteral("Root"));
+    root.setSubscribed(true);
+    tasks << root;
+
+    Task child;
+    child.setId(2);
+    child.setParent(1);
+    child.setName(QStringLiteral("Ünïcödé child"));
+    child.setComment(QStringLiteral("A comment"));
+    child.setTrackable(false);
+    child.setValidFrom(QDateTime(QDate(2019, 1, 1), QTime(8, 0)));
+    child.setValidUntil(QDateTime(QDate(2020, 1, 1), QTime(0, 0), Qt::UTC));
+    tasks << child;
+    return tasks;
+}
+
+EventList makeEvents()
+{
+    EventList events;
+    const QDateTime start(QDate(2019, 3, 4), QTime(9, 0));
+    for (int i = 0; i < 10; ++i) {
+        Event event;
+        event.setId(i + 1);
+        event.setTaskId(1 + i % 2);
+        event.setUserId(1);
+        event.setReportId(i);
+        // repeated comments are stored once:
+        event.setComment(i % 3 == 0 ? QString() : QStringLiteral("Comment %1").arg(i % 2));
+        event.setStartDateTime(start.addSecs(i * 3600));
+        if (i != 9)
+            event.setEndDateTime(start.addSecs(i * 3600 + 1800));
+        events << event;
+    }
+    return events;
+}
+}
+
+ModelSnapshotTests::ModelSnapshotTests()
+    : QObject()
+    , m_storage(new SqLiteStorage)
+    , m_localPath(QStringLiteral("./ModelSnapshotTestDatabase.db"))
+    , m_snapshotPath(QStringLiteral("./ModelSnapshotTests.snapshot"))
+{
+}
+
+ModelSnapshotTests::~ModelSnapshotTests()
+{
+    delete m_storage;
+    m_storage = nullptr;
+}
+
+void ModelSnapshotTests::initTestCase()
+{
+    QFile::remove(m_localPath);
+    QFile::remove(m_snapshotPath);
+
+    m_configuration.installationId = 1;
+    m_configuration.user.setId(1);
+    m_configuration.localStorageType = CHARM_SQLITE_BACKEND_DESCRIPTOR;
+    m_configuration.localStorageDatabase = m_localPath;
+    m_configuration.newDatabase = true;
+    QVERIFY(m_storage->connect(m_configuration));
+}
+
+void ModelSnapshotTests::testRoundTrip()
+{
+    const TaskList tasks = makeTasks();
+    const EventList events = makeEvents();
+    QVERIFY(ModelSnapshot::write(m_snapshotPath, 42, tasks, events));
+
+    TaskList readTasks;
+    EventList readEvents;
+    QVERIFY(ModelSnapshot::read(m_snapshotPath, 42, &readTasks, &readEvents));
+    QCOMPARE(readTasks, tasks);
+    QCOMPARE(readEvents, events);
+    QCOMPARE(readTasks.at(1).validFrom().timeSpec(), Qt::LocalTime);
+    QCOMPARE(readTasks.at(1).validUntil().timeSpec(), Qt::UTC);
+
+    // empty models work as well:
+    QVERIFY(ModelSnapshot::write(m_snapshotPath, 0, TaskList(), EventList()));
+    QVERIFY(ModelSnapshot::read(m_snapshotPath, 0, &readTasks, &readEvents));
+    QVERIFY(readTasks.isEmpty());
+    QVERIFY(readEvents.isEmpty());
+}
+
+void ModelSnapshotTests::testTimeFrame()
+{
+    // written in any order, and one without a start time:
+    EventList events = makeEvents();
+    std::reverse(events.begin(), events.end());
+    Event unstarted;
+    unstarted.setId(11);
+    unstarted.setTaskId(1);
+    events << unstarted;
+    QVERIFY(ModelSnapshot::write(m_snapshotPath, 42, makeTasks(), events));
+
+    // the events come back ordered by start time:
+    TaskList readTasks;
+    EventList readEvents;
+    QVERIFY(ModelSnapshot::read(m_snapshotPath, 42, &readTasks, &readEvents));
+    QCOMPARE(readEvents, EventList() << unstarted << makeEvents());
+
+    // only the events that start in the time frame, and the one without a start time:
+    const QDateTime since = makeEvents().at(6).startDateTime();
+    QVERIFY(ModelSnapshot::read(m_snapshotPath, 42, &readTasks, &readEvents, since));
+    QCOMPARE(readTasks, makeTasks());
+    QCOMPARE(readEvents, EventList() << unstarted << makeEvents().mid(6));
+
+    QVERIFY(ModelSnapshot::read(m_snapshotPath, 42, &readTasks, &readEvents, since.addDays(1)));
+    QCOMPARE(readEvents, EventList() << unstarted);
+}
+
+void ModelSnapshotTests::testStaleSnapshot()
+{
+    const TaskList tasks = makeTasks();
+    const EventList events = makeEvents();
+    QVERIFY(ModelSnapshot::write(m_snapshotPath, 42, tasks, events));
+
+    TaskList readTasks;
+    EventList readEvents;
+    QVERIFY(!ModelSnapshot::read(m_snapshotPath, 43, &readTasks, &readEvents));
+    QVERIFY(readTasks.isEmpty());
+    QVERIFY(readEvents.isEmpty());
+    QVERIFY(!ModelSnapshot::read(m_snapshotPath + QStringLiteral("-missing"), 42,
+                                 &readTasks, &readEvents));
+}
+
+void ModelSnapshotTests::testDamagedSnapshot()
+{
+    QVERIFY(ModelSnapshot::write(m_snapshotPath, 42, makeTasks(), makeEvents()));
+    QFile file(m_snapshotPath);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray data = file.readAll();
+    file.close();
+
+    TaskList readTasks;
+    EventList readEvents;
+
+    // truncated:
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.write(data.left(data.size() - 2));
+    file.close();
+    QVERIFY(!ModelSnapshot::read(m_snapshotPath, 42, &readTasks, &readEvents));
+
+    // not a snapshot:
+    QByteArray damaged = data;
+    damaged[0] = 'X';
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.write(damaged);
+    file.close();
+    QVERIFY(!ModelSnapshot::read(m_snapshotPath, 42, &readTasks, &readEvents));
+    QVERIFY(readTasks.isEmpty());
+}
+
+void ModelSnapshotTests::testChangeCounter()
+{
+    const qint64 initial = m_storage->changeCounter();
+    QVERIFY(initial >= 0);
+
+    Task task;
+    task.setId(1);
+    task.setName(QStringLiteral("Counted"));
+    QVERIFY(m_storage->addTask(task));
+    const qint64 afterTask = m_storage->changeCounter();
+    QVERIFY(afterTask > initial);
+
+    Event event = m_storage->makeEvent();
+    QVERIFY(event.isValid());
+    event.setTaskId(task.id());
+    QVERIFY(m_storage->modifyEvent(event));
+    const qint64 afterEvent = m_storage->changeCounter();
+    QVERIFY(afterEvent > afterTask);
+
+    QVERIFY(m_storage->addSubscription(m_configuration.user, task));
+    const qint64 afterSubscription = m_storage->changeCounter();
+    QVERIFY(afterSubscription > afterEvent);
+
+    // metadata does not count:
+    QVERIFY(m_storage->setMetaData(QStringLiteral("ModelSnapshotTests"), QStringLiteral("1")));
+    QCOMPARE(m_storage->changeCounter(), afterSubscription);
+
+    QVERIFY(m_storage->deleteEvent(event));
+    QVERIFY(m_storage->deleteTask(task));
+    QVERIFY(m_storage->changeCounter() > afterSubscription);
+}
+
+void ModelSnapshotTests::startupBenchmark_data()
+{
+    QTest::addColumn<bool>("fromSnapshot");
+    QTest::newRow("sql") << false;
+    QTest::newRow("snapshot") << true;
+}
+
+void ModelSnapshotTests::startupBenchmark()
+{
+    QFETCH(bool, fromSnapshot);
+
+    if (m_storage->getAllEvents().size() < BenchmarkEventCount) {
+        QVERIFY(m_storage->deleteAllEvents());
+        QVERIFY(m_storage->deleteAllTasks());
+        SqlRaiiTransactor transactor(m_storage->database());
+        for (int i = 1; i <= BenchmarkTaskCount; ++i) {
+            Task task;
+            task.setId(i);
+            task.setParent(i > 10 ? 1 + i % 10 : 0);
+            task.setName(QStringLiteral("Task %1").arg(i));
+            QVERIFY(m_storage->addTask(task, transactor));
+        }
+        const QDateTime start(QDate(2015, 1, 1), QTime(9, 0));
+        EventList events;
+        for (int i = 0; i < BenchmarkEventCount; ++i) {
+            Event event;
+            event.setTaskId(1 + i % BenchmarkTaskCount);
+            event.setUserId(1);
+            event.setComment(QStringLiteral("Event %1").arg(i % 100));
+            event.setStartDateTime(start.addSecs(i * 3600));
+            event.setEndDateTime(start.addSecs(i * 3600 + 1800));
+            events << event;
+        }
+        QCOMPARE(m_storage->addEvents(events, transactor).size(), BenchmarkEventCount);
+        QVERIFY(transactor.commit());
+    }
+
+    const qint64 counter = m_storage->changeCounter();
+    QVERIFY(ModelSnapshot::write(m_snapshotPath, counter, m_storage->getAllTasks(),
+                                 m_storage->getAllEvents()));
+
+    TaskList tasks;
+    EventList events;
+    QBENCHMARK {
+        if (fromSnapshot) {
+            QVERIFY(ModelSnapshot::read(m_snapshotPath, m_storage->changeCounter(),
+                                        &tasks, &events));
+        } else {
+            tasks = m_storage->getAllTasks();
+            events = m_storage->getAllEvents();
+        }
+    }
+    QCOMPARE(tasks.size(), BenchmarkTaskCount);
+    QCOMPARE(events.size(), BenchmarkEventCount);
+}
+
+void ModelSnapshotTests::cleanupTestCase()
+{
+    m_storage->disconnect();
+    QVERIFY(QFile::remove(m_localPath));
+    QVERIFY(QFile::remove(m_snapshotPath));
+}
+
+QTEST_MAIN(ModelSnapshotTests)
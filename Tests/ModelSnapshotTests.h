@@ -0,0 +1,57 @@
+/*
+  ModelSnapshotTests.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MODELSNAPSHOTTESTS_H
+#define MODELSNAPSHOTTESTS_H
+
+#include <QObject>
+
+#include "Core/Configuration.h"
+
+class SqlStorage;
+
+class ModelSnapshotTests : public QObject
+{
+    Q_OBJECT
+
+public:
+    ModelSnapshotTests();
+    ~ModelSnapshotTests() override;
+
+private Q_SLOTS:
+    void initTestCase();
+    void testRoundTrip();
+    void testTimeFrame();
+    void testStaleSnapshot();
+    void testDamagedSnapshot();
+    void testChangeCounter();
+    void startupBenchmark_data();
+    void startupBenchmark();
+    void cleanupTestCase();
+
+private:
+    SqlStorage *m_storage;
+    Configuration m_configuration;
+    QString m_localPath;
+    QString m_snapshotPath;
+};
+
+#endif
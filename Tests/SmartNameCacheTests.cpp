@@ -49,4 +49,66 @@ void SmartNameCacheTests::testCache()
     QCOMPARE(cache.smartName(lotsofcakeDevelopment.id()), QLatin1String("Lotsofcake/Development"));
 }
 
+void SmartNameCacheTests::testIncrementalUpdates()
+{
+    Task projects(1, QStringLiteral("Projects"));
+    Task charm(2, QStringLiteral("Charm"), projects.id());
+    Task charmDevelopment(3, QStringLiteral("Development"), charm.id());
+    Task lotsofcake(4, QStringLiteral("Lotsofcake"), projects.id());
+    Task lotsofcakeDevelopment(5, QStringLiteral("Development"), lotsofcake.id());
+    Task internal(6, QStringLiteral("Internal"));
+    Task internalCharm(7, QStringLiteral("Charm"), internal.id());
+    Task internalCharmDevelopment(8, QStringLiteral("Development"), internalCharm.id());
+
+    SmartNameCache cache;
+    QMap<TaskId, Task> tasks;
+    // the incremental updates have to end up with the same names as a full rebuild:
+    auto compareWithRebuild = [&]() {
+        SmartNameCache rebuilt;
+        rebuilt.setAllTasks(tasks.values());
+        Q_FOREACH (const Task &task, tasks)
+            QCOMPARE(cache.smartName(task.id()), rebuilt.smartName(task.id()));
+    };
+    auto add = [&](const Task &task) {
+        cache.addTask(task);
+        tasks.insert(task.id(), task);
+    };
+    auto modify = [&](const Task &task) {
+        cache.modifyTask(task);
+        tasks.insert(task.id(), task);
+    };
+
+    // the children are added before their parents on purpose:
+    add(internalCharmDevelopment);
+    add(charmDevelopment);
+    add(charm);
+    add(projects);
+    add(internalCharm);
+    QCOMPARE(cache.smartName(internalCharm.id()), QLatin1String("Charm"));
+    compareWithRebuild();
+
+    add(internal);
+    add(lotsofcake);
+    add(lotsofcakeDevelopment);
+    QCOMPARE(cache.smartName(internalCharm.id()), QLatin1String("Internal/Charm"));
+    QCOMPARE(cache.smartName(lotsofcakeDevelopment.id()), QLatin1String("Lotsofcake/Development"));
+    compareWithRebuild();
+
+    // renaming a parent renames the descendants:
+    internal.setName(QStringLiteral("Inhouse"));
+    modify(internal);
+    QCOMPARE(cache.smartName(internalCharm.id()), QLatin1String("Inhouse/Charm"));
+    compareWithRebuild();
+
+    // the names no longer collide after a delete and a rename:
+    cache.deleteTask(lotsofcakeDevelopment);
+    tasks.remove(lotsofcakeDevelopment.id());
+    internalCharm.setName(QStringLiteral("Tools"));
+    modify(internalCharm);
+    QCOMPARE(cache.smartName(charmDevelopment.id()), QLatin1String("Charm/Development"));
+    QCOMPARE(cache.smartName(internalCharmDevelopment.id()), QLatin1String("Tools/Development"));
+    QCOMPARE(cache.smartName(lotsofcakeDevelopment.id()), QString());
+    compareWithRebuild();
+}
+
 QTEST_MAIN(SmartNameCacheTests)
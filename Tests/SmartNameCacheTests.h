@@ -32,6 +32,7 @@ class SmartNameCacheTests : public QObject
 
 private Q_SLOTS:
     void testCache();
+    void testIncrementalUpdates();
 };
 
 #endif
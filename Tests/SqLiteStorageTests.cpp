@@ -25,13 +25,54 @@
 
 #include "Core/User.h"
 #include "Core/CharmConstants.h"
+#include "Core/DurationRollup.h"
 #include "Core/SqLiteStorage.h"
+#include "Core/SqlRaiiTransactor.h"
 
 #include <QDir>
 #include <QFileInfo>
 #include <QDateTime>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlRecord>
 #include <QtTest/QtTest>
 
+#include <time.h>
+
+namespace {
+QString queryPlan(QSqlDatabase &database, const QString &statement)
+{
+    QSqlQuery query(database);
+    if (!query.exec(QStringLiteral("EXPLAIN QUERY PLAN ") + statement))
+        return QString();
+    QStringList details;
+    const int detailColumn = query.record().indexOf(QStringLiteral("detail"));
+    while (query.next())
+        details.append(query.value(detailColumn).toString());
+    return details.join(QLatin1Char('\n'));
+}
+
+QString pragmaValue(QSqlDatabase &database, const QString &pragma)
+{
+    QSqlQuery query(database);
+    if (!query.exec(QStringLiteral("PRAGMA %1;").arg(pragma)) || !query.next())
+        return QString();
+    return query.value(0).toString();
+}
+
+QStringList indexNames(QSqlDatabase &database)
+{
+    QSqlQuery query(database);
+    QStringList names;
+    if (query.exec(QStringLiteral("SELECT name FROM sqlite_master WHERE type = 'index' "
+                                  "AND sql IS NOT NULL ORDER BY name"))) {
+        while (query.next())
+            names.append(query.value(0).toString());
+    }
+    return names;
+}
+}
+
 SqLiteStorageTests::SqLiteStorageTests()
     : QObject()
     , m_storage(new SqLiteStorage)
@@ -282,6 +323,47 @@ void SqLiteStorageTests::deleteTaskWithEventsTest()
     QVERIFY(events.first() == event);
 }
 
+void SqLiteStorageTests::addEventsTest()
+{
+    const Event first = m_storage->makeEvent();
+    QVERIFY(first.isValid());
+
+    const QDateTime start = QDateTime::currentDateTime();
+    EventList events;
+    for (int i = 0; i < 100; ++i) {
+        Event event;
+        event.setId(4711); // ignored
+        event.setTaskId(1 + i % 3);
+        event.setUserId(1);
+        event.setReportId(i);
+        event.setComment(QStringLiteral("Batch event %1").arg(i));
+        event.setStartDateTime(start.addSecs(i * 3600));
+        event.setEndDateTime(start.addSecs(i * 3600 + 1800));
+        events.append(event);
+    }
+
+    EventIdList ids;
+    {
+        SqlRaiiTransactor transactor(m_storage->database());
+        ids = m_storage->addEvents(events, transactor);
+        QVERIFY(transactor.commit());
+    }
+    QCOMPARE(ids.size(), events.size());
+    for (int i = 0; i < events.size(); ++i) {
+        // with a single writer, the ids follow the highest id in use:
+        QCOMPARE(ids.at(i), first.id() + 1 + i);
+        Event expected = events.at(i);
+        expected.setId(ids.at(i));
+        QCOMPARE(m_storage->getEvent(ids.at(i)), expected);
+    }
+
+    // events created one by one continue after the block:
+    const Event last = m_storage->makeEvent();
+    QCOMPARE(last.id(), ids.last() + 1);
+
+    QVERIFY(m_storage->deleteAllEvents());
+}
+
 void SqLiteStorageTests::setGetMetaDataTest()
 {
     const QString Key1(QStringLiteral("Key1"));
@@ -308,6 +390,241 @@ void SqLiteStorageTests::setGetMetaDataTest()
     QVERIFY(m_storage->getMetaData(Key2) == Value2);
 }
 
+void SqLiteStorageTests::statementCacheTest()
+{
+    m_storage->clearStatementCache();
+    const int hits = m_storage->statementCacheHits();
+    const int misses = m_storage->statementCacheMisses();
+
+    const QString Key(QStringLiteral("CacheKey"));
+    // look up the key, then insert it:
+    QVERIFY(m_storage->setMetaData(Key, QStringLiteral("1")));
+    QCOMPARE(m_storage->statementCacheMisses() - misses, 2);
+    QCOMPARE(m_storage->statementCacheHits() - hits, 0);
+    // look up the key, then update it:
+    QVERIFY(m_storage->setMetaData(Key, QStringLiteral("2")));
+    QCOMPARE(m_storage->statementCacheMisses() - misses, 3);
+    QCOMPARE(m_storage->statementCacheHits() - hits, 1);
+    QCOMPARE(m_storage->getMetaData(Key), QStringLiteral("2"));
+    QCOMPARE(m_storage->statementCacheHits() - hits, 2);
+
+    Event event = m_storage->makeEvent();
+    QVERIFY(event.isValid());
+    const int eventMisses = m_storage->statementCacheMisses();
+    const QDateTime start = QDateTime::currentDateTime();
+    event.setStartDateTime(start);
+    for (int i = 1; i <= 10; ++i) {
+        event.setEndDateTime(start.addSecs(i * 60));
+        QVERIFY(m_storage->modifyEvent(event));
+        QCOMPARE(m_storage->getEvent(event.id()).endDateTime(), event.endDateTime());
+    }
+    // the first modify and get prepare their statements, the rest reuses them:
+    QCOMPARE(m_storage->statementCacheMisses() - eventMisses, 2);
+    QVERIFY(m_storage->deleteEvent(event));
+
+    // a cleared cache prepares the statements again:
+    m_storage->clearStatementCache();
+    QCOMPARE(m_storage->getMetaData(Key), QStringLiteral("2"));
+    QCOMPARE(m_storage->statementCacheMisses() - eventMisses, 4);
+}
+
+void SqLiteStorageTests::durabilityProfilesTest_data()
+{
+    QTest::addColumn<int>("durability");
+    QTest::addColumn<QString>("synchronous");
+
+    QTest::newRow("safe") << int(Configuration::DatabaseDurability_Safe) << QStringLiteral("2");
+    QTest::newRow("balanced") << int(Configuration::DatabaseDurability_Balanced)
+                              << QStringLiteral("1");
+    QTest::newRow("fast") << int(Configuration::DatabaseDurability_Fast) << QStringLiteral("1");
+}
+
+void SqLiteStorageTests::durabilityProfilesTest()
+{
+    QFETCH(int, durability);
+    QFETCH(QString, synchronous);
+
+    QSqlDatabase &database = m_storage->database();
+    QVERIFY(m_storage->setDurability(static_cast<Configuration::DatabaseDurability>(durability)));
+    QCOMPARE(pragmaValue(database, QStringLiteral("journal_mode")), QStringLiteral("wal"));
+    QCOMPARE(pragmaValue(database, QStringLiteral("synchronous")), synchronous);
+
+    EventList events;
+    for (int i = 0; i < 20; ++i) {
+        Event event = m_storage->makeEvent();
+        QVERIFY(event.isValid());
+        event.setTaskId(1);
+        event.setComment(QStringLiteral("Durability test %1").arg(i));
+        QVERIFY(m_storage->modifyEvent(event));
+        events.append(event);
+    }
+    QCOMPARE(pragmaValue(database, QStringLiteral("integrity_check")), QStringLiteral("ok"));
+
+    // everything has to be there after reopening the database:
+    m_storage->clearStatementCache();
+    database.close();
+    QVERIFY(database.open());
+    QVERIFY(m_storage->setDurability(static_cast<Configuration::DatabaseDurability>(durability)));
+    QCOMPARE(pragmaValue(database, QStringLiteral("integrity_check")), QStringLiteral("ok"));
+    Q_FOREACH (const Event &event, events) {
+        QCOMPARE(m_storage->getEvent(event.id()), event);
+        QVERIFY(m_storage->deleteEvent(event));
+    }
+}
+
+void SqLiteStorageTests::durationRollupTest()
+{
+    const QDateTime start(QDate(2019, 3, 4), QTime(22, 0));
+    EventList events;
+    for (int i = 0; i < 20; ++i) {
+        Event event;
+        event.setTaskId(1 + i % 3);
+        event.setUserId(1);
+        event.setStartDateTime(start.addSecs(i * 3600));
+        event.setEndDateTime(start.addSecs(i * 3600 + 600 * (i % 4)));
+        events.append(event);
+    }
+    {
+        SqlRaiiTransactor transactor(m_storage->database());
+        QVERIFY(!m_storage->addEvents(events, transactor).isEmpty());
+        QVERIFY(transactor.commit());
+    }
+
+    const auto rollupOfAllEvents = [this]() {
+        DurationRollup rollup;
+        Q_FOREACH (const Event &event, m_storage->getAllEvents())
+            rollup.addEvent(event);
+        return rollup;
+    };
+
+    DurationRollup rollup;
+    QVERIFY(m_storage->getDurationRollup(&rollup));
+    QVERIFY(!rollup.isEmpty());
+    QVERIFY(rollup == rollupOfAllEvents());
+    QCOMPARE(rollup.cell(1, start.date()).events, 1);
+    QCOMPARE(rollup.cell(2, start.date()).seconds, 600);
+    // the third event starts after midnight:
+    QCOMPARE(rollup.cell(3, start.date()).events, 0);
+    QCOMPARE(rollup.cell(3, start.date().addDays(1)).seconds, 1200);
+
+    // the database keeps it updated:
+    Event event = m_storage->makeEvent();
+    QVERIFY(m_storage->getDurationRollup(&rollup));
+    QVERIFY(rollup == rollupOfAllEvents());
+    event.setTaskId(2);
+    event.setStartDateTime(start);
+    event.setEndDateTime(start.addSecs(60));
+    QVERIFY(m_storage->modifyEvent(event));
+    event.setTaskId(3);
+    event.setEndDateTime(start.addSecs(120));
+    QVERIFY(m_storage->modifyEvent(event));
+    QVERIFY(m_storage->getDurationRollup(&rollup));
+    QCOMPARE(rollup.cell(2, start.date()).events, 1);
+    QCOMPARE(rollup.cell(3, start.date()).seconds, 120);
+    QVERIFY(rollup == rollupOfAllEvents());
+    QVERIFY(m_storage->deleteEvent(event));
+    QVERIFY(m_storage->getDurationRollup(&rollup));
+    QVERIFY(rollup == rollupOfAllEvents());
+
+    QVERIFY(m_storage->deleteAllEvents());
+    QVERIFY(m_storage->getDurationRollup(&rollup));
+    QVERIFY(rollup.isEmpty());
+}
+
+void SqLiteStorageTests::durationRollupDaylightSavingTest()
+{
+#ifdef Q_OS_UNIX
+    const QByteArray oldTimeZone = qgetenv("TZ");
+    qputenv("TZ", "Europe/Berlin");
+    tzset();
+
+    // the clocks go from 2:00 to 3:00, one hour passes:
+    Event event = m_storage->makeEvent();
+    event.setTaskId(1);
+    event.setStartDateTime(QDateTime(QDate(2019, 3, 31), QTime(1, 30)));
+    event.setEndDateTime(QDateTime(QDate(2019, 3, 31), QTime(3, 30)));
+    const int duration = event.duration();
+    const bool modified = m_storage->modifyEvent(event);
+    DurationRollup rollup;
+    const bool loaded = m_storage->getDurationRollup(&rollup);
+    m_storage->deleteEvent(event);
+
+    if (oldTimeZone.isNull())
+        qunsetenv("TZ");
+    else
+        qputenv("TZ", oldTimeZone);
+    tzset();
+
+    if (duration != 3600)
+        QSKIP("The time zone data for Europe/Berlin is not available");
+    QVERIFY(modified);
+    QVERIFY(loaded);
+    // the storage counts the same seconds as the data model does:
+    QCOMPARE(rollup.cell(1, QDate(2019, 3, 31)).seconds, duration);
+#else
+    QSKIP("Switching the time zone is only supported on Unix");
+#endif
+}
+
+void SqLiteStorageTests::queryPlansUseIndexesTest_data()
+{
+    QTest::addColumn<QString>("statement");
+    QTest::addColumn<QString>("index");
+
+    QTest::newRow("getEvent") << QStringLiteral("SELECT * FROM Events WHERE event_id = 1;")
+                              << QStringLiteral("Events_event_id");
+    QTest::newRow("modifyEvent")
+        << QStringLiteral("UPDATE Events SET comment = 'x' WHERE event_id = 1;")
+        << QStringLiteral("Events_event_id");
+    QTest::newRow("deleteEvent") << QStringLiteral("DELETE from Events where event_id = 1;")
+                                 << QStringLiteral("Events_event_id");
+    QTest::newRow("deleteTask") << QStringLiteral("DELETE from Events where task = 1;")
+                                << QStringLiteral("Events_task");
+    QTest::newRow("timeFrame")
+        << QStringLiteral("SELECT * FROM Events WHERE start >= '2019-01-01' AND start < '2019-02-01';")
+        << QStringLiteral("Events_start");
+    QTest::newRow("report")
+        << QStringLiteral("SELECT * FROM Events WHERE report_id = 42 AND user_id = 1;")
+        << QStringLiteral("Events_report_user");
+    QTest::newRow("getAllTasks")
+        << QStringLiteral("select * from Tasks left join Subscriptions on Tasks.task_id = Subscriptions.task;")
+        << QStringLiteral("Subscriptions_task_user");
+}
+
+void SqLiteStorageTests::queryPlansUseIndexesTest()
+{
+    QFETCH(QString, statement);
+    QFETCH(QString, index);
+
+    const QString plan = queryPlan(m_storage->database(), statement);
+    QVERIFY2(plan.contains(QStringLiteral("INDEX ") + index), qPrintable(plan));
+}
+
+void SqLiteStorageTests::migrateToIndexedSchemaTest()
+{
+    const QStringList indexes = indexNames(m_storage->database());
+    QCOMPARE(indexes.size(), SqlStorage::indexStatements().size());
+
+    // turn the database back into one of the previous version:
+    Q_FOREACH (const QString &index, indexes) {
+        QSqlQuery query(m_storage->database());
+        QVERIFY(query.exec(QStringLiteral("DROP INDEX %1").arg(index)));
+    }
+    QVERIFY(m_storage->setMetaData(CHARM_DATABASE_VERSION_DESCRIPTOR,
+                                   QString::number(CHARM_DATABASE_VERSION_BEFORE_INDEXES)));
+    QVERIFY(indexNames(m_storage->database()).isEmpty());
+
+    QVERIFY(m_storage->verifyDatabase());
+    QCOMPARE(m_storage->getMetaData(CHARM_DATABASE_VERSION_DESCRIPTOR),
+             QString::number(CHARM_DATABASE_VERSION));
+    QCOMPARE(indexNames(m_storage->database()), indexes);
+
+    const QString backup = QFileInfo(m_localPath).absoluteFilePath()
+                           + QStringLiteral("-backup-version-%1").arg(CHARM_DATABASE_VERSION_BEFORE_INDEXES);
+    QVERIFY(QFile::exists(backup));
+    QVERIFY(QFile::remove(backup));
+}
+
 void SqLiteStorageTests::cleanupTestCase()
 {
     m_storage->disconnect();
@@ -56,8 +56,24 @@ private Q_SLOTS:
 
     void setGetMetaDataTest();
 
+    void statementCacheTest();
+
+    void durabilityProfilesTest_data();
+    void durabilityProfilesTest();
+
     void deleteTaskWithEventsTest();
 
+    void addEventsTest();
+
+    void durationRollupTest();
+
+    void durationRollupDaylightSavingTest();
+
+    void queryPlansUseIndexesTest_data();
+    void queryPlansUseIndexesTest();
+
+    void migrateToIndexedSchemaTest();
+
     void cleanupTestCase();
 };
 
@@ -0,0 +1,109 @@
+/*
+  TaskSearchIndexTests.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "TaskSearchIndexTests.h"
+#include "Core/TaskSearchIndex.h"
+
+#include <QtTest/QtTest>
+
+#include <algorithm>
+
+namespace {
+QList<TaskId> sorted(const QSet<TaskId> &ids)
+{
+    QList<TaskId> list = ids.toList();
+    std::sort(list.begin(), list.end());
+    return list;
+}
+}
+
+void TaskSearchIndexTests::testFind()
+{
+    TaskSearchIndex index;
+    const Task projects(1, QStringLiteral("Projects"));
+    const Task charm(2, QStringLiteral("Charm"), projects.id());
+    const Task development(3, QStringLiteral("Development"), charm.id());
+    const Task internal(40, QStringLiteral("Internal"));
+    index.setAllTasks(TaskList() << development << charm << projects << internal);
+
+    QCOMPARE(sorted(index.find(QString())), QList<TaskId>() << 1 << 2 << 3 << 40);
+    // the full name contains the names of the ancestors:
+    QCOMPARE(sorted(index.find(QStringLiteral("charm"))), QList<TaskId>() << 2 << 3);
+    QCOMPARE(sorted(index.find(QStringLiteral("PROJ dev"))), QList<TaskId>() << 3);
+    QCOMPARE(sorted(index.find(QStringLiteral("charm/dev"))), QList<TaskId>() << 3);
+    // short words and ids:
+    QCOMPARE(sorted(index.find(QStringLiteral("in"))), QList<TaskId>() << 40);
+    QCOMPARE(sorted(index.find(QStringLiteral("40"))), QList<TaskId>() << 40);
+    // narrowing down the previous query:
+    QCOMPARE(sorted(index.find(QStringLiteral("c"))), QList<TaskId>() << 1 << 2 << 3);
+    QCOMPARE(sorted(index.find(QStringLiteral("ch"))), QList<TaskId>() << 2 << 3);
+    QCOMPARE(sorted(index.find(QStringLiteral("cha"))), QList<TaskId>() << 2 << 3);
+    QCOMPARE(sorted(index.find(QStringLiteral("cha d"))), QList<TaskId>() << 3);
+    QVERIFY(index.find(QStringLiteral("charmx")).isEmpty());
+}
+
+void TaskSearchIndexTests::testIncrementalUpdates()
+{
+    TaskSearchIndex index;
+    const Task projects(1, QStringLiteral("Projects"));
+    Task charm(2, QStringLiteral("Charm"), projects.id());
+    const Task development(3, QStringLiteral("Development"), charm.id());
+    index.setAllTasks(TaskList() << projects << charm);
+    index.addTask(development);
+    QCOMPARE(sorted(index.find(QStringLiteral("charm"))), QList<TaskId>() << 2 << 3);
+
+    // renaming a task changes the full names of its descendants:
+    charm.setName(QStringLiteral("Lotsofcake"));
+    index.modifyTask(charm);
+    QVERIFY(index.find(QStringLiteral("charm")).isEmpty());
+    QCOMPARE(sorted(index.find(QStringLiteral("cake dev"))), QList<TaskId>() << 3);
+
+    // so does moving it:
+    charm.setParent(0);
+    index.modifyTask(charm);
+    QVERIFY(index.find(QStringLiteral("projects dev")).isEmpty());
+    QCOMPARE(sorted(index.find(QStringLiteral("proj"))), QList<TaskId>() << 1);
+
+    index.deleteTask(development);
+    QVERIFY(index.find(QStringLiteral("dev")).isEmpty());
+    index.clearTasks();
+    QVERIFY(index.find(QString()).isEmpty());
+}
+
+void TaskSearchIndexTests::testPaddedIds()
+{
+    TaskSearchIndex index;
+    index.setAllTasks(TaskList() << Task(42, QStringLiteral("Answer")) << Task(1042, QStringLiteral("Other")));
+    index.setIdPaddingLength(6);
+
+    // ids are found as they are displayed, and as typed without the zeros:
+    QCOMPARE(sorted(index.find(QStringLiteral("000042"))), QList<TaskId>() << 42);
+    QCOMPARE(sorted(index.find(QStringLiteral("00042"))), QList<TaskId>() << 42);
+    QCOMPARE(sorted(index.find(QStringLiteral("42"))), QList<TaskId>() << 42 << 1042);
+    QCOMPARE(sorted(index.find(QStringLiteral("001042 oth"))), QList<TaskId>() << 1042);
+
+    // changing the padding reindexes:
+    index.setIdPaddingLength(4);
+    QVERIFY(index.find(QStringLiteral("000042")).isEmpty());
+    QCOMPARE(sorted(index.find(QStringLiteral("0042"))), QList<TaskId>() << 42);
+}
+
+QTEST_MAIN(TaskSearchIndexTests)
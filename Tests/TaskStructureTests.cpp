@@ -26,6 +26,7 @@
 
 #include "Core/Task.h"
 #include "Core/TaskListMerger.h"
+#include "Core/TaskListValidator.h"
 #include "Core/CharmConstants.h"
 
 #include <QtDebug>
@@ -90,6 +91,40 @@ void TaskStructureTests::checkForTreenessTest()
     QCOMPARE(Task::checkForTreeness(tasks), directed);
 }
 
+void TaskStructureTests::validatorDiagnosticsTest()
+{
+    TaskList tasks;
+    tasks << Task(1, QStringLiteral("Top"))
+          << Task(2, QStringLiteral("Child"), 1)
+          << Task(3, QStringLiteral("Orphan"), 99)
+          << Task(4, QStringLiteral("Below the orphan"), 3)
+          << Task(5, QStringLiteral("Cycle A"), 7)
+          << Task(6, QStringLiteral("Cycle B"), 5)
+          << Task(7, QStringLiteral("Cycle C"), 6)
+          << Task(8, QStringLiteral("Below the cycle"), 6)
+          << Task(9, QStringLiteral("Self"), 9)
+          << Task(2, QStringLiteral("Duplicate"), 1)
+          << Task(2, QStringLiteral("Another duplicate"))
+          << Task();
+
+    const TaskListValidator validator(tasks);
+    QVERIFY(!validator.isValid());
+    QVERIFY(!validator.hasUniqueTaskIds());
+    QCOMPARE(validator.duplicateTaskIds(), TaskIdList() << 2);
+    QCOMPARE(validator.invalidTasks().size(), 1);
+    QCOMPARE(validator.orphanTaskIds(), TaskIdList() << 3);
+    QCOMPARE(validator.cycles().size(), 2);
+    QCOMPARE(validator.cycles().at(0), TaskIdList() << 5 << 7 << 6);
+    QCOMPARE(validator.cycles().at(1), TaskIdList() << 9);
+    QCOMPARE(validator.problemsDescription().split(QLatin1Char('\n')).size(), 5);
+
+    const TaskList tree = TaskList() << Task(2, QStringLiteral("Child"), 1)
+                                     << Task(1, QStringLiteral("Top"));
+    const TaskListValidator treeValidator(tree);
+    QVERIFY(treeValidator.isValid());
+    QVERIFY(treeValidator.problemsDescription().isEmpty());
+}
+
 void TaskStructureTests::mergeTaskListsTest_data()
 {
     QTest::addColumn<TaskList>("old");
@@ -156,4 +191,44 @@ void TaskStructureTests::mergeTaskListsTest()
     QCOMPARE(result, merged);
 }
 
+void TaskStructureTests::mergeTaskListsDeltaTest()
+{
+    const Task root(1, QStringLiteral("Root"));
+    const Task local(2, QStringLiteral("Local"), 1);
+    TaskList old;
+    old << root << local;
+
+    // the new list adds a child with a lower id than its new parent:
+    Task renamedRoot(root);
+    renamedRoot.setName(QStringLiteral("Renamed Root"));
+    const Task child(3, QStringLiteral("Child"), 4);
+    const Task parent(4, QStringLiteral("Parent"), 1);
+    TaskList newTasks;
+    newTasks << renamedRoot << child << parent;
+
+    TaskListMerger merger;
+    merger.setOldTasks(old);
+    merger.setNewTasks(newTasks);
+
+    const TaskList added = merger.addedTasks();
+    QCOMPARE(added.size(), 2);
+    QCOMPARE(added.at(0).id(), parent.id());
+    QCOMPARE(added.at(1).id(), child.id());
+
+    QCOMPARE(merger.modifiedTasks().size(), 1);
+    QCOMPARE(merger.modifiedTasks().first().name(), root.name());
+    QCOMPARE(merger.updatedTasks().size(), 1);
+    QCOMPARE(merger.updatedTasks().first().name(), renamedRoot.name());
+    QCOMPARE(merger.mergedTaskList().size(), 4);
+
+    // a new description alone is a modification, too:
+    Task described(local);
+    described.setComment(QStringLiteral("Described"));
+    TaskListMerger commentMerger;
+    commentMerger.setOldTasks(old);
+    commentMerger.setNewTasks(TaskList() << root << described);
+    QCOMPARE(commentMerger.updatedTasks().size(), 1);
+    QCOMPARE(commentMerger.updatedTasks().first().comment(), described.comment());
+}
+
 QTEST_MAIN(TaskStructureTests)
@@ -43,8 +43,12 @@ private Q_SLOTS:
     void checkForTreenessTest_data();
     void checkForTreenessTest();
 
+    void validatorDiagnosticsTest();
+
     void mergeTaskListsTest_data();
     void mergeTaskListsTest();
+
+    void mergeTaskListsDeltaTest();
 };
 
 #endif
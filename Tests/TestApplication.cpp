@@ -88,6 +88,8 @@ void TestApplication::initialize()
     m_configuration->localStorageType = CHARM_SQLITE_BACKEND_DESCRIPTOR;
     m_configuration->localStorageDatabase = m_localPath;
     m_configuration->newDatabase = true;
+    // the tests compare complete models:
+    m_configuration->eventHistoryWeeks = 0;
     m_controller = new Controller;
     // ... initialize the backend:
     QVERIFY(m_controller->initializeBackEnd(CHARM_SQLITE_BACKEND_DESCRIPTOR));
@@ -0,0 +1,159 @@
+/*
+  ViewFilterTests.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ViewFilterTests.h"
+
+#include "Charm/ViewFilter.h"
+#include "Core/CharmDataModel.h"
+#include "Core/Configuration.h"
+#include "Core/Task.h"
+
+#include <QtTest/QtTest>
+
+#include <algorithm>
+
+namespace {
+// the tasks the filter accepts, asked row by row like the proxy does:
+QList<TaskId> acceptedTasks(const ViewFilter &filter, const QModelIndex &sourceParent = QModelIndex())
+{
+    const QAbstractItemModel *source = filter.sourceModel();
+    QList<TaskId> ids;
+    for (int row = 0; row < source->rowCount(sourceParent); ++row) {
+        const QModelIndex index = source->index(row, 0, sourceParent);
+        if (filter.filterAcceptsRow(row, sourceParent))
+            ids << index.data(TasksViewRole_TaskId).toInt();
+        ids += acceptedTasks(filter, index);
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+// a new filter has no memoized match flags yet:
+QList<TaskId> acceptedTasksWithoutCache(CharmDataModel *model, const ViewFilter &filter)
+{
+    ViewFilter fresh(model);
+    fresh.setFilterRole(filter.filterRole());
+    fresh.setFilterRegExp(filter.filterRegExp());
+    return acceptedTasks(fresh);
+}
+
+void setPrefilteringMode(ViewFilter &filter, Configuration::TaskPrefilteringMode mode)
+{
+    Configuration::instance().taskPrefilteringMode = mode;
+    filter.prefilteringModeChanged();
+}
+}
+
+void ViewFilterTests::testMatchFlagsFollowChanges()
+{
+    CharmDataModel model;
+    Task testing(1120, QStringLiteral("Testing"), 1100);
+    testing.setValidUntil(QDateTime::currentDateTime().addDays(-1));
+    Task meetings(2100, QStringLiteral("Meetings"), 2000, true);
+    meetings.setValidFrom(QDateTime::currentDateTime().addDays(1));
+    model.setAllTasks(TaskList() << Task(1000, QStringLiteral("Projects"))
+                      << Task(1100, QStringLiteral("Charm"), 1000, true)
+                      << Task(1110, QStringLiteral("Development"), 1100)
+                      << testing << Task(1200, QStringLiteral("Kdab"), 1000)
+                      << Task(2000, QStringLiteral("Internal")) << meetings);
+
+    ViewFilter filter(&model);
+    setPrefilteringMode(filter, Configuration::TaskPrefilter_ShowAll);
+    filter.setFilterFixedString(QStringLiteral("dev"));
+    QCOMPARE(acceptedTasks(filter), QList<TaskId>() << 1000 << 1100 << 1110);
+
+    // renaming a task:
+    Task renamed = model.getTask(1200);
+    renamed.setName(QStringLiteral("Devops"));
+    model.modifyTask(renamed);
+    QCOMPARE(acceptedTasks(filter), QList<TaskId>() << 1000 << 1100 << 1110 << 1200);
+    QCOMPARE(acceptedTasks(filter), acceptedTasksWithoutCache(&model, filter));
+
+    // adding a task below a task that did not match:
+    model.addTask(Task(2200, QStringLiteral("Devices"), 2000));
+    QCOMPARE(acceptedTasks(filter), QList<TaskId>() << 1000 << 1100 << 1110 << 1200 << 2000 << 2200);
+    QCOMPARE(acceptedTasks(filter), acceptedTasksWithoutCache(&model, filter));
+
+    // removing the only match below a task:
+    model.deleteTask(model.getTask(1110));
+    QCOMPARE(acceptedTasks(filter), QList<TaskId>() << 1000 << 1200 << 2000 << 2200);
+    QCOMPARE(acceptedTasks(filter), acceptedTasksWithoutCache(&model, filter));
+
+    // changing the prefiltering mode:
+    filter.setFilterFixedString(QString());
+    setPrefilteringMode(filter, Configuration::TaskPrefilter_SubscribedOnly);
+    QCOMPARE(acceptedTasks(filter), QList<TaskId>() << 1000 << 1100 << 2000 << 2100);
+    QCOMPARE(acceptedTasks(filter), acceptedTasksWithoutCache(&model, filter));
+
+    // toggling subscriptions:
+    Task subscribed = model.getTask(1200);
+    subscribed.setSubscribed(true);
+    model.modifyTask(subscribed);
+    Task unsubscribed = model.getTask(2100);
+    unsubscribed.setSubscribed(false);
+    model.modifyTask(unsubscribed);
+    QCOMPARE(acceptedTasks(filter), QList<TaskId>() << 1000 << 1100 << 1200);
+    QCOMPARE(acceptedTasks(filter), acceptedTasksWithoutCache(&model, filter));
+
+    setPrefilteringMode(filter, Configuration::TaskPrefilter_CurrentOnly);
+    QCOMPARE(acceptedTasks(filter), QList<TaskId>() << 1000 << 1100 << 1200 << 2000 << 2200);
+    QCOMPARE(acceptedTasks(filter), acceptedTasksWithoutCache(&model, filter));
+
+    setPrefilteringMode(filter, Configuration::TaskPrefilter_SubscribedAndCurrentOnly);
+    QCOMPARE(acceptedTasks(filter), QList<TaskId>() << 1000 << 1100 << 1200);
+    QCOMPARE(acceptedTasks(filter), acceptedTasksWithoutCache(&model, filter));
+}
+
+void ViewFilterTests::testRenamedParentUpdatesChildren()
+{
+    CharmDataModel model;
+    model.setAllTasks(TaskList() << Task(1000, QStringLiteral("Projects"))
+                      << Task(1100, QStringLiteral("Charm"), 1000)
+                      << Task(1110, QStringLiteral("Development"), 1100)
+                      << Task(1111, QStringLiteral("Reviews"), 1110)
+                      << Task(1200, QStringLiteral("Kdab"), 1000));
+
+    // filter on the full names, as the tasks view does:
+    ViewFilter filter(&model);
+    setPrefilteringMode(filter, Configuration::TaskPrefilter_ShowAll);
+    filter.setFilterRole(TasksViewRole_Filter);
+    filter.setFilterFixedString(QStringLiteral("charm"));
+    QCOMPARE(acceptedTasks(filter), QList<TaskId>() << 1000 << 1100 << 1110 << 1111);
+
+    // the descendants only matched through the name of the renamed task:
+    Task renamed = model.getTask(1100);
+    renamed.setName(QStringLiteral("Tracker"));
+    model.modifyTask(renamed);
+    QCOMPARE(acceptedTasks(filter), QList<TaskId>());
+    QCOMPARE(acceptedTasks(filter), acceptedTasksWithoutCache(&model, filter));
+
+    renamed.setName(QStringLiteral("Charm"));
+    model.modifyTask(renamed);
+    QCOMPARE(acceptedTasks(filter), QList<TaskId>() << 1000 << 1100 << 1110 << 1111);
+    QCOMPARE(acceptedTasks(filter), acceptedTasksWithoutCache(&model, filter));
+}
+
+void ViewFilterTests::cleanupTestCase()
+{
+    Configuration::instance().taskPrefilteringMode = Configuration::TaskPrefilter_ShowAll;
+}
+
+QTEST_MAIN(ViewFilterTests)
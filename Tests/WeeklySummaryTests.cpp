@@ -0,0 +1,176 @@
+/*
+  WeeklySummaryTests.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "WeeklySummaryTests.h"
+
+#include "Charm/WeeklySummary.h"
+
+#include "Core/CharmDataModel.h"
+
+#include <QtTest/QtTest>
+
+namespace {
+const QDate Monday(2019, 3, 4);
+
+Event makeEvent(EventId id, TaskId task, const QDateTime &start, int minutes)
+{
+    Event event;
+    event.setId(id);
+    event.setTaskId(task);
+    event.setStartDateTime(start);
+    event.setEndDateTime(start.addSecs(60 * minutes));
+    return event;
+}
+
+// the summaries summed up from the events themselves, not from the duration rollup:
+QVector<WeeklySummary> expectedSummaries(const CharmDataModel &model, const TimeSpan &timespan)
+{
+    QMap<TaskId, WeeklySummary> summaries;
+    Q_FOREACH (EventId id, model.eventsThatStartInTimeFrame(timespan)) {
+        const Event event = model.eventForId(id);
+        WeeklySummary &summary = summaries[event.taskId()];
+        summary.task = event.taskId();
+        summary.taskname = model.fullTaskName(model.getTask(event.taskId()));
+        summary.durations[event.startDateTime().date().dayOfWeek() - 1] += event.duration();
+    }
+    return summaries.values().toVector();
+}
+
+void compareSummaries(const QVector<WeeklySummary> &actual, const QVector<WeeklySummary> &expected)
+{
+    QCOMPARE(actual.size(), expected.size());
+    for (int i = 0; i < actual.size(); ++i) {
+        QCOMPARE(actual[i].task, expected[i].task);
+        QCOMPARE(actual[i].taskname, expected[i].taskname);
+        QCOMPARE(actual[i].durations, expected[i].durations);
+    }
+}
+}
+
+void WeeklySummaryTests::testIncrementalUpdates()
+{
+    CharmDataModel model;
+    TaskList tasks;
+    tasks << Task(1000, QStringLiteral("Task 1")) << Task(1001, QStringLiteral("Task 1-1"), 1000)
+          << Task(2000, QStringLiteral("Task 2"));
+    model.setAllTasks(tasks);
+
+    EventList events;
+    events << makeEvent(1, 1000, QDateTime(Monday, QTime(9, 0)), 60)
+           << makeEvent(2, 1001, QDateTime(Monday.addDays(1), QTime(9, 0)), 30)
+           << makeEvent(3, 1000, QDateTime(Monday.addDays(2), QTime(9, 0)), 45)
+           // last week:
+           << makeEvent(4, 2000, QDateTime(Monday.addDays(-1), QTime(9, 0)), 15);
+    model.setAllEvents(events);
+
+    const TimeSpan week(Monday, Monday.addDays(7));
+    WeeklySummaryAggregate aggregate;
+    aggregate.reset(&model, week);
+    QCOMPARE(aggregate.summaries().size(), 2);
+    QCOMPARE(aggregate.summaries()[0].task, TaskId(1000));
+    QCOMPARE(aggregate.summaries()[0].taskname, QStringLiteral("Task 1"));
+    QCOMPARE(aggregate.summaries()[0].durations[0], 3600);
+    QCOMPARE(aggregate.summaries()[0].durations[2], 45 * 60);
+    QCOMPARE(aggregate.summaries()[1].durations[1], 30 * 60);
+
+    // the heartbeat extends an event, only its cell changes:
+    Event longer = model.eventForId(3);
+    longer.setEndDateTime(longer.endDateTime().addSecs(60));
+    model.modifyEvent(longer);
+    WeeklySummaryAggregate::Change change = aggregate.updateTask(1000);
+    QVERIFY(!change.rowsChanged);
+    QCOMPARE(change.cells, QVector<WeeklySummaryAggregate::Cell>() << WeeklySummaryAggregate::Cell(0, 2));
+    QCOMPARE(aggregate.summaries()[0].durations[2], 46 * 60);
+    compareSummaries(aggregate.summaries(), expectedSummaries(model, week));
+
+    // an unchanged task changes nothing:
+    change = aggregate.updateTask(1000);
+    QVERIFY(!change.rowsChanged);
+    QVERIFY(change.cells.isEmpty());
+
+    // moving an event to another day touches both days:
+    Event moved = model.eventForId(1);
+    moved.setStartDateTime(moved.startDateTime().addDays(3));
+    moved.setEndDateTime(moved.endDateTime().addDays(3));
+    model.modifyEvent(moved);
+    change = aggregate.updateTask(1000);
+    QVERIFY(!change.rowsChanged);
+    QCOMPARE(change.cells.size(), 2);
+    QCOMPARE(aggregate.summaries()[0].durations, QVector<int>() << 0 << 0 << 46 * 60 << 3600 << 0 << 0 << 0);
+    compareSummaries(aggregate.summaries(), expectedSummaries(model, week));
+
+    // events outside of the week are ignored:
+    model.addEvent(makeEvent(5, 2000, QDateTime(Monday.addDays(-3), QTime(9, 0)), 10));
+    change = aggregate.updateTask(2000);
+    QVERIFY(!change.rowsChanged);
+    QVERIFY(change.cells.isEmpty());
+    compareSummaries(aggregate.summaries(), expectedSummaries(model, week));
+}
+
+void WeeklySummaryTests::testRowsChanged()
+{
+    CharmDataModel model;
+    TaskList tasks;
+    tasks << Task(1000, QStringLiteral("Task 1")) << Task(2000, QStringLiteral("Task 2"));
+    model.setAllTasks(tasks);
+    model.setAllEvents(EventList() << makeEvent(1, 2000, QDateTime(Monday, QTime(9, 0)), 60));
+
+    const TimeSpan week(Monday, Monday.addDays(7));
+    WeeklySummaryAggregate aggregate;
+    aggregate.reset(&model, week);
+    QCOMPARE(aggregate.summaries().size(), 1);
+
+    // a new task is inserted in task id order, even with a just started event:
+    model.addEvent(makeEvent(2, 1000, QDateTime(Monday.addDays(4), QTime(9, 0)), 0));
+    WeeklySummaryAggregate::Change change = aggregate.updateTask(1000);
+    QVERIFY(change.rowsChanged);
+    QCOMPARE(aggregate.summaries().size(), 2);
+    QCOMPARE(aggregate.summaries()[0].task, TaskId(1000));
+    compareSummaries(aggregate.summaries(), expectedSummaries(model, week));
+
+    // moving an event to another task keeps the rows of tasks with other events:
+    model.addEvent(makeEvent(3, 2000, QDateTime(Monday.addDays(1), QTime(9, 0)), 30));
+    QCOMPARE(aggregate.updateTask(2000).cells.size(), 1);
+    Event reassigned = model.eventForId(3);
+    reassigned.setTaskId(1000);
+    model.modifyEvent(reassigned);
+    change = aggregate.updateTask(1000);
+    change.add(aggregate.updateTask(2000));
+    QVERIFY(!change.rowsChanged);
+    QCOMPARE(change.cells.size(), 2);
+    QCOMPARE(aggregate.summaries()[0].durations, QVector<int>() << 0 << 30 * 60 << 0 << 0 << 0 << 0 << 0);
+    QCOMPARE(aggregate.summaries()[1].durations, QVector<int>() << 3600 << 0 << 0 << 0 << 0 << 0 << 0);
+    compareSummaries(aggregate.summaries(), expectedSummaries(model, week));
+
+    // removing the last event of a task removes its row:
+    model.deleteEvent(model.eventForId(1));
+    change = aggregate.updateTask(2000);
+    QVERIFY(change.rowsChanged);
+    QCOMPARE(aggregate.summaries().size(), 1);
+    compareSummaries(aggregate.summaries(), expectedSummaries(model, week));
+
+    // unknown tasks are ignored:
+    change = aggregate.updateTask(42);
+    QVERIFY(!change.rowsChanged);
+    QVERIFY(change.cells.isEmpty());
+}
+
+QTEST_MAIN(WeeklySummaryTests)
@@ -138,14 +138,10 @@ void Database::initializeDatabase() throw (TimesheetProcessorException)
     }
 }
 
-void Database::addEvent(const Event &event, const SqlRaiiTransactor &t)
+void Database::addEvents(const EventList &events, const SqlRaiiTransactor &t)
 {
-    Event newEvent = m_storage.makeEvent(t);
-    int id = newEvent.id();
-    newEvent = event;
-    newEvent.setId(id);
-    if (!m_storage.modifyEvent(newEvent, t))
-        throw TimesheetProcessorException(QStringLiteral("Cannot add event"));
+    if (m_storage.addEvents(events, t).size() != events.size())
+        throw TimesheetProcessorException(QStringLiteral("Cannot add events"));
 }
 
 void Database::deleteEventsForReport(int userid, int index)
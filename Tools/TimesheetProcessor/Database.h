@@ -42,7 +42,7 @@ public:
 
     void login() throw (TimesheetProcessorException);
     void initializeDatabase() throw (TimesheetProcessorException);
-    void addEvent(const Event &event, const SqlRaiiTransactor &);
+    void addEvents(const EventList &events, const SqlRaiiTransactor &);
     void deleteEventsForReport(int userid, int index);
     void checkUserid(int id) throw (TimesheetProcessorException);
     User getOrCreateUserByName(QString name) throw (TimesheetProcessorException);
@@ -172,14 +172,14 @@ void addTimesheet(const CommandLine &cmd)
         cout << "Adding report " << index << " for user " << cmd.userid() << endl;
 
         // add the events to the database
-        Q_FOREACH (Event e, events) {
+        for (Event &e : events) {
             // check for the project code, if this does not throw an exception, the task id exists
             Task task = database.getTask(e.taskId());
             // FIXME check for reporting period for the task, not implemented in the DB
             e.setUserId(cmd.userid());
             e.setReportId(index);
-            database.addEvent(e, transaction);
         }
+        database.addEvents(events, transaction);
 
         transaction.commit();
 